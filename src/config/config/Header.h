@@ -80,6 +80,13 @@ namespace config {
     inline time_t lastSaved () const { return m_lastSaved; }
     inline const char* comment () const { return m_comment.c_str(); }
 
+    /**
+     * Returns the seed of the run that built this header, zero if unknown.
+     * Headers built from scratch take the current run seed (see
+     * data::RandomInteger::run_seed()).
+     */
+    inline size_t seed () const { return m_seed; }
+
   private:
     std::string m_author; ///< author name
     std::string m_name; ///< network name
@@ -87,6 +94,7 @@ namespace config {
     time_t m_created; ///< when it was created
     time_t m_lastSaved; ///< when it was last saved
     std::string m_comment; ///< optional comment
+    size_t m_seed; ///< the run seed, zero if unknown
   };
 
 }
@@ -7,10 +7,13 @@
  */
 
 #include "config/Header.h"
+#include "data/RandomInteger.h"
 #include "sys/util.h"
 #include "sys/debug.h"
+#include <sstream>
 
 config::Header::Header(sys::xml_ptr_const node)
+  : m_seed(0)
 {
   sys::xml_ptr_const it = sys::get_first_child(node);
   m_author = sys::get_element_string(it); 
@@ -23,7 +26,14 @@ config::Header::Header(sys::xml_ptr_const node)
   it = sys::get_next_element(it);
   m_lastSaved = sys::get_element_date(it);
   it = sys::get_next_element(it);
-  if (it) m_comment = sys::get_element_string(it);
+  if (it && sys::get_element_name(it) == "comment") {
+    m_comment = sys::get_element_string(it);
+    it = sys::get_next_element(it);
+  }
+  if (it && sys::get_element_name(it) == "seed") {
+    std::istringstream iss(sys::get_element_string(it));
+    iss >> m_seed;
+  }
   RINGER_DEBUG3("Loaded header information for network \"" << m_name
 	      << "\" version \"" << m_version << "\" from \"" 
 	      << m_author << "\" last saved on \"" 
@@ -40,7 +50,8 @@ config::Header::Header(const std::string& author,
     m_version(version),
     m_created(created),
     m_lastSaved(time(0)),
-    m_comment(comment)
+    m_comment(comment),
+    m_seed(data::RandomInteger::run_seed())
 {
   RINGER_DEBUG3("Loaded header draft information for network \"" << m_name
 	      << "\" version \"" << m_version << "\" from \"" 
@@ -54,7 +65,8 @@ config::Header::Header (const Header& other)
     m_version(other.m_version),
     m_created(other.m_created),
     m_lastSaved(time(0)),
-    m_comment(other.m_comment)
+    m_comment(other.m_comment),
+    m_seed(other.m_seed)
 {
   RINGER_DEBUG3("Built header draft information from another header \"" 
 	      << m_name << "\" version \"" << m_version << "\" from \"" 
@@ -70,6 +82,7 @@ config::Header& config::Header::operator= (const Header& other)
   m_created = other.m_created;
   m_lastSaved = time(0);
   m_comment = other.m_comment;
+  m_seed = other.m_seed;
   RINGER_DEBUG3("Copied header draft information from another header \"" 
 	      << m_name << "\" version \"" << m_version << "\" from \"" 
 	      << m_author << "\" last saved on \"" 
@@ -87,5 +100,10 @@ sys::xml_ptr config::Header::node (sys::xml_ptr any)
   sys::put_element_date(root, "lastSaved", time(0));
   if (m_comment.length()) //optional comment to insert
     sys::put_element_text(root, "comment", m_comment);
+  if (m_seed) { //the run seed, to reproduce this network
+    std::ostringstream oss;
+    oss << m_seed;
+    sys::put_element_text(root, "seed", oss.str());
+  }
   return root;
 }
@@ -31,9 +31,7 @@ config::Synapse::Synapse(sys::xml_ptr_const node)
     c = sys::get_next_element(c);
   }
   else { //select it randomly between -1 and 1
-    m_weight = static_rnd.draw(RAND_MAX);
-    m_weight -= ((double)RAND_MAX)/2;
-    m_weight /= ((double)RAND_MAX)/2;
+    m_weight = 2*static_rnd.uniform() - 1;
     RINGER_DEBUG2("Selected random initial weight for synapse " << m_id
 		<< " = " << m_weight);
   }
@@ -0,0 +1,57 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/BatchSource.h
+ *
+ * @brief Virtual base class for anything that can produce training
+ * minibatches.
+ */
+
+#ifndef DATA_BATCHSOURCE_H
+#define DATA_BATCHSOURCE_H
+
+#include "data/PatternSet.h"
+
+namespace data {
+
+  /**
+   * Produces minibatches of patterns together with their targets. Sources
+   * are used by a single thread at a time, typically the one of a
+   * data::Prefetcher, so they don't need to be thread-safe, but must not
+   * share unprotected state with other threads.
+   */
+  class BatchSource {
+
+  public:
+
+    /**
+     * Destructor virtualisation
+     */
+    virtual ~BatchSource() {}
+
+    /**
+     * Returns the size of every pattern produced
+     */
+    virtual size_t pattern_size (void) const =0;
+
+    /**
+     * Returns the size of every target produced
+     */
+    virtual size_t target_size (void) const =0;
+
+    /**
+     * Fills in the next minibatch. Both sets are reused from call to call
+     * and are only reallocated if their shape does not match.
+     *
+     * @param data Where to place the patterns
+     * @param target Where to place their targets
+     * @param n How many patterns the minibatch should have
+     */
+    virtual void next (PatternSet& data, PatternSet& target,
+		       const size_t& n) =0;
+
+  };
+
+}
+
+#endif /* DATA_BATCHSOURCE_H */
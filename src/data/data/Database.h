@@ -12,6 +12,7 @@
 #define DATA_DATABASE_H
 
 #include <string>
+#include <vector>
 #include <map>
 #include "data/Header.h"
 #include "data/PatternOperator.h"
@@ -39,8 +40,13 @@ namespace data {
      *
      * @param filename The name of the file to parse with the configuration
      * @param reporter The reporter to give to the configuration system
+     * @param attributes The names of entry attributes (e.g. "eta") to keep
+     * together with the patterns, see attribute(). Entries that lack one of
+     * them get a zero.
      */
-    Database (const std::string& filename, sys::Reporter& reporter);
+    Database (const std::string& filename, sys::Reporter& reporter,
+	      const std::vector<std::string>& attributes
+	      =std::vector<std::string>());
 
     /**
      * Builds a new database out of scratch parameters
@@ -54,7 +60,8 @@ namespace data {
 	      sys::Reporter& reporter);
 
     /**
-     * Copy constructor
+     * Copy constructor. Copying a database made by split() gives a database
+     * with data of its own.
      *
      * @param other The other database to copy data from
      */
@@ -80,6 +87,12 @@ namespace data {
      */
     inline size_t pattern_size() const { return m_patsize; }
 
+    /**
+     * Tells if my classes look at the data of another database, i.e., if I
+     * was made by split()
+     */
+    bool is_view () const;
+
     /**
      * Returns the input data set for a particular class
      *
@@ -123,6 +136,18 @@ namespace data {
      */
     void set_target (const std::map<std::string, data::Pattern*>& targets);
 
+    /**
+     * Builds a target for every one of my classes, to give to
+     * set_target(). With compressed output, each class is binary coded in
+     * the minimum number of outputs (2 classes -> 1 output), otherwise each
+     * class has its own output. Targets are -1 or +1.
+     *
+     * @param compress If the output should be compressed
+     * @param targets The resulting targets, to be deleted by the caller
+     */
+    void make_targets (const bool& compress,
+		       std::map<std::string, data::Pattern*>& targets) const;
+
     /**
      * Returns a PatternSet which express the class of each 'merged' Pattern
      * returned by merge(). 
@@ -136,33 +161,155 @@ namespace data {
      * process will calculate the number of Patterns in each class and will
      * concatenate each PatternSet (class) so each class has the same amount
      * of Pattern's.
+     *
+     * @warning This copies the patterns of the smaller classes over, so it
+     * may cost many times the memory of those classes. Prefer balance_index()
+     * or balance_weights(), which balance the classes without copies.
      */
     void normalise (void);
 
+    /**
+     * Balances the classes of this database without copying any pattern,
+     * through an oversampling index map. Indexes refer to the PatternSet
+     * returned by merge(). Every class is listed as many times as needed to
+     * reach the size of the largest class, going over its patterns in
+     * order, as normalise() does with copies (but always up to the exact
+     * size of the largest class). Give it to network::Trainer::subset() (or
+     * the equivalent calls in network::MultiStart and network::Sweep) to
+     * train and evaluate on the balanced set.
+     *
+     * @param index Where to place the indexes
+     */
+    void balance_index (std::vector<size_t>& index) const;
+
+    /**
+     * Balances the classes of a subset of this database, as the other
+     * balance_index() does for all of it, e.g. to balance every bin of
+     * bin() on its own. Every class present in the subset is listed as many
+     * times as needed to reach the size of its largest class there, going
+     * over its patterns in the subset order. Classes absent from the subset
+     * stay absent.
+     *
+     * @param subset The patterns to balance, as indexes to the PatternSet
+     * returned by merge()
+     * @param index Where to place the indexes
+     */
+    void balance_index (const std::vector<size_t>& subset,
+			std::vector<size_t>& index) const;
+
+    /**
+     * Balances the classes of this database without copying any pattern,
+     * through a weight per pattern, in the order of the PatternSet returned
+     * by merge(). Every pattern weighs the size of the largest class over
+     * the size of its own, so all classes have the same total weight. Give
+     * it to network::Trainer::weights() to weigh every pattern in the
+     * training error.
+     *
+     * @param weights Where to place the weights
+     */
+    void balance_weights (std::vector<double>& weights) const;
+
     /**
      * This will split the Database in two components: train and test data,
      * according to the proportion given by the argument (which should be
      * greater than zero and less than the unity). The <b>new</b> databases
      * for training and testing are returned to the caller.
      *
+     * Every class is split by the same proportion, so class proportions are
+     * kept on both sides. Nothing is copied: the new databases hold
+     * PatternSetView's of my classes, so many splits can be tried at the
+     * cost of their indexes only. Saving them writes their patterns out as
+     * any database. They must not outlive me, nor see me resized, and
+     * changing their patterns changes mine; copy them to get databases of
+     * their own. Attributes follow their patterns.
+     *
      * @param prop The amount (between <i>0&lt;prop&lt;1</i>) of the data that
      * will be dedicated to training. If this amount is between 0 and -1, the
      * partition happens the contrary.
      * @param train The newly created training database
      * @param test The newly created testing database
+     * @param rnd If given, the patterns of every class are drawn at random
+     * with this generator, so the split can be reproduced from its seed.
+     * Otherwise, the first patterns of every class go to one side and the
+     * others to the other side.
      *
      * @return <code>true</code> if the split was successful,
      * <code>false</code> otherwise. This method can return <code>false</code>
      * in the case the value of prop is less or equal to 0 or greater or equal
      * to 1.
      */
-    bool split (const double& prop, Database*& train, Database*& test) const;
+    bool split (const double& prop, Database*& train, Database*& test,
+		const data::RandomInteger* rnd=0) const;
+
+    /**
+     * Partitions this database in <code>k</code> folds for
+     * cross-validation, without copying any data. Indexes refer to the
+     * PatternSet returned by merge(). Every class is split in
+     * <code>k</code> contiguous blocks of (almost) the same size, and fold
+     * <i>i</i> is tested on block <i>i</i> of every class and trained on
+     * all others, so class proportions are kept in every fold. Call
+     * shuffle() before if the database order is not random and avoid
+     * normalise(), as repeated patterns could end up on both sides of a
+     * fold.
+     *
+     * @param k The number of folds, at least 2 and at most the size of the
+     * smallest class.
+     * @param train The training indexes of every fold
+     * @param test The test indexes of every fold
+     */
+    void kfold (const size_t& k,
+		std::vector<std::vector<size_t> >& train,
+		std::vector<std::vector<size_t> >& test) const;
+
+    /**
+     * Fills in a vector with one feature (column) of every pattern, in the
+     * order of the PatternSet returned by merge().
+     *
+     * @param col The feature to take
+     * @param values Where to place the values
+     */
+    void column (const size_t& col, std::vector<double>& values) const;
+
+    /**
+     * Fills in a vector with one entry attribute of every pattern, in the
+     * order of the PatternSet returned by merge(). The attribute must have
+     * been loaded at construction. Attributes are kept by copies,
+     * normalise(), shuffle(), filter() and split().
+     *
+     * @param name The attribute to take
+     * @param values Where to place the values
+     */
+    void attribute (const std::string& name,
+		    std::vector<double>& values) const;
+
+    /**
+     * Groups pattern indexes by bins of a value, such as the ones returned
+     * by column() or attribute(). Bin <i>i</i> holds the indexes of all
+     * values <i>v</i> such that <i>edges[i] &lt;= v &lt; edges[i+1]</i>.
+     * Values outside all bins are left out.
+     *
+     * @param values The value of every pattern
+     * @param edges The bin edges, in increasing order, at least two
+     * @param bins Where to place the indexes of every bin
+     */
+    static void bin (const std::vector<double>& values,
+		     const std::vector<double>& edges,
+		     std::vector<std::vector<size_t> >& bins);
 
     /**
      * This will shuffle all PatternSet's inside this database, randomly.
      */
     void shuffle ();
 
+    /**
+     * Shuffles all PatternSet's inside this database, in place, with the
+     * given generator, so the new order can be reproduced from its seed.
+     * Attributes follow their patterns.
+     *
+     * @param rnd The generator to draw the shuffle with
+     */
+    void shuffle (const data::RandomInteger& rnd);
+
     /**
      * Applies the given Operator to all Patterns in all my PatternSet
      * classes.
@@ -179,6 +326,58 @@ namespace data {
      */
     void apply_ensemble_op (const data::PatternOperator& op);
 
+    /**
+     * Keeps only the patterns whose value of a given feature is between two
+     * limits (included), in every class. Each class is tested in a single
+     * pass and compacted in another (see PatternSet::filter()). Attributes
+     * follow their patterns. Nothing is changed if a class would be left
+     * empty, in which case an exception is thrown.
+     *
+     * @param ens The feature to test
+     * @param min The lowest value accepted
+     * @param max The highest value accepted
+     */
+    void filter (const size_t& ens, const data::Feature& min,
+		 const data::Feature& max);
+
+    /**
+     * Keeps only the patterns for which a FeatureExtractor (e.g. the sum of
+     * their features, as an energy) gives a value between two limits
+     * (included), in every class, as above.
+     *
+     * @param f The quantity to test
+     * @param min The lowest value accepted
+     * @param max The highest value accepted
+     */
+    void filter (const data::FeatureExtractor& f, const data::Feature& min,
+		 const data::Feature& max);
+
+    /**
+     * Keeps only the marked features of every pattern, in every class (see
+     * PatternSet::filter_ensembles()).
+     *
+     * @param keep One entry per feature: <code>true</code> for the ones to
+     * keep
+     */
+    void filter_ensembles (const std::vector<bool>& keep);
+
+  private: //helpers
+
+    /**
+     * Builds an empty database, to be filled in by split()
+     *
+     * @param header This database header
+     * @param reporter The reporter to give to the configuration system
+     */
+    Database (const data::Header& header, sys::Reporter& reporter);
+
+    /**
+     * Keeps only the marked patterns of every class, and their attributes
+     *
+     * @param keep The patterns to keep in every class
+     */
+    void filter (const std::map<std::string, std::vector<bool> >& keep);
+
   private: //forbidden
 
     /**
@@ -191,6 +390,9 @@ namespace data {
     data::Header* m_header; ///< The header information for this database
     std::map<std::string, PatternSet*> m_data; ///< The data
     std::map<std::string, Pattern*> m_target; ///< The targets
+    /// Entry attributes, by class and then by name
+    std::map<std::string, std::map<std::string, std::vector<double> > >
+      m_attribute;
     sys::Reporter& m_reporter; ///< The system reporter for errors/warnings
     size_t m_patsize; ///< The number of feature each pattern has
 
@@ -0,0 +1,111 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/FileSource.h
+ *
+ * @brief Produces minibatches by streaming patterns from a database file.
+ */
+
+#ifndef DATA_FILESOURCE_H
+#define DATA_FILESOURCE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <libxml/xmlreader.h>
+#include "data/BatchSource.h"
+#include "data/Pattern.h"
+#include "data/PatternSet.h"
+
+namespace data {
+
+  /**
+   * Streams minibatches from an XML database file (see Database), without
+   * ever loading it in memory, so databases larger than the available
+   * memory can be used for training. Every class is read by its own
+   * streaming parser and minibatches take their patterns from the classes
+   * in turn, so classes are balanced as with Database::balance_index().
+   * The entries of a class are read in order, going back to its first
+   * entry when its last one is reached. Shuffle the database beforehand
+   * (see Database::shuffle()) if its order is not random.
+   */
+  class FileSource : public BatchSource {
+
+  public:
+
+    /**
+     * Opens the database file, once for every class to read
+     *
+     * @param filename The database file to read
+     * @param targets The classes to read and their targets, as given to
+     * Database::set_target(). The targets are copied.
+     */
+    FileSource (const std::string& filename,
+		const std::map<std::string, Pattern*>& targets);
+
+    /**
+     * Closes the database file
+     */
+    virtual ~FileSource();
+
+    /**
+     * Returns the size of every pattern produced
+     */
+    virtual size_t pattern_size (void) const { return m_buffer.size(); }
+
+    /**
+     * Returns the size of every target produced
+     */
+    virtual size_t target_size (void) const
+    { return m_target.begin()->size(); }
+
+    /**
+     * Reads the next minibatch
+     *
+     * @param data Where to place the patterns
+     * @param target Where to place their targets
+     * @param n How many patterns the minibatch should have
+     */
+    virtual void next (PatternSet& data, PatternSet& target,
+		       const size_t& n);
+
+  private: //helpers
+
+    /**
+     * (Re)opens the parser of a class, right before its first entry
+     *
+     * @param c The class
+     */
+    void open (const size_t& c);
+
+    /**
+     * Reads the features of the next entry of a class
+     *
+     * @param c The class
+     *
+     * @return <code>false</code> if the class has no more entries
+     */
+    bool read (const size_t& c);
+
+    /**
+     * Not implemented, a source cannot be copied
+     */
+    FileSource (const FileSource& other);
+    FileSource& operator= (const FileSource& other);
+
+  private: //representation
+
+    std::string m_filename; ///< the file I read from
+    std::vector<std::string> m_class; ///< the classes I read
+    std::vector<Pattern> m_target; ///< their targets
+    std::vector<xmlTextReaderPtr> m_reader; ///< their parsers
+    std::vector<size_t> m_entry; ///< the last entry read from each class
+    size_t m_next; ///< the class to read the next pattern from
+    std::vector<double> m_values; ///< the features of the last entry read
+    Pattern m_buffer; ///< the last pattern read
+
+  };
+
+}
+
+#endif /* DATA_FILESOURCE_H */
@@ -0,0 +1,84 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/MemorySource.h
+ *
+ * @brief Produces random minibatches from in-memory pattern sets.
+ */
+
+#ifndef DATA_MEMORYSOURCE_H
+#define DATA_MEMORYSOURCE_H
+
+#include <vector>
+#include "data/BatchSource.h"
+#include "data/PatternSet.h"
+#include "data/RandomInteger.h"
+
+namespace data {
+
+  /**
+   * Draws minibatches at random, with replacement, from a pattern set and
+   * its targets, exactly as network::Network::train() does with an epoch,
+   * and gathers the drawn rows into the given sets.
+   */
+  class MemorySource : public BatchSource {
+
+  public:
+
+    /**
+     * Builds a new source. The sets are not copied and must outlive me.
+     *
+     * @param data The set to draw patterns from
+     * @param target The targets of <code>data</code>
+     * @param pool If not empty, patterns are only drawn from these rows
+     * @param seed The seed for the random draws. If zero is given, a stream
+     * of the run seed is used (see RandomInteger).
+     */
+    MemorySource (const PatternSet& data, const PatternSet& target,
+		  const std::vector<size_t>& pool=std::vector<size_t>(),
+		  const size_t& seed=0);
+
+    /**
+     * Destructor virtualisation
+     */
+    virtual ~MemorySource() {}
+
+    /**
+     * Returns the size of every pattern produced
+     */
+    virtual size_t pattern_size (void) const { return m_data.pattern_size(); }
+
+    /**
+     * Returns the size of every target produced
+     */
+    virtual size_t target_size (void) const
+    { return m_target.pattern_size(); }
+
+    /**
+     * Draws the next minibatch
+     *
+     * @param data Where to place the patterns
+     * @param target Where to place their targets
+     * @param n How many patterns the minibatch should have
+     */
+    virtual void next (PatternSet& data, PatternSet& target,
+		       const size_t& n);
+
+    /**
+     * Returns my random generator, e.g. to save or restore its state
+     */
+    inline RandomInteger& random (void) { return m_rnd; }
+
+  private: //representation
+
+    const PatternSet& m_data; ///< where to draw patterns from
+    const PatternSet& m_target; ///< their targets
+    std::vector<size_t> m_pool; ///< rows to draw from, if not all
+    RandomInteger m_rnd; ///< my private generator
+    std::vector<size_t> m_pats; ///< the rows drawn for the last minibatch
+
+  };
+
+}
+
+#endif /* DATA_MEMORYSOURCE_H */
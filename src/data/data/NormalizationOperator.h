@@ -25,8 +25,13 @@ namespace data {
      * have to compute first the mean for all classes in a DB.
      *
      * @param db The database to extract the ensemble mean from
+     * @param balance If set, the classes weigh the same in the mean and
+     * standard deviation, as if the database had been normalised with
+     * Database::normalise(), but without copies (see
+     * Database::balance_weights()).
      */
-    NormalizationOperator(const data::Database& db);
+    NormalizationOperator(const data::Database& db,
+			  const bool& balance=false);
 
     /**
      * Destructor virtualisation
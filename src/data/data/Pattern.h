@@ -27,6 +27,8 @@ namespace data {
   class PatternSet; ///< forward
   class PatternOperator; ///< forward
   class FeatureExtractor; ///< forward
+  template <typename L, typename R, typename Op>
+  class PatternExpression; ///< forward
   
   /**
    * The Pattern is defined in terms of Feature's.
@@ -73,6 +75,26 @@ namespace data {
      */
     Pattern(const Pattern& other);
 
+    /**
+     * Constructs a Pattern by evaluating an arithmetic expression between
+     * Pattern's, in a single loop (see PatternExpression).
+     *
+     * @param e The expression to evaluate
+     */
+    template <typename L, typename R, typename Op>
+    Pattern(const PatternExpression<L, R, Op>& e);
+
+#if __cplusplus >= 201103L
+    /**
+     * Constructs a Pattern by taking over the memory of another one, which
+     * is left empty and can only be destroyed or assigned to. If the other
+     * Pattern is a view, I become a view of the same data.
+     *
+     * @param other The Pattern to take over
+     */
+    Pattern(Pattern&& other);
+#endif
+
     /**
      * This is just to make the destructor virtual
      */
@@ -105,6 +127,37 @@ namespace data {
      */
     virtual Pattern& operator= (const Pattern& other);
 
+#if __cplusplus >= 201103L
+    /**
+     * Takes over the memory of another Pattern, if we both own our memory,
+     * otherwise copies it as above, so views keep referring to their sets.
+     *
+     * @param other The Pattern to take over
+     */
+    Pattern& operator= (Pattern&& other);
+#endif
+
+    /**
+     * Exchanges the contents of two Pattern's. If we both own our memory,
+     * only the internal pointers are exchanged. Views exchange their data
+     * instead, so they keep referring to their sets; in this case, both
+     * Pattern's must have the same size.
+     *
+     * @param other The Pattern to exchange contents with
+     */
+    void swap (Pattern& other);
+
+    /**
+     * Evaluates an arithmetic expression between Pattern's straight into
+     * me, in a single loop and without temporaries (see
+     * PatternExpression). I'm only reallocated if my size differs from the
+     * expression's.
+     *
+     * @param e The expression to evaluate
+     */
+    template <typename L, typename R, typename Op>
+    Pattern& operator= (const PatternExpression<L, R, Op>& e);
+
     /**
      * Assigns a constant value to each of the Pattern Feature's. 
      *
@@ -213,6 +266,15 @@ namespace data {
      */
     const Feature& operator[] (const size_t& pos) const;
 
+    /**
+     * Returns a given Feature, <b>without</b> range checking. This is used
+     * to evaluate PatternExpression's.
+     *
+     * @param pos The Feature's relative position inside the Pattern.
+     */
+    inline Feature get (const size_t& pos) const
+    { return m_vector->data[pos * m_vector->stride]; }
+
     /**
      * Appends the contents of the given Pattern to myself
      *
@@ -238,72 +300,25 @@ namespace data {
      */
     friend class data::PatternSet;
 
+  private: //helpers
+
+    /**
+     * Tells if I own my memory (or have none, after being moved from)
+     */
+    bool owner (void) const { return !m_vector || m_vector->owner; }
+
   private:
     gsl_vector_view m_view; ///< an optional view that might be set
     gsl_vector* m_vector; ///< the vector component of the "view"
   };
 
   /**
-   * Adds the data::Feature's of two Pattern's.
-   *
-   * Implementation returns reference a new Pattern that is the sum
-   * of the first and the second data::Feature's. It's an error
-   * trying to sum Pattern's with different sizes. The behaviour for
-   * the moment is undefined.
-   *
-   * @param first The other operand
-   * @param second The second operand
-   */
-  Pattern operator+ (const Pattern& first, const Pattern& second);
-
-  /**
-   * Subtracts the data::Feature's of two Pattern's. 
-   *
-   * Implementation returns reference a new Pattern that is the
-   * subtraction of these by the other data::Feature's. It's an
-   * error trying to subtract Pattern's with different sizes. The
-   * behaviour for the moment is undefined. The evaluation goes like
-   * this:
-   *
-   * @f[ 
-   * result = *this - other
-   * @f]
-   *
-   * @param first The first operand
-   * @param second The second operand
-   */
-  Pattern operator- (const Pattern& first, const Pattern& second);
-
-  /**
-   * Multiplies the data::Feature's of two Pattern's.
-   *
-   * Implementation returns reference a new Pattern that is the
-   * multiplication of the input Patterns data::Feture's. It's an
-   * error trying to multiply Pattern's with different sizes. The
-   * behaviour for the moment is undefined.
-   *
-   * @param first The first operand
-   * @param second The second operand
-   */
-  Pattern operator* (const Pattern& first, const Pattern& second);
-
-  /**
-   * Divides the data::Feature's of two Pattern's.
+   * Exchanges the contents of two Pattern's, see Pattern::swap()
    *
-   * Implementation returns reference a new Pattern that is the
-   * division of the first by the second Pattern
-   * data::Feature's. It's an error trying to sum Pattern's with
-   * different sizes. The behaviour for the moment is undefined. The
-   * evaluation goes like this:
-   *
-   * @f[
-   * result = \frac{*this}{other}
-   * @f]
-   *
-   * @param first The first operand
-   * @param second The second operand
+   * @param first The first Pattern
+   * @param second The second Pattern
    */
-  Pattern operator/ (const Pattern& first, const Pattern& second); 
+  inline void swap (Pattern& first, Pattern& second) { first.swap(second); }
 
 }
 
@@ -323,5 +338,7 @@ std::ostream& operator<< (std::ostream& os, const data::Pattern& p);
  */
 sys::File& operator<< (sys::File& f, const data::Pattern& p);
 
+#include "data/PatternExpression.h"
+
 #endif //DATA_PATTERN_H
 
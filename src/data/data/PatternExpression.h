@@ -0,0 +1,190 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/PatternExpression.h
+ *
+ * @brief Declares lazily evaluated arithmetic between data::Pattern's
+ * (expression templates). This file is included by data/Pattern.h and
+ * should not be included directly.
+ */
+
+#ifndef DATA_PATTERNEXPRESSION_H
+#define DATA_PATTERNEXPRESSION_H
+
+#include "sys/Exception.h"
+
+namespace data {
+
+  /**
+   * Element-wise addition, for PatternExpression's
+   */
+  struct PatternAdd {
+    static inline Feature apply (const Feature& a, const Feature& b)
+    { return a + b; }
+  };
+
+  /**
+   * Element-wise subtraction, for PatternExpression's
+   */
+  struct PatternSub {
+    static inline Feature apply (const Feature& a, const Feature& b)
+    { return a - b; }
+  };
+
+  /**
+   * Element-wise multiplication, for PatternExpression's
+   */
+  struct PatternMul {
+    static inline Feature apply (const Feature& a, const Feature& b)
+    { return a * b; }
+  };
+
+  /**
+   * Element-wise division, for PatternExpression's
+   */
+  struct PatternDiv {
+    static inline Feature apply (const Feature& a, const Feature& b)
+    { return a / b; }
+  };
+
+  /**
+   * Tells how an operand is kept inside a PatternExpression: Pattern's are
+   * kept by reference, sub-expressions (which are temporaries) by value.
+   */
+  template <typename T> struct PatternOperand { typedef const T type; };
+  template <> struct PatternOperand<Pattern> { typedef const Pattern& type; };
+
+  /**
+   * An element-wise operation between two Pattern's or PatternExpression's
+   * that is only evaluated when assigned to a Pattern.
+   *
+   * The free operators +, -, * and / between Pattern's build these
+   * expressions instead of new Pattern's, so a chain like <code>out = (in -
+   * mean) / rms</code> is computed in a single loop, writing straight into
+   * <code>out</code>, without intermediate allocations. Features are read
+   * and written through the GSL strides, so Pattern's that are views of a
+   * PatternSet can be used on both sides. Since every Feature only depends
+   * on the Features at the same position, the assigned Pattern may also
+   * appear in the expression. Expressions refer to their Pattern operands
+   * and must not outlive them: assign them to a Pattern right away.
+   */
+  template <typename L, typename R, typename Op>
+  class PatternExpression {
+
+  public:
+
+    /**
+     * Builds the expression
+     *
+     * @param l The left operand
+     * @param r The right operand
+     */
+    PatternExpression (const L& l, const R& r)
+      : m_l(l), m_r(r)
+    {
+      if (l.size() != r.size())
+	throw RINGER_EXCEPTION("Pattern sizes differ in arithmetic");
+    }
+
+    /**
+     * Returns the size of the resulting Pattern
+     */
+    inline size_t size (void) const { return m_l.size(); }
+
+    /**
+     * Evaluates one Feature of the result, without range checking
+     *
+     * @param pos The position of the Feature
+     */
+    inline Feature get (const size_t& pos) const
+    { return Op::apply(m_l.get(pos), m_r.get(pos)); }
+
+  private: //representation
+
+    typename PatternOperand<L>::type m_l; ///< my left operand
+    typename PatternOperand<R>::type m_r; ///< my right operand
+
+  };
+
+/**
+ * Declares one arithmetic operator for all combinations of Pattern's and
+ * PatternExpression's
+ *
+ * @param SYMBOL The operator symbol
+ * @param OP The element-wise operation
+ */
+#define RINGER_PATTERN_OPERATOR(SYMBOL, OP) \
+  inline PatternExpression<Pattern, Pattern, OP> \
+  operator SYMBOL (const Pattern& l, const Pattern& r) \
+  { return PatternExpression<Pattern, Pattern, OP>(l, r); } \
+  template <typename L, typename R, typename O> \
+  inline PatternExpression<PatternExpression<L, R, O>, Pattern, OP> \
+  operator SYMBOL (const PatternExpression<L, R, O>& l, const Pattern& r) \
+  { return PatternExpression<PatternExpression<L, R, O>, Pattern, OP>(l, r); } \
+  template <typename L, typename R, typename O> \
+  inline PatternExpression<Pattern, PatternExpression<L, R, O>, OP> \
+  operator SYMBOL (const Pattern& l, const PatternExpression<L, R, O>& r) \
+  { return PatternExpression<Pattern, PatternExpression<L, R, O>, OP>(l, r); } \
+  template <typename L1, typename R1, typename O1, \
+	    typename L2, typename R2, typename O2> \
+  inline PatternExpression<PatternExpression<L1, R1, O1>, \
+			   PatternExpression<L2, R2, O2>, OP> \
+  operator SYMBOL (const PatternExpression<L1, R1, O1>& l, \
+		   const PatternExpression<L2, R2, O2>& r) \
+  { return PatternExpression<PatternExpression<L1, R1, O1>, \
+			     PatternExpression<L2, R2, O2>, OP>(l, r); }
+
+  /**
+   * Adds the data::Feature's of two Pattern's (or expressions). It's an
+   * error to add Pattern's with different sizes.
+   */
+  RINGER_PATTERN_OPERATOR(+, PatternAdd)
+
+  /**
+   * Subtracts the data::Feature's of the second Pattern (or expression)
+   * from the first. It's an error to subtract Pattern's with different
+   * sizes.
+   */
+  RINGER_PATTERN_OPERATOR(-, PatternSub)
+
+  /**
+   * Multiplies the data::Feature's of two Pattern's (or expressions). It's
+   * an error to multiply Pattern's with different sizes.
+   */
+  RINGER_PATTERN_OPERATOR(*, PatternMul)
+
+  /**
+   * Divides the data::Feature's of the first Pattern (or expression) by the
+   * second. It's an error to divide Pattern's with different sizes.
+   */
+  RINGER_PATTERN_OPERATOR(/, PatternDiv)
+
+#undef RINGER_PATTERN_OPERATOR
+
+}
+
+template <typename L, typename R, typename Op>
+data::Pattern::Pattern (const data::PatternExpression<L, R, Op>& e)
+  : m_vector(gsl_vector_alloc(e.size()))
+{
+  for (size_t i=0; i<e.size(); ++i) m_vector->data[i] = e.get(i);
+}
+
+template <typename L, typename R, typename Op>
+data::Pattern& data::Pattern::operator=
+(const data::PatternExpression<L, R, Op>& e)
+{
+  if (!m_vector || size() != e.size()) {
+    //evaluate before freeing, as the expression may refer to me
+    gsl_vector* tmp = gsl_vector_alloc(e.size());
+    for (size_t i=0; i<e.size(); ++i) tmp->data[i] = e.get(i);
+    if (m_vector && m_vector->owner) gsl_vector_free(m_vector);
+    m_vector = tmp;
+    return *this;
+  }
+  const size_t stride = m_vector->stride;
+  for (size_t i=0; i<e.size(); ++i) m_vector->data[i*stride] = e.get(i);
+  return *this;
+}
+
+#endif /* DATA_PATTERNEXPRESSION_H */
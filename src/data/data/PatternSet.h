@@ -14,6 +14,7 @@
 #include "data/Pattern.h"
 #include "data/PatternOperator.h"
 #include "data/Ensemble.h"
+#include "data/RandomInteger.h"
 #include "sys/Reporter.h"
 #include "sys/File.h"
 #include "sys/xmlutil.h"
@@ -44,9 +45,33 @@ namespace data {
    * All types developed to be used in conjunction with this class may be
    * derived types through the use of GSL's views of blocks, matrices and
    * vectors.
+   *
+   * A PatternSet may also be a <b>view</b> of another set (see
+   * PatternSetView), in which case it does not own its data: it refers to a
+   * range of Pattern's, to a list of selected Pattern's or to a range of
+   * Ensemble's of the viewed set. Views can be given to everything that
+   * reads PatternSet's, but they cannot be resized, i.e., Pattern's or
+   * Ensemble's cannot be erased from or appended to them.
+   *
+   * Feature's are normally stored Pattern by Pattern (row-major), but a
+   * PatternSet may also store them Ensemble by Ensemble (column-major), so
+   * whole Ensemble's can be read contiguously, e.g. to compute per-feature
+   * statistics. Both layouts give the same results through this interface
+   * and data is transposed, in cache-friendly tiles, whenever it is copied
+   * between sets with different layouts.
    */
   class PatternSet {
 
+  public: //types
+
+    /**
+     * How the Feature's of a PatternSet are laid out in memory
+     */
+    enum Layout { ROW_MAJOR=0, ///< each Pattern is contiguous (the default)
+		  COLUMN_MAJOR=1 ///< each Ensemble is contiguous
+    };
+    typedef enum Layout Layout;
+
   public: //construction and destruction
 
     /**
@@ -56,18 +81,30 @@ namespace data {
      * @param size The number of Patterns inside of the PatternSet.
      * @param p_size The size of each Pattern inside the PatternSet.
      * @param init An optional initialization value
+     * @param layout How to lay the Feature's out in memory
      */
     PatternSet(const size_t& size, const size_t& p_size, 
-		     const double& init=0);
+		     const double& init=0, const Layout& layout=ROW_MAJOR);
 
     /** 
      * Creates a PatternSet from another PatternSet. This is the
-     * copy constructor.
+     * copy constructor. The copy of a view owns its data. The layout of
+     * the other set is kept.
      *
      * @param other The PatternSet to be cloned.
      */
     PatternSet(const PatternSet& other);
 
+#if __cplusplus >= 201103L
+    /**
+     * Creates a PatternSet by taking over the memory of another one, which
+     * is left empty and can only be destroyed or assigned to.
+     *
+     * @param other The PatternSet to take over
+     */
+    PatternSet(PatternSet&& other);
+#endif
+
     /** 
      * Reads a PatternSet from an XML file node
      *
@@ -77,7 +114,7 @@ namespace data {
 
     /**
      * Creates a PatternSet from another PatternSet, by selecting
-     * a set of patterns of interest.
+     * a set of patterns of interest. The layout of the other set is kept.
      *
      * @param other The PatternSet to copy data from
      * @param pats The set of patterns to take from the original set.
@@ -97,6 +134,37 @@ namespace data {
      */
     virtual ~PatternSet();
 
+  protected: //views, see PatternSetView
+
+    /**
+     * Creates a PatternSet without data, to be set by view_block() or
+     * view_rows()
+     */
+    PatternSet();
+
+    /**
+     * Makes me a view of a block of another set. I don't own the data and
+     * the viewed set should not be resized or destroyed while I live.
+     *
+     * @param other The set to look at (which may be a view itself)
+     * @param start The first Pattern of <code>other</code> to look at
+     * @param count How many Pattern's to look at
+     * @param first The first Ensemble of <code>other</code> to look at
+     * @param width How many Ensemble's to look at
+     */
+    void view_block (const PatternSet& other, const size_t& start,
+		     const size_t& count, const size_t& first,
+		     const size_t& width);
+
+    /**
+     * Makes me a view of selected Pattern's of another set, as above.
+     *
+     * @param other The set to look at (which may be a view itself)
+     * @param pats The Pattern's of <code>other</code> to look at, in the
+     * order they should appear. Repetitions are allowed.
+     */
+    void view_rows (const PatternSet& other, const std::vector<size_t>& pats);
+
   public: //other interfaces
 
     /**
@@ -105,11 +173,31 @@ namespace data {
      */
     size_t size () const;
 
+    /**
+     * Tells if I am a view of another PatternSet, i.e., if I don't own my
+     * data.
+     */
+    inline bool is_view (void) const { return !owner(); }
+
     /**
      * Returns the current size of each Pattern on the set.
      */
     size_t pattern_size () const;
 
+    /**
+     * Returns how my Feature's are laid out in memory
+     */
+    inline Layout layout (void) const { return m_layout; }
+
+    /**
+     * Changes how my Feature's are laid out in memory, transposing them if
+     * required. Any spare capacity is dropped. Views cannot change their
+     * layout.
+     *
+     * @param layout The new layout
+     */
+    void set_layout (const Layout& layout);
+
     /**
      * This method returns a constant reference of the data::Pattern required,
      * checking the range of the set before returning, by value, the required
@@ -133,6 +221,21 @@ namespace data {
      */
     const Ensemble ensemble (const size_t& pos) const;
 
+    /**
+     * Gathers the data::Ensemble at position <code>pos</code>, but only for
+     * the patterns listed in <code>pats</code>, placing the result into
+     * <code>ens</code>. The features are read directly from this set's
+     * matrix, no intermediate PatternSet is built. If <code>ens</code> does
+     * not have the size of <code>pats</code>, it is resized.
+     *
+     * @param pos The ensemble (feature) position, starting from
+     * <code>0</code>
+     * @param pats The patterns to read the feature from
+     * @param ens Where to place the gathered values
+     */
+    void ensemble (const size_t& pos, const std::vector<size_t>& pats,
+		   Ensemble& ens) const;
+
     /**
      * This method sets a specific data::Pattern inside the set to a new
      * value, also given as parameter. The new data::Pattern is checked for
@@ -161,15 +264,110 @@ namespace data {
 
     /**
      * This method deletes a data::Pattern from the set. It's an error to call
-     * this method with a data::Pattern number that doesn't exist. It takes
-     * some computation time to delete() a Pattern from a set, so be sure
-     * before doing it.
+     * this method with a data::Pattern number that doesn't exist, or to
+     * delete the last Pattern of a set. The following Pattern's are moved
+     * up in place, so deleting many Pattern's this way is quadratic: use
+     * erase_patterns() instead.
      *
      * @param pos The relative position inside the set, starting from
      * <code>0</code>
      */
     void erase_pattern (const size_t& pos);
 
+    /**
+     * Deletes many data::Pattern's from the set at once, compacting the
+     * remaining ones, in order, in a single pass. No memory is reallocated.
+     * It's an error to delete all Pattern's of a set.
+     *
+     * @param mask One entry per Pattern in the set: <code>true</code> for
+     * the ones to delete
+     */
+    void erase_patterns (const std::vector<bool>& mask);
+
+    /**
+     * Deletes many data::Pattern's from the set at once, as above.
+     *
+     * @param pats The positions of the Pattern's to delete, in any order
+     */
+    void erase_patterns (const std::vector<size_t>& pats);
+
+    /**
+     * Marks the Pattern's whose value of a given Ensemble is between two
+     * limits (included), in a single pass over that Ensemble. This is
+     * contiguous in column-major sets. The result can be given to filter().
+     *
+     * @param ens The Ensemble to test
+     * @param min The lowest value accepted
+     * @param max The highest value accepted
+     * @param mask Where to put the result, one entry per Pattern in the set
+     */
+    void mask (const size_t& ens, const Feature& min, const Feature& max,
+	       std::vector<bool>& mask) const;
+
+    /**
+     * Marks the Pattern's for which a FeatureExtractor (e.g. the sum of
+     * their Feature's, as an energy) gives a value between two limits
+     * (included), in a single pass over the set.
+     *
+     * @param f The quantity to test
+     * @param min The lowest value accepted
+     * @param max The highest value accepted
+     * @param mask Where to put the result, one entry per Pattern in the set
+     */
+    void mask (const FeatureExtractor& f, const Feature& min,
+	       const Feature& max, std::vector<bool>& mask) const;
+
+    /**
+     * Keeps only the marked Pattern's of the set, compacting them, in
+     * order, in a single pass, like erase_patterns(). It's an error to keep
+     * none.
+     *
+     * @param keep One entry per Pattern in the set: <code>true</code> for
+     * the ones to keep
+     */
+    void filter (const std::vector<bool>& keep);
+
+    /**
+     * Keeps only the marked Ensemble's of the set, compacting them, in
+     * order, in a single pass. No memory is reallocated. It's an error to
+     * keep none.
+     *
+     * @param keep One entry per Ensemble in the set: <code>true</code> for
+     * the ones to keep
+     */
+    void filter_ensembles (const std::vector<bool>& keep);
+
+    /**
+     * Returns how many Pattern's this set can hold before its memory has to
+     * be reallocated. This is my size if I'm a view.
+     */
+    size_t capacity (void) const;
+
+    /**
+     * Makes sure this set can hold at least <code>n</code> Pattern's
+     * without reallocating its memory. The set size is not changed.
+     *
+     * @param n The number of Pattern's to make room for
+     */
+    void reserve (const size_t& n);
+
+    /**
+     * Appends a copy of a data::Pattern to the end of this set. The
+     * capacity grows geometrically, so appending many Pattern's one by one
+     * takes linear time.
+     *
+     * @param pat The Pattern to append, with the same size as mine
+     */
+    void append_pattern (const Pattern& pat);
+
+    /**
+     * Appends a copy of all Pattern's of another set (which may be myself)
+     * to the end of this set, with the same amortised growth as above.
+     *
+     * @param other The PatternSet to append
+     */
+    void append_set (const PatternSet& other);
+
     /**
      * This method deletes a data::Ensemble from the set. It's an error to
      * call this method with a data::Ensemble number that doesn't exist. It
@@ -194,10 +392,43 @@ namespace data {
     PatternSet* clone (const std::vector<size_t>& pats) const;
 
     /**
-     * Shuffles the order of data inside this PatternSet.
+     * Copies selected patterns of another PatternSet into this one, in
+     * order. This set is only reallocated if its shape does not match, so
+     * the same set can be reused to gather many minibatches.
+     *
+     * @param other The PatternSet to copy data from
+     * @param pats The set of patterns to take from the original set.
+     */
+    void gather (const PatternSet& other, const std::vector<size_t>& pats);
+
+    /**
+     * Shuffles the order of data inside this PatternSet, in place, with a
+     * generator shared by all sets and seeded with the time.
      */
     void shuffle (void);
 
+    /**
+     * Shuffles the order of data inside this PatternSet, in place, with the
+     * given generator, so the new order can be reproduced from its seed. If
+     * a companion set is given, such as the targets of my Pattern's, it is
+     * shuffled in the same way.
+     *
+     * @param rnd The generator to draw the shuffle with
+     * @param companion An optional set with as many Pattern's as I have, to
+     * shuffle along with me
+     */
+    void shuffle (const RandomInteger& rnd, PatternSet* companion=0);
+
+    /**
+     * Reorders my Pattern's in place, with the exchanges of a Fisher-Yates
+     * shuffle drawn by RandomInteger::shuffle(). Row-major sets exchange
+     * whole Pattern's, column-major sets go through one Ensemble at a time,
+     * so both only walk contiguous blocks of memory. Nothing is allocated.
+     *
+     * @param swaps The exchanges to do, one per Pattern
+     */
+    void shuffle (const std::vector<size_t>& swaps);
+
     /**
      * Dumps the set as a set of XML nodes
      *
@@ -246,7 +477,8 @@ namespace data {
      * This method will copy the given PatternSet Pattern's into the
      * current set, enlarging it. We check if the Pattern sizes are the same
      * previous to the copying. This method returns a reference to the current
-     * set being manipulated.
+     * set being manipulated. This is the same as append_set(), so merging
+     * many sets in a row takes linear time.
      *
      * @param other The PatternSet to be copied
      */
@@ -270,12 +502,36 @@ namespace data {
     PatternSet& operator= (const std::vector<Pattern*>& pats);
 
     /**
-     * This method defines how to copy a PatternSet.
+     * This method defines how to copy a PatternSet. If I'm a view and the
+     * shapes match, the data is copied into the viewed set, otherwise I
+     * stop being a view and get my own copy.
      *
      * @param other The PatternSet to be copied.
      */
     PatternSet& operator= (const PatternSet& other);
 
+#if __cplusplus >= 201103L
+    /**
+     * Takes over the memory of another PatternSet. Mine is handed to it, to
+     * be freed when it is destroyed. If any of us is a view, this copies as
+     * above.
+     *
+     * @param other The PatternSet to take over
+     */
+    PatternSet& operator= (PatternSet&& other);
+#endif
+
+    /**
+     * Exchanges the contents of two PatternSet's. Only the internal
+     * pointers are exchanged, nothing is copied. This is the way to hand a
+     * freshly built set over to an existing one. Views exchange their data
+     * instead, so they keep referring to their sets; in this case, both
+     * PatternSet's must have the same shape.
+     *
+     * @param other The PatternSet to exchange contents with
+     */
+    void swap (PatternSet& other);
+
     /**
      * Subtracts, from this PatternSet, the value given
      *
@@ -283,10 +539,125 @@ namespace data {
      */
     PatternSet& operator-= (const PatternSet& other);
 
+  private: //helpers
+
+    /**
+     * Tells if I own my memory (or have none, after being moved from)
+     */
+    inline bool owner (void) const { return !m_data || m_data->owner; }
+
+    /**
+     * Returns where a given Pattern is in my matrix (a row or a column,
+     * depending on my layout), which only differs from its position if I
+     * gather Pattern's of another set
+     *
+     * @param pos The position of the Pattern
+     */
+    inline size_t position (const size_t& pos) const
+    { return m_pats.empty() ? pos : m_pats[pos]; }
+
+    /**
+     * Returns a pointer to a Feature, without range checking
+     *
+     * @param pat The position of the Pattern
+     * @param ens The position of the Ensemble
+     */
+    inline Feature* feature (const size_t& pat, const size_t& ens) const
+    { return (m_layout == ROW_MAJOR)?
+	m_data->data + position(pat)*m_data->tda + ens :
+	m_data->data + ens*m_data->tda + position(pat); }
+
+    /**
+     * Returns a vector view of a Pattern, whatever my layout
+     *
+     * @param pos The position of the Pattern
+     */
+    gsl_vector_view pattern_view (const size_t& pos) const;
+
+    /**
+     * Returns a vector view of an Ensemble, whatever my layout. This cannot
+     * be used if I gather Pattern's of another set.
+     *
+     * @param pos The position of the Ensemble
+     */
+    gsl_vector_view ensemble_view (const size_t& pos) const;
+
+    /**
+     * Allocates a matrix for the given number of Pattern's, with my layout
+     *
+     * @param size The number of Pattern's
+     * @param p_size The size of each Pattern
+     */
+    gsl_matrix* allocate (const size_t& size, const size_t& p_size) const;
+
+    /**
+     * Sets how many Pattern's I have, within my capacity
+     *
+     * @param size The new number of Pattern's
+     */
+    void set_size (const size_t& size);
+
+    /**
+     * Frees my memory if I own it, or stops looking at another set if I'm a
+     * view
+     */
+    void release (void);
+
+    /**
+     * Throws if I'm a view, as views cannot be resized
+     */
+    void check_owner (void) const;
+
+    /**
+     * Copies all Pattern's of another set over mine, which must have the
+     * same shape
+     *
+     * @param other The set to copy from
+     */
+    void copy_from (const PatternSet& other);
+
+    /**
+     * Makes sure this set can hold <code>n</code> Pattern's, growing its
+     * capacity geometrically if it can't
+     *
+     * @param n The number of Pattern's to make room for
+     */
+    void grow (const size_t& n);
+
+    /**
+     * Gives this set a new shape, reusing its memory if the Pattern size
+     * does not change and the capacity is enough. Contents are undefined
+     * afterwards.
+     *
+     * @param size The new number of Pattern's
+     * @param p_size The new Pattern size
+     */
+    void reshape (const size_t& size, const size_t& p_size);
+
+    /**
+     * Copies a Pattern over another one of this set
+     *
+     * @param from The position of the Pattern to copy
+     * @param to The position to copy it to
+     */
+    void copy_pattern (const size_t& from, const size_t& to);
+
   private: //representation
-    gsl_matrix* m_data; ///< my internal data
+    gsl_matrix_view m_view; ///< an optional view that might be set
+    gsl_matrix* m_data; ///< my internal data, possibly with spare room
+    std::vector<size_t> m_pats; ///< Pattern's of m_data I hold, if gathered
+    Layout m_layout; ///< how my data is laid out in m_data
     
   };
+
+  /**
+   * Exchanges the contents of two PatternSet's, see PatternSet::swap()
+   *
+   * @param first The first PatternSet
+   * @param second The second PatternSet
+   */
+  inline void swap (PatternSet& first, PatternSet& second)
+  { first.swap(second); }
   
 }
 
@@ -0,0 +1,90 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/PatternSetView.h
+ *
+ * @brief Declares PatternSet's that look at data of other sets.
+ */
+
+#ifndef DATA_PATTERNSETVIEW_H
+#define DATA_PATTERNSETVIEW_H
+
+#include <vector>
+#include "data/PatternSet.h"
+
+namespace data {
+
+  /**
+   * A PatternSet that does not own its data, but looks at a part of another
+   * set: a range of its Pattern's, a list of selected Pattern's or a block
+   * of Pattern's and Ensemble's (e.g. to select features). Nothing is
+   * copied to build a view, so splitting, sub-sampling or masking features
+   * of a set costs no data movement. Views can be given to everything that
+   * reads PatternSet's (networks, operators, metrics...) and writing to a
+   * view writes to the viewed set. They cannot be resized, though.
+   *
+   * The viewed set should not be resized or destroyed while the view lives.
+   * Copying a view gives another view of the same data; use a PatternSet
+   * to get a copy of the data instead.
+   */
+  class PatternSetView : public PatternSet {
+
+  public:
+
+    /**
+     * Looks at a range of Pattern's of another set
+     *
+     * @param set The set to look at, which may be a view itself
+     * @param start The first Pattern of <code>set</code> to look at
+     * @param count How many Pattern's to look at
+     */
+    PatternSetView (const PatternSet& set, const size_t& start,
+		    const size_t& count);
+
+    /**
+     * Looks at selected Pattern's of another set. Gathered views can read
+     * single Pattern's and subsets of Ensemble's without copying, but whole
+     * Ensemble's are copied, as their Feature's are not evenly spaced.
+     *
+     * @param set The set to look at, which may be a view itself
+     * @param pats The Pattern's of <code>set</code> to look at, in the
+     * order they should appear
+     */
+    PatternSetView (const PatternSet& set, const std::vector<size_t>& pats);
+
+    /**
+     * Looks at a block of Pattern's and Ensemble's of another set.
+     *
+     * @param set The set to look at, which may be a view itself
+     * @param start The first Pattern of <code>set</code> to look at
+     * @param count How many Pattern's to look at
+     * @param first The first Ensemble of <code>set</code> to look at
+     * @param width How many Ensemble's to look at
+     */
+    PatternSetView (const PatternSet& set, const size_t& start,
+		    const size_t& count, const size_t& first,
+		    const size_t& width);
+
+    /**
+     * Looks at the same data as another view
+     *
+     * @param other The view to copy
+     */
+    PatternSetView (const PatternSetView& other);
+
+    /**
+     * Virtualises the destructor
+     */
+    virtual ~PatternSetView() {}
+
+    /**
+     * Copies the data of another set into the viewed one, see
+     * PatternSet::operator=()
+     */
+    using PatternSet::operator=;
+
+  };
+
+}
+
+#endif /* DATA_PATTERNSETVIEW_H */
@@ -0,0 +1,99 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/Prefetcher.h
+ *
+ * @brief Declares a background minibatch producer, so minibatch
+ * preparation overlaps with training.
+ */
+
+#ifndef DATA_PREFETCHER_H
+#define DATA_PREFETCHER_H
+
+#include <vector>
+#include <deque>
+#include <boost/thread.hpp>
+
+#include "data/BatchSource.h"
+#include "data/PatternSet.h"
+
+namespace data {
+
+  /**
+   * Prepares minibatches on a background thread while the current one is
+   * being used.
+   *
+   * The prefetcher owns <code>depth</code> pairs of buffers (two, by
+   * default: double buffering). Its thread fills every free buffer with the
+   * next minibatch of a data::BatchSource. The consumer calls next(), which
+   * hands the buffer it was using back for refilling and returns the oldest
+   * ready one, waiting only if the producer is behind. Minibatches are
+   * consumed in the order they are produced. Exceptions thrown by the
+   * source stop the producer and are reported by next().
+   */
+  class Prefetcher {
+
+  public: //interface
+
+    /**
+     * Allocates the buffers and starts the producer thread
+     *
+     * @param source Where to take minibatches from. It is only used by my
+     * thread from now on and must outlive me.
+     * @param batch How many patterns every minibatch has
+     * @param depth How many minibatches can be ready or in use at once
+     */
+    Prefetcher (BatchSource& source, const size_t& batch,
+		const size_t& depth=2);
+
+    /**
+     * Stops the producer thread and frees the buffers
+     */
+    virtual ~Prefetcher ();
+
+    /**
+     * Releases the current minibatch and makes the next one current,
+     * waiting for it if it isn't ready yet
+     *
+     * @param data Where to place a pointer to the patterns
+     * @param target Where to place a pointer to their targets
+     */
+    void next (const PatternSet*& data, const PatternSet*& target);
+
+    /**
+     * Returns how many patterns every minibatch has
+     */
+    inline size_t batch (void) const { return m_batch; }
+
+  private: //helpers
+
+    /**
+     * The producer thread body
+     */
+    void work (void);
+
+  private: //not implemented
+
+    Prefetcher (const Prefetcher& other);
+    Prefetcher& operator= (const Prefetcher& other);
+
+  private: //representation
+
+    BatchSource& m_source; ///< where minibatches come from
+    size_t m_batch; ///< patterns per minibatch
+    std::vector<PatternSet*> m_data; ///< pattern buffers
+    std::vector<PatternSet*> m_target; ///< target buffers
+    std::deque<size_t> m_free; ///< buffers waiting to be filled
+    std::deque<size_t> m_ready; ///< buffers filled, in order
+    size_t m_current; ///< the buffer in use, or the number of buffers
+    bool m_stop; ///< tells the thread to finish
+    bool m_failed; ///< if the source threw
+    boost::mutex m_mutex; ///< protects all of the above
+    boost::condition_variable m_cond; ///< signals changes on the queues
+    boost::thread m_thread; ///< the producer thread
+
+  };
+
+}
+
+#endif /* DATA_PREFETCHER_H */
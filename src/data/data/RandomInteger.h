@@ -10,10 +10,13 @@
 #define DATA_RANDOMINTEGER_H
 
 #include <cstddef>
+#include <stdint.h>
+#include <string>
 #include <vector>
+#include <algorithm>
 
 namespace data {
-  
+
   /**
    * RandomInteger's abstracts random number genearation.
    *
@@ -21,22 +24,33 @@ namespace data {
    * encapsulating a way to genearate random integers and arrays of
    * those numbers. The seed may be set either at initialisation or
    * during the existance of a RandomInteger variable.
+   *
+   * Each RandomInteger keeps its own generator state, so different objects
+   * produce independent sequences and may be used concurrently from
+   * different threads, as long as each thread uses its own object. The
+   * generator is xoshiro256**, seeded through splitmix64. It can be split in
+   * independent streams (see stream()), e.g. one per thread.
+   *
+   * Generators built without a seed are streams of a single seed for the
+   * whole run (see run_seed()), so a run can be reproduced by setting that
+   * seed at the start of a program, before any of them is used. The run
+   * seed is recorded in the networks saved by the program.
    */
   class RandomInteger {
-    
+
   public:
-    
+
     /**
      * A RandomInteger constructor.
      *
      * The only constructor initialises the random genearator.
      *
      * @param seed The seed to the random number genearator. If zero is given
-     * (the default parameter), the seed is initialized with
-     * <code>time(0)</code>, which is a second based machine counter. If you
-     * need to produce different sequences of numbers consecutively, it is
-     * recommended that you only instantiate 1 object of this class,
-     * statically.
+     * (the default parameter), this generator becomes a new stream of the
+     * run seed, when first used. Every such generator gets a different
+     * stream, in the order they are first used. Generators that have to be
+     * reproducible should therefore be first used (or split with stream())
+     * from a single thread, in a fixed order.
      */
     RandomInteger(const size_t& seed =0);
 
@@ -44,7 +58,8 @@ namespace data {
      * Returns a random integer between zero (included) and the
      * parameter value (excluded).
      *
-     * @warning If the maximum is <b>1</b>, the system always outputs 0. 
+     * @warning If the maximum is <b>1</b> or <b>0</b>, the system always
+     * outputs 0.
      *
      * @param max The maximum value that can be returned.
      */
@@ -58,18 +73,126 @@ namespace data {
      * as parameter. The number of draws will be the same as the size
      * of the container.
      *
-     * @warning If the maximum is <b>1</b>, the system always outputs 0. 
+     * @warning If the maximum is <b>1</b>, the system always outputs 0.
      *
      * @param max The maximum value that can be returned.
      * @param c   The container where to put the values drawn.
      */
     void draw (const size_t& max, std::vector<size_t>& c) const;
 
+    /**
+     * Returns a random number between zero (included) and one (excluded),
+     * with 53 random bits.
+     */
+    double uniform (void) const;
+
+    /**
+     * Draws a random permutation of as many elements as the size of the
+     * container, as the exchanges of a Fisher-Yates shuffle: every element
+     * <i>i</i>, from the last to the second, is exchanged with element
+     * <code>swaps[i]</code>, drawn between zero and <i>i</i> (included). The
+     * same draws can then shuffle, in place and in the same way, as many
+     * containers as needed (see permute() and PatternSet::shuffle()).
+     *
+     * @param swaps Where to put the exchanges drawn
+     */
+    void shuffle (std::vector<size_t>& swaps) const;
+
+    /**
+     * Shuffles a container in place, with the exchanges drawn by shuffle().
+     *
+     * @param swaps The exchanges to do, with as many entries as the container
+     * @param c The container to shuffle
+     */
+    template <typename T>
+    static void permute (const std::vector<size_t>& swaps, std::vector<T>& c)
+    { for (size_t i=c.size(); i>1; --i) std::swap(c[i-1], c[swaps[i-1]]); }
+
+    /**
+     * Returns an independent stream of this generator, which does not
+     * overlap with mine nor with the other streams for any practical
+     * sequence length (they are 2^128 draws apart). Streams depend only on
+     * my current state and on their number, so giving stream
+     * <code>i</code> to thread <code>i</code> is reproducible. I'm not
+     * changed.
+     *
+     * @param n The number of the stream
+     */
+    RandomInteger stream (const size_t& n) const;
+
+    /**
+     * Returns the seed this generator was initialised with, which is the
+     * run seed for generators built without one.
+     */
+    inline size_t seed (void) const { setup(); return m_seed; }
+
+    /**
+     * Returns the current generator state, as a single word, together with
+     * my seed. Restoring it later with state(const std::string&) resumes
+     * the exact same sequence of draws.
+     */
+    std::string state (void) const;
+
+    /**
+     * Restores a generator state previously returned by state(), and the
+     * seed it came from. States without a seed (as written by older
+     * versions) keep my seed. The all-zero state, from which the generator
+     * would only draw zeros, is rejected.
+     *
+     * @param s The state to restore
+     */
+    void state (const std::string& s);
+
+    /**
+     * Returns the seed of this run, from which all generators built without
+     * a seed take their streams. Unless set before, it is set from the
+     * time when this is first called.
+     */
+    static size_t run_seed (void);
+
+    /**
+     * Sets the seed of this run. Only generators first used after this call
+     * take their streams from it, so call it at the start of a program.
+     *
+     * @param seed The new run seed. If zero is given, a time based seed is
+     * used.
+     */
+    static void run_seed (const size_t& seed);
+
+  private: //helpers
+
+    /**
+     * Takes a new stream of the run seed, if I was built without a seed and
+     * this was not done yet
+     */
+    void setup (void) const;
+
+    /**
+     * Seeds my state
+     *
+     * @param seed The seed to use
+     */
+    void set_seed (const size_t& seed) const;
+
+    /**
+     * Returns the next 64 random bits and advances my state
+     */
+    uint64_t next (void) const;
+
+    /**
+     * Advances my state by as many draws as the given polynomial tells
+     *
+     * @param poly The jump polynomial, 2^128 or 2^192 draws
+     */
+    void jump (const uint64_t* poly) const;
+
   private:
-    size_t m_seed; ///< The seed is kept here, for debugging.
+    mutable size_t m_seed; ///< The seed is kept here, for debugging.
+    mutable uint64_t m_state[4]; ///< The generator state
+    mutable bool m_ready; ///< If my state was seeded already
 
   };
 
 }
 
-#endif //DATA_RANDOMINTEGER_H 
+#endif //DATA_RANDOMINTEGER_H
@@ -24,12 +24,14 @@ def standard(db):
     m = mean(v)
     return (1.0/(len(v)-1)) * sum([(k-m)**2.0 for k in v])
 
-  #calculates the intra-class averages
+  #calculates the intra-class averages and variances, walking each class
+  #ensemble by ensemble (i.e. transposed) instead of once per feature
   averages = []
+  variances = [] 
   for k, features in db.data.iteritems():
-    s = []
-    for i in range(db.pattern_size()): s.append(mean([f[i] for f in features]))
-    averages.append(s)
+    ensembles = zip(*features)
+    averages.append([mean(e) for e in ensembles])
+    variances.append([var(e) for e in ensembles])
 
   #calculates the overall average
   overall_average = []
@@ -37,13 +39,6 @@ def standard(db):
     overall_average.append(mean([i[k] for i in averages]))
   overall_average = tuple(overall_average)
 
-  #now we compute the overall deviation from the mean
-  variances = [] 
-  for k, features in db.data.iteritems():
-    s = []
-    for i in range(db.pattern_size()): s.append(var([f[i] for f in features]))
-    variances.append(s)
-
   #calculates the overall variance
   overall_variance = []
   factor = 1.0/(db.size()**2.0)
@@ -11,6 +11,7 @@
 #include <boost/scoped_ptr.hpp>
 #include "data/Pattern.h"
 #include "data/PatternSet.h"
+#include "data/PatternSetView.h"
 #include "data/Database.h"
 #include "data/Header.h"
 #include "data/util.h"
@@ -25,6 +26,22 @@ boost::shared_ptr<data::Pattern> make_pattern(object feat) {
   return retval;
 }
 
+data::Pattern pattern_add(const data::Pattern& a, const data::Pattern& b) {
+  return a + b;
+}
+
+data::Pattern pattern_sub(const data::Pattern& a, const data::Pattern& b) {
+  return a - b;
+}
+
+data::Pattern pattern_mul(const data::Pattern& a, const data::Pattern& b) {
+  return a * b;
+}
+
+data::Pattern pattern_div(const data::Pattern& a, const data::Pattern& b) {
+  return a / b;
+}
+
 boost::shared_ptr<data::PatternSet> create_patternset(object data) {
   std::vector<boost::shared_ptr<data::Pattern> > v; 
   std::vector<data::Pattern*> vp; 
@@ -84,6 +101,35 @@ void db_set_targets(data::Database& db, dict targets) {
   db.set_target(tmap);
 }
 
+list db_kfold(const data::Database& db, size_t k) {
+  std::vector<std::vector<size_t> > train, test;
+  db.kfold(k, train, test);
+  list retval;
+  for (size_t f=0; f<k; ++f) {
+    list tr, te;
+    for (size_t i=0; i<train[f].size(); ++i) tr.append(train[f][i]);
+    for (size_t i=0; i<test[f].size(); ++i) te.append(test[f][i]);
+    retval.append(make_tuple(tr, te));
+  }
+  return retval;
+}
+
+list db_balance_index(const data::Database& db) {
+  std::vector<size_t> index;
+  db.balance_index(index);
+  list retval;
+  for (size_t i=0; i<index.size(); ++i) retval.append(index[i]);
+  return retval;
+}
+
+list db_balance_weights(const data::Database& db) {
+  std::vector<double> weights;
+  db.balance_weights(weights);
+  list retval;
+  for (size_t i=0; i<weights.size(); ++i) retval.append(weights[i]);
+  return retval;
+}
+
 boost::shared_ptr<data::PatternSet> db_merge(const data::Database& db) {
   boost::shared_ptr<data::PatternSet> retval(new data::PatternSet(1, 1));
   db.merge(*retval.get());
@@ -96,6 +142,54 @@ boost::shared_ptr<data::PatternSet> db_merge_target (const data::Database& db) {
   return retval;
 }
 
+boost::shared_ptr<data::PatternSetView> make_patternset_view
+(const data::PatternSet& set, object pats) {
+  std::vector<size_t> v(len(pats));
+  boost::python::stl_input_iterator<size_t> it(pats);
+  for (size_t i=0; i<v.size(); ++i, ++it) v[i] = *it;
+  return boost::shared_ptr<data::PatternSetView>
+    (new data::PatternSetView(set, v));
+}
+
+/**
+ * Keeps the set a view looks at alive for as long as the view. Constructors
+ * made with make_constructor() hide the new object from the argument indexes
+ * of with_custodian_and_ward, so this looks at the whole argument tuple.
+ */
+struct view_keeps_set : default_call_policies {
+  template <class ArgumentPackage>
+  static PyObject* postcall(const ArgumentPackage& args, PyObject* result) {
+    PyObject* view = PyTuple_GET_ITEM(args.base, 0);
+    PyObject* set = PyTuple_GET_ITEM(args.base, 1);
+    if (!objects::make_nurse_and_patient(view, set)) {
+      Py_XDECREF(result);
+      return 0;
+    }
+    return result;
+  }
+};
+
+void ps_shuffle (data::PatternSet& ps, size_t seed) {
+  ps.shuffle(data::RandomInteger(seed));
+}
+
+void ps_shuffle_along (data::PatternSet& ps, data::PatternSet& companion,
+		       size_t seed) {
+  ps.shuffle(data::RandomInteger(seed), &companion);
+}
+
+void db_shuffle (data::Database& db, size_t seed) {
+  db.shuffle(data::RandomInteger(seed));
+}
+
+size_t get_run_seed () {
+  return data::RandomInteger::run_seed();
+}
+
+void set_run_seed (size_t seed) {
+  data::RandomInteger::run_seed(seed);
+}
+
 data::Feature pattern_get(const data::Pattern& p, size_t i) {
   return p[i];
 }
@@ -115,10 +209,10 @@ void bind_data_database()
     .def("__init__", make_constructor(make_pattern, default_call_policies(), (arg("features"))))
     .def("size", &data::Pattern::size, (arg("self")), "The pattern size")
     .def("__len__", &data::Pattern::size, (arg("self")), "The pattern size")
-    .def("__add__", data::operator+)
-    .def("__sub__", data::operator-)
-    .def("__mul__", data::operator*)
-    .def("__div__", data::operator/)
+    .def("__add__", &pattern_add)
+    .def("__sub__", &pattern_sub)
+    .def("__mul__", &pattern_mul)
+    .def("__div__", &pattern_div)
     .def("__iadd__", (data::Pattern& (data::Pattern::*)(const data::Feature&))&data::Pattern::operator+=, return_self<>())
     .def("__isub__", (data::Pattern& (data::Pattern::*)(const data::Feature&))&data::Pattern::operator-=, return_self<>())
     .def("__imul__", (data::Pattern& (data::Pattern::*)(const data::Feature&))&data::Pattern::operator*=, return_self<>())
@@ -131,28 +225,46 @@ void bind_data_database()
     .def("append", &data::Pattern::append, (arg("self"), arg("pattern")))
     ;
 
-  class_<data::PatternSet, boost::shared_ptr<data::PatternSet> >("PatternSet", "This class represents a set of data::Pattern's.\n\nA <b>data::Pattern set</b> is an entity that holds, virtually, any number of data::Pattern's. The set can be queried for special methods, allows random access with a reasonable speed and data::Pattern's to be inserted and removed from it. Some sort of normalisation strategies are also possible. A PatternSet can also be used to produce smaller <b>sets</b> that match a certain criteria. This class and related methods are strongly based on the GNU Scientific Library (GSL) vector/matrix/block objects. Please, refer to the GSL manual to understand better its limitations and virtudes (try at your shell <code>info gsl</code> or <code>info gsl-ref</code>).\n\n While data::Pattern's represent each event available in a PatternSet, a data::Ensemble represents a given Feature for every event in a PatternSet. Through this abstraction, it is possible to also manipulate a PatternSet with respect to its 'columns', erasing or setting them.\n\nAll types developed to be used in conjunction with this class may be derived types through the use of GSL's views of blocks, matrices and vectors.", init<const size_t&, const size_t&, optional<const data::Feature&> >((arg("set_size"), arg("pattern_size"), arg("init_value")), "Creates a brand new PatternSet"))
+  def("run_seed", &get_run_seed, "Returns the seed of this run, from which all random generators built without a seed take their streams. It is recorded in the networks saved.");
+  def("set_run_seed", &set_run_seed, (arg("seed")), "Sets the seed of this run, for the random generators first used after this call (zero gives a time based seed).");
+
+  enum_<data::PatternSet::Layout>("Layout", "How a PatternSet stores its features in memory: one pattern after the other (ROW_MAJOR) or one ensemble after the other (COLUMN_MAJOR)")
+    .value("ROW_MAJOR", data::PatternSet::ROW_MAJOR)
+    .value("COLUMN_MAJOR", data::PatternSet::COLUMN_MAJOR)
+    ;
+
+  class_<data::PatternSet, boost::shared_ptr<data::PatternSet> >("PatternSet", "This class represents a set of data::Pattern's.\n\nA <b>data::Pattern set</b> is an entity that holds, virtually, any number of data::Pattern's. The set can be queried for special methods, allows random access with a reasonable speed and data::Pattern's to be inserted and removed from it. Some sort of normalisation strategies are also possible. A PatternSet can also be used to produce smaller <b>sets</b> that match a certain criteria. This class and related methods are strongly based on the GNU Scientific Library (GSL) vector/matrix/block objects. Please, refer to the GSL manual to understand better its limitations and virtudes (try at your shell <code>info gsl</code> or <code>info gsl-ref</code>).\n\n While data::Pattern's represent each event available in a PatternSet, a data::Ensemble represents a given Feature for every event in a PatternSet. Through this abstraction, it is possible to also manipulate a PatternSet with respect to its 'columns', erasing or setting them.\n\nAll types developed to be used in conjunction with this class may be derived types through the use of GSL's views of blocks, matrices and vectors.", init<const size_t&, const size_t&, optional<const data::Feature&, const data::PatternSet::Layout&> >((arg("set_size"), arg("pattern_size"), arg("init_value"), arg("layout")), "Creates a brand new PatternSet"))
     .def("__init__", make_constructor(create_patternset, default_call_policies(), (arg("data"))))
     .def("__len__", &data::PatternSet::size, (arg("self")), "Returns the size of the set")
     .def("size", &data::PatternSet::size, (arg("self")), "Returns the size of the set")
     .def("pattern_size", &data::PatternSet::size, (arg("self")), "Returns the size of each Pattern in the set")
     .def("pattern", &data::PatternSet::pattern, (arg("self"), arg("pos")), "Returns a specific pattern from the set")
     .def("__getitem__", &data::PatternSet::pattern, (arg("self"), arg("pos")), "Returns a specific pattern from the set")
-    .def("ensemble", &data::PatternSet::ensemble, (arg("self"), arg("pos")), "Returns a specific ensemble (column) from the set")
+    .def("ensemble", (const data::Ensemble (data::PatternSet::*)(const size_t&) const)&data::PatternSet::ensemble, (arg("self"), arg("pos")), "Returns a specific ensemble (column) from the set")
     .def("set_pattern", &data::PatternSet::set_pattern, (arg("self"), arg("pos"), arg("pattern")), "Sets a particular Pattern to the given value")
     .def("__setitem__", &data::PatternSet::set_pattern, (arg("self"), arg("pos"), arg("pattern")), "Sets a particular Pattern to the given value")
     .def("set_ensemble", &data::PatternSet::set_ensemble, (arg("self"), arg("pos"), arg("pattern")), "Sets a particular Ensemble to the given value")
     .def("erase_pattern", &data::PatternSet::erase_pattern, (arg("self"), arg("pos")), "Removes a particular Pattern from the set")
     .def("erase_ensemble", &data::PatternSet::erase_pattern, (arg("self"), arg("pos")), "Removes a particular Ensemble from the set")
-    .def("shuffle", &data::PatternSet::shuffle, (arg("self")), "Shuffles the order of data inside this PatternSet.")
+    .def("shuffle", (void (data::PatternSet::*)(void))&data::PatternSet::shuffle, (arg("self")), "Shuffles the order of data inside this PatternSet, in place.")
+    .def("shuffle", &ps_shuffle, (arg("self"), arg("seed")), "Shuffles the order of data inside this PatternSet, in place, reproducibly from the given seed.")
+    .def("shuffle", &ps_shuffle_along, (arg("self"), arg("companion"), arg("seed")), "Shuffles the order of data inside this PatternSet and, in the same way, inside a companion set of the same size (e.g. the targets of its patterns), in place and reproducibly from the given seed.")
     .def("merge", &data::PatternSet::merge, (arg("self")), "This method will copy the given PatternSet Pattern's into the current set, enlarging it. We check if the Pattern sizes are the same previous to the copying. This method returns a reference to the current set being manipulated.", return_self<>()) 
     .def("__isub__", &data::PatternSet::operator-=, return_self<>())
+    .def("is_view", &data::PatternSet::is_view, (arg("self")), "Tells if this set looks at the data of another set, instead of owning its own")
+    .def("layout", &data::PatternSet::layout, (arg("self")), "Tells how this set stores its features in memory")
+    .def("set_layout", &data::PatternSet::set_layout, (arg("self"), arg("layout")), "Rearranges this set's features in memory, with the given layout. The contents of the set are not changed.")
     .def("mean_square", &data::mean_square, (arg("self")), "Calculates the Mean Square (MS) of this PatternSet, taking in consideration both of its dimensions. The formulae for this calculation is given by:\n\\frac{{\\sum_i}^M{{\\sum_j}^N{{e_{ij}}^{2}}}}{M \\times N}\n Where <b>M</b> describes the number of patterns the set contains and <b>N</b>, the number of ensembles there is.")
     .def("root_mean_square", &data::root_mean_square, (arg("self")), "This is simply the sqrt(mean_square(self)). Read the help of `mean_square` to understand what it is.")
     .def("abs_mean", &data::abs_mean, (arg("self")), "Calculates the mean of a sum of absolute values of this PatternSet, taking in consideration both of its dimensions. The formula for this calculation is given by:\nE = \\frac{{\\sum_i}^M{{\\sum_j}^N{{|e_{ij}|}}}}{M \\times N}\nWhere <b>M</b> describes the number of patterns the set contains and <b>N</b>, the number of ensembles there is.")
     .def("mse", &data::mse, (arg("self"), arg("target")), "Calculates the Mean-Square Root Error for a certain classifier output, given its target values.")
     ;
 
+  class_<data::PatternSetView, boost::shared_ptr<data::PatternSetView>, bases<data::PatternSet> >("PatternSetView", "A PatternSet that does not own its data, but looks at a part of another set: a range of its patterns, a list of selected patterns or a block of patterns and ensembles (e.g. to select features). Nothing is copied to build a view and writing to a view writes to the viewed set. Views cannot be resized.", init<const data::PatternSet&, const size_t&, const size_t&>((arg("set"), arg("start"), arg("count")), "Looks at a range of patterns of another set")[with_custodian_and_ward<1, 2>()])
+    .def(init<const data::PatternSet&, const size_t&, const size_t&, const size_t&, const size_t&>((arg("set"), arg("start"), arg("count"), arg("first"), arg("width")), "Looks at a block of patterns and ensembles of another set")[with_custodian_and_ward<1, 2>()])
+    .def("__init__", make_constructor(make_patternset_view, view_keeps_set(), (arg("set"), arg("patterns"))), "Looks at selected patterns of another set")
+    ;
+
   class_<data::Database, boost::shared_ptr<data::Database> >("LegacyDatabase", "Loads a database in memory. The database file consists of a header description and a set of entries each of which, contains one or more data sets classified.", init<const std::string&, sys::Reporter&>((arg("filename"), arg("reporter"))))
     .def("__init__", make_constructor(create_database, default_call_policies(), (arg("header"), arg("data"), arg("reporter"))))
     .def("header", &data::Database::header, (arg("self")), "Returns the DB header", return_internal_reference<>())
@@ -166,6 +278,10 @@ void bind_data_database()
     .def("merge", &db_merge, (arg("self")), "Merges the whole database into a single PatternSet.")
     .def("merge_target", &db_merge_target, (arg("self")), "Returns a PatternSet which express the class of each 'merged' Pattern returned by merge().")
     .def("normalise", &data::Database::normalise, (arg("self")), "Normalises the database contents with respect to its classes. This process will calculate the number of Patterns in each class and will concatenate each PatternSet (class) so each class has the same amount of Pattern's.")
-    .def("shuffle", &data::Database::shuffle, (arg("self")), "This will shuffle all PatternSet's inside this database, randomly.")
+    .def("balance_index", &db_balance_index, (arg("self")), "Balances the classes without copies: returns a list of indexes into the PatternSet returned by merge(), in which every class is repeated up to the size of the largest one.")
+    .def("balance_weights", &db_balance_weights, (arg("self")), "Balances the classes without copies: returns a weight for every pattern of the PatternSet returned by merge(), so all classes have the same total weight.")
+    .def("shuffle", (void (data::Database::*)())&data::Database::shuffle, (arg("self")), "This will shuffle all PatternSet's inside this database, randomly.")
+    .def("shuffle", &db_shuffle, (arg("self"), arg("seed")), "Shuffles all PatternSet's inside this database, in place, reproducibly from the given seed.")
+    .def("kfold", &db_kfold, (arg("self"), arg("k")), "Partitions this database in k folds for cross-validation, stratified by class, without copying any data. Returns a list of k (train, test) tuples of pattern indexes into the PatternSet returned by merge().")
 		;
 }
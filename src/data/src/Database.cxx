@@ -6,11 +6,17 @@
  * Implements the database readout and saving.
  */
 #include "data/Database.h"
+#include "data/PatternSetView.h"
+#include "data/RandomInteger.h"
+#include <algorithm>
+#include <cmath>
 
 data::Database::Database (const std::string& filename, 
-				sys::Reporter& reporter)
+				sys::Reporter& reporter,
+				const std::vector<std::string>& attributes)
   : m_header(0),
     m_data(),
+    m_attribute(),
     m_reporter(reporter),
     m_patsize(0)
 {
@@ -52,6 +58,14 @@ data::Database::Database (const std::string& filename,
     //Instantiates a simple data::PatternSet, which is the most reasonable
     //assumption I can have in the lack of more information
     m_data[name] = new data::PatternSet(jt);
+    for (size_t i=0; i<attributes.size(); ++i) {
+      std::vector<double>& values = m_attribute[name][attributes[i]];
+      for (sys::xml_ptr_const et=sys::get_first_child(jt); et;
+	   et=sys::get_next_element(et)) {
+	if (!sys::is_element(et)) continue;
+	values.push_back(sys::get_attribute_double(et, attributes[i]));
+      }
+    }
     RINGER_REPORT(m_reporter, "Database class \"" << name << "\" has "
 		  << m_data[name]->size() << " entries.");
   }
@@ -108,6 +122,7 @@ data::Database::Database (const data::Header* header,
 				sys::Reporter& reporter)
   : m_header(0),
     m_data(),
+    m_attribute(),
     m_reporter(reporter),
     m_patsize(0)
 {
@@ -143,6 +158,7 @@ data::Database::Database (const data::Header* header,
 data::Database::Database (const Database& other)
   : m_header(0),
     m_data(),
+    m_attribute(other.m_attribute),
     m_reporter(other.m_reporter),
     m_patsize(0)
 {
@@ -175,6 +191,18 @@ data::Database::Database (const Database& other)
   RINGER_DEBUG3("Database created from copy.");
 }
 
+data::Database::Database (const data::Header& header,
+			  sys::Reporter& reporter)
+  : m_header(0),
+    m_data(),
+    m_attribute(),
+    m_reporter(reporter),
+    m_patsize(0)
+{
+  m_header = new data::Header(header);
+  RINGER_DEBUG3("Empty database created.");
+}
+
 data::Database::~Database() 
 {
   delete m_header;
@@ -192,6 +220,14 @@ void data::Database::class_names (std::vector<std::string>& cn) const
     cn.push_back(it->first);
 }
 
+bool data::Database::is_view () const
+{
+  for (std::map<std::string, data::PatternSet*>::const_iterator 
+	 it = m_data.begin(); it != m_data.end(); ++it) 
+    if (it->second->is_view()) return true;
+  return false;
+}
+
 bool data::Database::save (const std::string& filename)
 {
   RINGER_DEBUG2("Trying to save database at \"" << filename << "\".");
@@ -223,14 +259,37 @@ bool data::Database::save (const std::string& filename)
 
 void data::Database::merge (data::PatternSet& dest) const
 {
+  size_t total = 0;
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+        it = m_data.begin(); it != m_data.end(); ++it) 
+    total += it->second->size();
   bool init = false;
   for (std::map<std::string, data::PatternSet*>::const_iterator
         it = m_data.begin(); it != m_data.end(); ++it) {
     if (!init) {
       dest = *it->second;
+      dest.reserve(total); //so every class is appended in place
       init = true;
     }
-    else dest.merge(*it->second);
+    else dest.append_set(*it->second);
+  }
+}
+
+void data::Database::make_targets (const bool& compress,
+				   std::map<std::string, data::Pattern*>&
+				   targets) const
+{
+  std::vector<std::string> cnames;
+  class_names(cnames);
+  size_t nout = cnames.size();
+  if (compress) nout = lrint(std::ceil(log2(cnames.size())));
+  for (size_t i=0; i<cnames.size(); ++i) {
+    data::Pattern* t = new data::Pattern(nout, -1);
+    if (compress) {
+      for (size_t j=0; j<nout; ++j) if (i & (1<<j)) (*t)[j] = +1;
+    }
+    else (*t)[i] = +1;
+    targets[cnames[i]] = t;
   }
 }
 
@@ -311,13 +370,54 @@ void data::Database::normalise (void) {
       }
     }
   }
+
+  //grown classes are made of repetitions of their original patterns
+  for (std::map<std::string, std::map<std::string, std::vector<double> > >
+	 ::iterator it = m_attribute.begin(); it != m_attribute.end(); ++it) {
+    const size_t size = m_data[it->first]->size();
+    for (std::map<std::string, std::vector<double> >::iterator
+	   jt = it->second.begin(); jt != it->second.end(); ++jt) {
+      const size_t n = jt->second.size();
+      for (size_t i=n; i<size; ++i) jt->second.push_back(jt->second[i%n]);
+    }
+  }
+}
+
+/**
+ * Gathers the values of selected patterns
+ *
+ * @param values The value of every pattern
+ * @param pats The patterns to take
+ * @param dest Where to place their values
+ */
+static void gather (const std::vector<double>& values,
+		    const std::vector<size_t>& pats,
+		    std::vector<double>& dest)
+{
+  dest.resize(pats.size());
+  for (size_t i=0; i<pats.size(); ++i) dest[i] = values[pats[i]];
 }
 
-bool data::Database::split (const double& prop, Database*& train, Database*& test) const
+bool data::Database::split (const double& prop, Database*& train,
+			    Database*& test, const data::RandomInteger* rnd)
+  const
 {
   if (prop <= -1 || prop >= 1) return false;
   double prop_use = std::fabs(prop);
-  RINGER_DEBUG2("Splitting database by " << prop_use*100 << "%.");
+  RINGER_DEBUG2("Splitting database by " << prop_use*100 << "%"
+		<< (rnd? ", at random." : "."));
+  //checks every class before building anything
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    const size_t size = it->second->size();
+    size_t first_part = lrint(size * prop_use);
+    if (!first_part || first_part == size) {
+      RINGER_DEBUG1("Splitting class \"" << it->first << "\" ("
+		    << size << " patterns) by " << prop_use*100
+		    << "% would leave one side empty. Exception thrown.");
+      throw RINGER_EXCEPTION("Split would leave a class empty");
+    }
+  }
   std::string name = m_header->name();
   data::Header train_header(m_header->author(), name + " (TRAIN)",
 			    m_header->version(), m_header->created(),
@@ -325,49 +425,172 @@ bool data::Database::split (const double& prop, Database*& train, Database*& tes
   data::Header test_header(m_header->author(), name + " (TEST)",
 			   m_header->version(), m_header->created(),
 			   m_header->comment());
-  std::map<std::string, data::PatternSet*> train_data;
-  std::map<std::string, data::PatternSet*> test_data;
+  train = new data::Database(train_header, m_reporter);
+  test = new data::Database(test_header, m_reporter);
+  train->m_patsize = test->m_patsize = m_patsize;
+  data::Database* first = (prop > 0)? train : test;
+  data::Database* second = (prop > 0)? test : train;
   for (std::map<std::string, data::PatternSet*>::const_iterator
 	 it = m_data.begin(); it != m_data.end(); ++it) {
-    size_t first_part = lrint(it->second->size() * prop_use);
+    const size_t size = it->second->size();
+    size_t first_part = lrint(size * prop_use);
     RINGER_DEBUG2("PatternSet for class \"" << it->first << "\" will provide "
 		  << first_part << " patterns and "
-		  << it->second->size() - first_part << " patterns.");
-    std::vector<size_t> patnumber(first_part);
-    if (prop > 0)
-      for (size_t i=0; i<first_part; ++i) patnumber[i] = i;
-    else {
-      patnumber.resize(it->second->size() - first_part);
-      for (size_t i=first_part; i<it->second->size(); ++i)
-	patnumber[i-first_part] = i;
+		  << size - first_part << " patterns.");
+    std::vector<size_t> pats(size);
+    for (size_t i=0; i<size; ++i) pats[i] = i;
+    if (rnd) {
+      std::vector<size_t> swaps(size);
+      rnd->shuffle(swaps);
+      data::RandomInteger::permute(swaps, pats);
+      //both sides are read in order, which is kinder to the memory
+      std::sort(pats.begin(), pats.begin() + first_part);
+      std::sort(pats.begin() + first_part, pats.end());
+    }
+    std::vector<size_t> head(pats.begin(), pats.begin() + first_part);
+    std::vector<size_t> tail(pats.begin() + first_part, pats.end());
+    if (rnd) {
+      first->m_data[it->first] = new data::PatternSetView(*it->second, head);
+      second->m_data[it->first] = new data::PatternSetView(*it->second, tail);
     }
-    train_data[it->first] = new data::PatternSet(*it->second, patnumber);
-    if (prop > 0) {
-      patnumber.resize(it->second->size() - first_part);
-      for (size_t i=first_part; i<it->second->size(); ++i)
-	patnumber[i-first_part] = i;
+    else { //plain ranges are cheaper to read
+      first->m_data[it->first] = 
+	new data::PatternSetView(*it->second, 0, first_part);
+      second->m_data[it->first] = 
+	new data::PatternSetView(*it->second, first_part, size - first_part);
     }
-    else {
-      patnumber.resize(first_part);
-      for (size_t i=0; i<first_part; ++i) patnumber[i] = i;
+    //attributes follow their patterns
+    std::map<std::string, std::map<std::string, std::vector<double> > >::
+      const_iterator attr = m_attribute.find(it->first);
+    if (attr == m_attribute.end()) continue;
+    for (std::map<std::string, std::vector<double> >::const_iterator
+	   jt = attr->second.begin(); jt != attr->second.end(); ++jt) {
+      gather(jt->second, head, first->m_attribute[it->first][jt->first]);
+      gather(jt->second, tail, second->m_attribute[it->first][jt->first]);
     }
-    test_data[it->first] = new data::PatternSet(*it->second, patnumber);
   }
-  train = new data::Database(&train_header, train_data, m_reporter);
-  for (std::map<std::string, data::PatternSet*>::iterator
-	 it = train_data.begin(); it != train_data.end(); ++it) 
-    delete it->second;
-  test = new data::Database(&test_header, test_data, m_reporter);
-  for (std::map<std::string, data::PatternSet*>::iterator
-	 it = test_data.begin(); it != test_data.end(); ++it) 
-    delete it->second;
   return true;
 }
 
+void data::Database::kfold (const size_t& k,
+			    std::vector<std::vector<size_t> >& train,
+			    std::vector<std::vector<size_t> >& test) const
+{
+  if (k < 2) {
+    RINGER_DEBUG1("Cannot partition a database in " << k << " folds."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("K-fold partition needs at least 2 folds");
+  }
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    if (it->second->size() < k) {
+      RINGER_DEBUG1("Class \"" << it->first << "\" has only "
+		    << it->second->size() << " patterns, not enough for "
+		    << k << " folds. Exception thrown.");
+      throw RINGER_EXCEPTION("Class too small for k-fold partition");
+    }
+  }
+  train.assign(k, std::vector<size_t>());
+  test.assign(k, std::vector<size_t>());
+  size_t offset = 0; //where the current class starts, after merge()
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    const size_t n = it->second->size();
+    for (size_t f=0; f<k; ++f) {
+      const size_t begin = (n*f)/k;
+      const size_t end = (n*(f+1))/k;
+      for (size_t i=0; i<n; ++i) {
+	if (i >= begin && i < end) test[f].push_back(offset+i);
+	else train[f].push_back(offset+i);
+      }
+    }
+    RINGER_DEBUG2("Class \"" << it->first << "\" contributes about "
+		  << n/k << " patterns to every test fold.");
+    offset += n;
+  }
+}
+
 void data::Database::shuffle ()
 {
+  static data::RandomInteger rnd;
+  shuffle(rnd);
+}
+
+void data::Database::shuffle (const data::RandomInteger& rnd)
+{
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    std::vector<size_t> swaps(it->second->size());
+    rnd.shuffle(swaps);
+    it->second->shuffle(swaps);
+    //attributes follow their patterns
+    std::map<std::string, std::map<std::string, std::vector<double> > >::
+      iterator attr = m_attribute.find(it->first);
+    if (attr == m_attribute.end()) continue;
+    for (std::map<std::string, std::vector<double> >::iterator
+	   jt = attr->second.begin(); jt != attr->second.end(); ++jt)
+      data::RandomInteger::permute(swaps, jt->second);
+  }
+}
+
+void data::Database::column (const size_t& col,
+			     std::vector<double>& values) const
+{
+  if (col >= m_patsize) {
+    RINGER_DEBUG1("Cannot take feature " << col << " of patterns with "
+		  << m_patsize << " features. Exception thrown.");
+    throw RINGER_EXCEPTION("Column out of range");
+  }
+  values.clear();
   for (std::map<std::string, data::PatternSet*>::const_iterator
-	 it = m_data.begin(); it != m_data.end(); ++it) it->second->shuffle();
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    const data::Ensemble e = it->second->ensemble(col);
+    for (size_t i=0; i<e.size(); ++i) values.push_back(e[i]);
+  }
+}
+
+void data::Database::attribute (const std::string& name,
+				std::vector<double>& values) const
+{
+  values.clear();
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    std::map<std::string, std::map<std::string, std::vector<double> > >
+      ::const_iterator ct = m_attribute.find(it->first);
+    std::map<std::string, std::vector<double> >::const_iterator at;
+    if (ct == m_attribute.end() ||
+	(at = ct->second.find(name)) == ct->second.end()) {
+      RINGER_DEBUG1("Attribute \"" << name << "\" was not loaded for class"
+		    << " \"" << it->first << "\". Exception thrown.");
+      throw RINGER_EXCEPTION("Attribute not loaded");
+    }
+    values.insert(values.end(), at->second.begin(), at->second.end());
+  }
+}
+
+void data::Database::bin (const std::vector<double>& values,
+			  const std::vector<double>& edges,
+			  std::vector<std::vector<size_t> >& bins)
+{
+  if (edges.size() < 2) {
+    RINGER_DEBUG1("Binning needs at least 2 edges. Exception thrown.");
+    throw RINGER_EXCEPTION("Not enough bin edges");
+  }
+  for (size_t i=1; i<edges.size(); ++i) {
+    if (edges[i] <= edges[i-1]) {
+      RINGER_DEBUG1("Bin edges must be in increasing order. Exception"
+		    << " thrown.");
+      throw RINGER_EXCEPTION("Bin edges are not increasing");
+    }
+  }
+  bins.assign(edges.size()-1, std::vector<size_t>());
+  for (size_t i=0; i<values.size(); ++i) {
+    if (values[i] < edges.front() || values[i] >= edges.back()) continue;
+    //first edge above the value closes its bin
+    size_t b = std::upper_bound(edges.begin(), edges.end(), values[i]) -
+      edges.begin() - 1;
+    bins[b].push_back(i);
+  }
 }
 
 void data::Database::apply_pattern_op (const data::PatternOperator& op)
@@ -384,6 +607,153 @@ void data::Database::apply_ensemble_op (const data::PatternOperator& op)
     it->second->apply_ensemble_op(op);
 }
 
+void data::Database::filter (const size_t& ens, const data::Feature& min,
+			     const data::Feature& max)
+{
+  std::map<std::string, std::vector<bool> > keep;
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it)
+    it->second->mask(ens, min, max, keep[it->first]);
+  filter(keep);
+}
+
+void data::Database::filter (const data::FeatureExtractor& f,
+			     const data::Feature& min,
+			     const data::Feature& max)
+{
+  std::map<std::string, std::vector<bool> > keep;
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it)
+    it->second->mask(f, min, max, keep[it->first]);
+  filter(keep);
+}
+
+void data::Database::filter
+(const std::map<std::string, std::vector<bool> >& keep)
+{
+  //checks every class before changing any
+  for (std::map<std::string, std::vector<bool> >::const_iterator
+	 it = keep.begin(); it != keep.end(); ++it) {
+    if (std::find(it->second.begin(), it->second.end(), true) ==
+	it->second.end()) {
+      RINGER_DEBUG1("Filtering would leave class \"" << it->first
+		    << "\" empty. Exception thrown.");
+      throw RINGER_EXCEPTION("Filter would leave a class empty");
+    }
+  }
+  for (std::map<std::string, std::vector<bool> >::const_iterator
+	 it = keep.begin(); it != keep.end(); ++it) {
+    const std::vector<bool>& k = it->second;
+    m_data[it->first]->filter(k);
+    RINGER_DEBUG2("Class \"" << it->first << "\" keeps "
+		  << m_data[it->first]->size() << " of " << k.size()
+		  << " patterns.");
+    //attributes follow their patterns
+    std::map<std::string, std::map<std::string, std::vector<double> > >::
+      iterator attr = m_attribute.find(it->first);
+    if (attr == m_attribute.end()) continue;
+    for (std::map<std::string, std::vector<double> >::iterator
+	   jt = attr->second.begin(); jt != attr->second.end(); ++jt) {
+      std::vector<double>& v = jt->second;
+      size_t to = 0;
+      for (size_t i=0; i<v.size(); ++i) if (k[i]) v[to++] = v[i];
+      v.resize(to);
+    }
+  }
+}
+
+void data::Database::filter_ensembles (const std::vector<bool>& keep)
+{
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it)
+    it->second->filter_ensembles(keep);
+  m_patsize = std::count(keep.begin(), keep.end(), true);
+}
+
+/**
+ * Returns the size of the largest PatternSet, throwing if any is empty
+ *
+ * @param data The PatternSets to check
+ */
+static size_t largest (const std::map<std::string, data::PatternSet*>& data)
+{
+  size_t retval = 0;
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = data.begin(); it != data.end(); ++it) {
+    if (!it->second->size()) {
+      RINGER_DEBUG1("Class \"" << it->first << "\" is empty and cannot be"
+		    << " balanced. Exception thrown.");
+      throw RINGER_EXCEPTION("Cannot balance an empty class");
+    }
+    if (it->second->size() > retval) retval = it->second->size();
+  }
+  return retval;
+}
+
+void data::Database::balance_index (std::vector<size_t>& index) const
+{
+  const size_t greater = largest(m_data);
+  index.clear();
+  index.reserve(greater * m_data.size());
+  size_t offset = 0;
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    const size_t size = it->second->size();
+    for (size_t i=0; i<greater; ++i) index.push_back(offset + i%size);
+    RINGER_DEBUG2("Class \"" << it->first << "\" is sampled " << greater
+		  << " times out of its " << size << " patterns.");
+    offset += size;
+  }
+}
+
+void data::Database::balance_index (const std::vector<size_t>& subset,
+				    std::vector<size_t>& index) const
+{
+  //the class of every merged pattern follows from the class offsets
+  std::vector<size_t> end;
+  size_t offset = 0;
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    offset += it->second->size();
+    end.push_back(offset);
+  }
+  std::vector<std::vector<size_t> > cls(end.size());
+  size_t greater = 0;
+  for (size_t i=0; i<subset.size(); ++i) {
+    if (subset[i] >= offset) {
+      RINGER_DEBUG1("Pattern " << subset[i] << " is not in a database with "
+		    << offset << " patterns. Exception thrown.");
+      throw RINGER_EXCEPTION("Subset does not match the database");
+    }
+    size_t c = std::upper_bound(end.begin(), end.end(), subset[i]) -
+      end.begin();
+    cls[c].push_back(subset[i]);
+    if (cls[c].size() > greater) greater = cls[c].size();
+  }
+  index.clear();
+  index.reserve(greater * cls.size());
+  for (size_t c=0; c<cls.size(); ++c) {
+    const size_t size = cls[c].size();
+    if (!size) continue;
+    for (size_t i=0; i<greater; ++i) index.push_back(cls[c][i%size]);
+    RINGER_DEBUG2("Class " << c << " of the subset is sampled " << greater
+		  << " times out of its " << size << " patterns.");
+  }
+}
+
+void data::Database::balance_weights (std::vector<double>& weights) const
+{
+  const double greater = largest(m_data);
+  weights.clear();
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+	 it = m_data.begin(); it != m_data.end(); ++it) {
+    const size_t size = it->second->size();
+    weights.insert(weights.end(), size, greater/size);
+    RINGER_DEBUG2("Patterns of class \"" << it->first << "\" weigh "
+		  << greater/size << ".");
+  }
+}
+
 std::ostream& operator<< (std::ostream& os, const data::Database& db)
 {
   for (std::map<std::string, data::PatternSet*>::const_iterator
@@ -0,0 +1,151 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/src/FileSource.cxx
+ *
+ * Implements minibatches streamed from a database file.
+ */
+
+#include "data/FileSource.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+#include <cstdlib>
+
+data::FileSource::FileSource (const std::string& filename,
+			      const std::map<std::string, data::Pattern*>&
+			      targets)
+  : m_filename(filename),
+    m_class(),
+    m_target(),
+    m_reader(),
+    m_entry(),
+    m_next(0),
+    m_values(),
+    m_buffer(1)
+{
+  if (targets.empty()) {
+    RINGER_DEBUG1("I need at least one class to stream from \"" << filename
+		  << "\". Exception thrown.");
+    throw RINGER_EXCEPTION("No classes to stream");
+  }
+  for (std::map<std::string, data::Pattern*>::const_iterator
+	 it = targets.begin(); it != targets.end(); ++it) {
+    m_class.push_back(it->first);
+    m_target.push_back(*it->second);
+  }
+  m_reader.assign(m_class.size(), 0);
+  m_entry.assign(m_class.size(), 0);
+  try {
+    for (size_t c=0; c<m_class.size(); ++c) open(c);
+    //the first entry tells the pattern size, then it is read again
+    if (!read(0)) {
+      RINGER_DEBUG1("Class \"" << m_class[0] << "\" of \"" << filename
+		    << "\" has no entries. Exception thrown.");
+      throw RINGER_EXCEPTION("Empty database class");
+    }
+    data::Pattern(m_values).swap(m_buffer);
+    open(0);
+  }
+  catch (...) {
+    for (size_t c=0; c<m_reader.size(); ++c)
+      if (m_reader[c]) xmlFreeTextReader(m_reader[c]);
+    throw;
+  }
+  RINGER_DEBUG2("Streaming " << m_class.size() << " classes of patterns with"
+		<< " " << m_buffer.size() << " features from \"" << filename
+		<< "\".");
+}
+
+data::FileSource::~FileSource ()
+{
+  for (size_t c=0; c<m_reader.size(); ++c) xmlFreeTextReader(m_reader[c]);
+}
+
+void data::FileSource::open (const size_t& c)
+{
+  if (m_reader[c]) xmlFreeTextReader(m_reader[c]);
+  m_reader[c] = xmlReaderForFile(m_filename.c_str(), 0, 0);
+  m_entry[c] = 0;
+  if (!m_reader[c]) {
+    RINGER_DEBUG1("Cannot open database file \"" << m_filename << "\"."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot open database file");
+  }
+  while (xmlTextReaderRead(m_reader[c]) == 1) {
+    if (xmlTextReaderNodeType(m_reader[c]) != XML_READER_TYPE_ELEMENT ||
+	!xmlStrEqual(xmlTextReaderConstName(m_reader[c]), BAD_CAST "class"))
+      continue;
+    xmlChar* name = xmlTextReaderGetAttribute(m_reader[c], BAD_CAST "name");
+    bool found = name && m_class[c] == reinterpret_cast<char*>(name);
+    xmlFree(name);
+    if (found) return;
+  }
+  RINGER_DEBUG1("Database file \"" << m_filename << "\" has no class \""
+		<< m_class[c] << "\". Exception thrown.");
+  throw RINGER_EXCEPTION("Database class not found");
+}
+
+bool data::FileSource::read (const size_t& c)
+{
+  xmlTextReaderPtr reader = m_reader[c];
+  while (xmlTextReaderRead(reader) == 1) {
+    int type = xmlTextReaderNodeType(reader);
+    const xmlChar* node = xmlTextReaderConstName(reader);
+    if (type == XML_READER_TYPE_END_ELEMENT &&
+	xmlStrEqual(node, BAD_CAST "class")) return false;
+    if (type != XML_READER_TYPE_ELEMENT ||
+	!xmlStrEqual(node, BAD_CAST "feature")) continue;
+    ++m_entry[c];
+    xmlChar* text = xmlTextReaderReadString(reader);
+    m_values.clear();
+    const char* p = reinterpret_cast<const char*>(text);
+    char* end = 0;
+    while (p) {
+      double v = std::strtod(p, &end);
+      if (end == p) break;
+      m_values.push_back(v);
+      p = end;
+    }
+    xmlFree(text);
+    if (m_values.empty()) {
+      RINGER_DEBUG1("Entry " << m_entry[c] << " of class \"" << m_class[c]
+		    << "\" in \"" << m_filename << "\" has no features."
+		    << " Exception thrown.");
+      throw RINGER_EXCEPTION("Invalid database entry");
+    }
+    return true;
+  }
+  return false;
+}
+
+void data::FileSource::next (data::PatternSet& data,
+			     data::PatternSet& target, const size_t& n)
+{
+  if (data.size() != n || data.pattern_size() != m_buffer.size())
+    data::PatternSet(n, m_buffer.size()).swap(data);
+  if (target.size() != n || target.pattern_size() != target_size())
+    data::PatternSet(n, target_size()).swap(target);
+  for (size_t i=0; i<n; ++i) {
+    size_t c = m_next;
+    m_next = (m_next + 1) % m_class.size();
+    if (!read(c)) { //back to the first entry of the class
+      open(c);
+      if (!read(c)) {
+	RINGER_DEBUG1("Class \"" << m_class[c] << "\" of \"" << m_filename
+		      << "\" has no entries. Exception thrown.");
+	throw RINGER_EXCEPTION("Empty database class");
+      }
+    }
+    if (m_values.size() != m_buffer.size()) {
+      RINGER_DEBUG1("Entry " << m_entry[c] << " of class \"" << m_class[c]
+		    << "\" in \"" << m_filename << "\" has "
+		    << m_values.size() << " features instead of "
+		    << m_buffer.size() << ". Exception thrown.");
+      throw RINGER_EXCEPTION("Invalid database entry");
+    }
+    for (size_t k=0; k<m_values.size(); ++k) m_buffer[k] = m_values[k];
+    data.set_pattern(i, m_buffer);
+    target.set_pattern(i, m_target[c]);
+  }
+}
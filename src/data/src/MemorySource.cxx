@@ -0,0 +1,49 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/src/MemorySource.cxx
+ *
+ * Implements random minibatches from in-memory pattern sets.
+ */
+
+#include "data/MemorySource.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+data::MemorySource::MemorySource (const data::PatternSet& data,
+				  const data::PatternSet& target,
+				  const std::vector<size_t>& pool,
+				  const size_t& seed)
+  : m_data(data),
+    m_target(target),
+    m_pool(pool),
+    m_rnd(seed),
+    m_pats()
+{
+  if (m_data.size() != m_target.size()) {
+    RINGER_DEBUG1("The data set has " << m_data.size() << " patterns, but"
+		  << " there are " << m_target.size() << " targets."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Data and target sizes differ");
+  }
+  for (size_t i=0; i<m_pool.size(); ++i) {
+    if (m_pool[i] >= m_data.size()) {
+      RINGER_DEBUG1("Pool index " << m_pool[i] << " is out of a set with "
+		    << m_data.size() << " patterns. Exception thrown.");
+      throw RINGER_EXCEPTION("Pool index out of range");
+    }
+  }
+}
+
+void data::MemorySource::next (data::PatternSet& data,
+			       data::PatternSet& target, const size_t& n)
+{
+  m_pats.resize(n);
+  if (m_pool.empty()) m_rnd.draw(m_data.size(), m_pats);
+  else {
+    m_rnd.draw(m_pool.size(), m_pats);
+    for (size_t i=0; i<n; ++i) m_pats[i] = m_pool[m_pats[i]];
+  }
+  data.gather(m_data, m_pats);
+  target.gather(m_target, m_pats);
+}
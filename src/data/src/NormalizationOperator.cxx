@@ -8,17 +8,27 @@
 
 #include "data/NormalizationOperator.h"
 
-data::NormalizationOperator::NormalizationOperator (const data::Database& db)
+data::NormalizationOperator::NormalizationOperator (const data::Database& db,
+						    const bool& balance)
   : m_mean(db.pattern_size(),0),
     m_sd(db.pattern_size(),1)
 {
-  data::PatternSet ps(1,1);
+  //column-major, so every ensemble below is contiguous in memory
+  data::PatternSet ps(1, 1, 0, data::PatternSet::COLUMN_MAJOR);
   db.merge(ps);
+  std::vector<double> w;
+  if (balance) db.balance_weights(w);
   for (unsigned int i=0; i<ps.pattern_size(); ++i) { //for all ensembles
     data::Ensemble e = ps.ensemble(i);
     const gsl_vector* v = abuse(e);
-    m_mean[i] = gsl_stats_mean(v->data, v->stride, v->size);
-    m_sd[i] = gsl_stats_sd(v->data, v->stride, v->size);
+    if (balance) {
+      m_mean[i] = gsl_stats_wmean(&w[0], 1, v->data, v->stride, v->size);
+      m_sd[i] = gsl_stats_wsd(&w[0], 1, v->data, v->stride, v->size);
+    }
+    else {
+      m_mean[i] = gsl_stats_mean(v->data, v->stride, v->size);
+      m_sd[i] = gsl_stats_sd(v->data, v->stride, v->size);
+    }
     if (m_sd[i] < 1e-5) m_sd[i] = 1; ///to prevent overflowing...
     RINGER_DEBUG1("Database mean for ensemble[" << i << "] is " << m_mean[i]);
     RINGER_DEBUG1("Database standard deviation for ensemble[" << i 
@@ -29,6 +39,5 @@ data::NormalizationOperator::NormalizationOperator (const data::Database& db)
 void data::NormalizationOperator::operator() (const data::Pattern& in, 
 					      data::Pattern& out) const
 {
-  out = in - m_mean;
-  out /= m_sd;
+  out = (in - m_mean) / m_sd; //a single loop, see PatternExpression
 }
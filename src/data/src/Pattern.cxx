@@ -10,6 +10,8 @@
 #include "sys/Exception.h"
 #include "sys/debug.h"
 
+#include <algorithm>
+
 data::Pattern::Pattern (const size_t& s, const Feature v)
   : m_vector(0)
 {
@@ -40,6 +42,20 @@ data::Pattern::Pattern(const Pattern& other)
   RINGER_DEBUG3("Constructed pattern from another pattern (copy construct)");
 }
 
+#if __cplusplus >= 201103L
+data::Pattern::Pattern(Pattern&& other)
+  : m_view(),
+    m_vector(other.m_vector)
+{
+  if (other.owner()) other.m_vector = 0;
+  else { //a view remains a view of the same data
+    m_view = other.m_view;
+    m_vector = &m_view.vector;
+  }
+  RINGER_DEBUG3("Constructed pattern from another pattern (move construct)");
+}
+#endif
+
 data::Pattern::~Pattern()
 {
 #if RINGER_DEBUG>2
@@ -70,7 +86,7 @@ data::Pattern& data::Pattern::apply
 data::Pattern& data::Pattern::operator= (const Pattern& other)
 {
   RINGER_DEBUG3("Pattern assignment operator called (RHS=Pattern).");
-  if (size() != other.size()) {
+  if (!m_vector || size() != other.size()) {
     if (m_vector && m_vector->owner) gsl_vector_free(m_vector);
     m_vector = gsl_vector_alloc(other.size());
   }
@@ -78,6 +94,32 @@ data::Pattern& data::Pattern::operator= (const Pattern& other)
   return *this;
 }
 
+#if __cplusplus >= 201103L
+data::Pattern& data::Pattern::operator= (Pattern&& other)
+{
+  RINGER_DEBUG3("Pattern assignment operator called (RHS=Pattern&&).");
+  if (!owner() || !other.m_vector || !other.m_vector->owner)
+    return *this = static_cast<const Pattern&>(other);
+  std::swap(m_vector, other.m_vector); //other frees my old memory
+  return *this;
+}
+#endif
+
+void data::Pattern::swap (data::Pattern& other)
+{
+  if (this == &other) return;
+  if (owner() && other.owner()) {
+    std::swap(m_vector, other.m_vector);
+    return;
+  }
+  if (!m_vector || !other.m_vector || size() != other.size()) {
+    RINGER_DEBUG1("I cannot swap the contents of a Pattern view with a"
+		  << " Pattern of a different size. Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot swap Pattern views of different sizes");
+  }
+  gsl_vector_swap(m_vector, other.m_vector);
+}
+
 data::Pattern& data::Pattern::operator= (const Feature& value)
 {
   RINGER_DEBUG3("Pattern assignment operator called (RHS=Feature).");
@@ -144,30 +186,6 @@ data::Pattern& data::Pattern::operator/= (const data::Pattern& other)
   return *this;
 }
 
-data::Pattern data::operator+ 
-(const data::Pattern& first, const data::Pattern& second) {
-  data::Pattern tmp(first);
-  return tmp += second;
-}
-
-data::Pattern data::operator- 
-(const data::Pattern& first, const data::Pattern& second) {
-  data::Pattern tmp(first);
-  return tmp -= second;
-}
-
-data::Pattern data::operator* 
-(const data::Pattern& first, const data::Pattern& second) {
-  data::Pattern tmp(first);
-  return tmp *= second;
-}
-
-data::Pattern data::operator/ 
-(const data::Pattern& first, const data::Pattern& second) {
-  data::Pattern tmp(first);
-  return tmp /= second;
-}
-
 data::Feature& data::Pattern::operator[] (const size_t& pos)
 {
   if (pos >= size()) {
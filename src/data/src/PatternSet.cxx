@@ -11,30 +11,57 @@
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_errno.h>
 #include <cstdio>
+#include <algorithm>
 
 #include "data/PatternSet.h"
 #include "data/RandomInteger.h"
+#include "data/FeatureExtractor.h"
 #include "sys/Exception.h"
 #include "sys/debug.h"
 #include "sys/xmlutil.h"
 
+/**
+ * Copies the transpose of a matrix into another one, tile by tile, so both
+ * are read and written with good cache locality.
+ *
+ * @param dest Where to copy to, with as many rows as <code>src</code> has
+ * columns and vice-versa
+ * @param src Where to copy from
+ */
+static void transpose_copy (gsl_matrix* dest, const gsl_matrix* src)
+{
+  static const size_t TILE = 32; ///< a tile of doubles fits in L1 cache
+  for (size_t i0=0; i0<src->size1; i0+=TILE) {
+    const size_t i1 = std::min(i0+TILE, src->size1);
+    for (size_t j0=0; j0<src->size2; j0+=TILE) {
+      const size_t j1 = std::min(j0+TILE, src->size2);
+      for (size_t i=i0; i<i1; ++i)
+	for (size_t j=j0; j<j1; ++j)
+	  dest->data[j*dest->tda + i] = src->data[i*src->tda + j];
+    }
+  }
+}
+
 data::PatternSet::PatternSet(const size_t& size, 
 					 const size_t& p_size,
-					 const double& init)
-  : m_data(0) ///< initialize with a NULL pointer
+					 const double& init,
+					 const Layout& layout)
+  : m_data(0), ///< initialize with a NULL pointer
+    m_layout(layout)
 {
   RINGER_DEBUG1("Creating PatternSet with size=" 
 		<< size << " and pattern"
 		<< " size=" << p_size << ", initializer is " << init);
   //try to allocate enough space with GSL
-  m_data = gsl_matrix_alloc (size, p_size);
+  m_data = allocate(size, p_size);
   //set all elements to the given value
   gsl_matrix_set_all(m_data, init);
   RINGER_DEBUG1("PatternSet created and initialised.");
 }
 
 data::PatternSet::PatternSet(sys::xml_ptr_const node)
-  : m_data(0)
+  : m_data(0),
+    m_layout(ROW_MAJOR)
 {
   std::vector<Pattern*> data;
   //for all entries in a class
@@ -67,36 +94,127 @@ data::PatternSet::PatternSet(sys::xml_ptr_const node)
 }
 
 data::PatternSet::PatternSet(const PatternSet& other)
-  : m_data(0)
+  : m_data(0),
+    m_layout(other.m_layout)
 {
   RINGER_DEBUG2("Building PatternSet from"
 		<< " another PatternSet (copy construct).");
-  m_data = gsl_matrix_alloc(other.m_data->size1, other.m_data->size2);
-  gsl_matrix_memcpy(m_data, other.m_data);
+  m_data = allocate(other.size(), other.pattern_size());
+  copy_from(other);
+}
+
+#if __cplusplus >= 201103L
+data::PatternSet::PatternSet(PatternSet&& other)
+  : m_data(other.m_data),
+    m_layout(other.m_layout)
+{
+  RINGER_DEBUG2("Building PatternSet from"
+		<< " another PatternSet (move construct).");
+  if (!other.owner()) { //I become a view of the same data
+    m_view = other.m_view;
+    m_data = &m_view.matrix;
+    m_pats.swap(other.m_pats);
+  }
+  other.m_data = 0;
+}
+#endif
+
+data::PatternSet::PatternSet()
+  : m_data(0),
+    m_layout(ROW_MAJOR)
+{
+}
+
+void data::PatternSet::view_block (const PatternSet& other,
+				   const size_t& start, const size_t& count,
+				   const size_t& first, const size_t& width)
+{
+  if (!count || !width || start + count > other.size() ||
+      first + width > other.pattern_size()) {
+    RINGER_DEBUG1("Cannot view " << count << " patterns from " << start
+		  << " and " << width << " ensembles from " << first
+		  << " of a set with " << other.size() << " patterns of size "
+		  << other.pattern_size() << ". Exception thrown.");
+    throw RINGER_EXCEPTION("PatternSet view out of range");
+  }
+  std::vector<size_t> pats;
+  size_t from = start; //where, in other.m_data, my patterns start
+  size_t stored = count; //and how many of them to take
+  if (!other.m_pats.empty()) { //gathered patterns stay gathered
+    pats.assign(other.m_pats.begin() + start,
+		other.m_pats.begin() + start + count);
+    from = 0;
+    stored = (other.m_layout == ROW_MAJOR)?
+      other.m_data->size1 : other.m_data->size2;
+  }
+  if (other.m_layout == ROW_MAJOR)
+    m_view = gsl_matrix_submatrix(other.m_data, from, first, stored, width);
+  else
+    m_view = gsl_matrix_submatrix(other.m_data, first, from, width, stored);
+  release();
+  m_view.matrix.owner = 0;
+  m_data = &m_view.matrix;
+  m_pats.swap(pats);
+  m_layout = other.m_layout;
+  RINGER_DEBUG2("PatternSet is now a view of " << size() << " patterns of"
+		<< " size " << pattern_size() << ".");
+}
+
+void data::PatternSet::view_rows (const PatternSet& other,
+				  const std::vector<size_t>& pats)
+{
+  if (pats.empty()) {
+    RINGER_DEBUG1("Cannot view an empty selection of patterns. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("Empty PatternSet view");
+  }
+  std::vector<size_t> positions(pats.size());
+  for (size_t i=0; i<pats.size(); ++i) {
+    if (pats[i] >= other.size()) {
+      RINGER_DEBUG1("The maximum number of patterns is " << other.size()
+		    << ". You are trying to view pattern " << pats[i]
+		    << ". Exception thrown.");
+      throw RINGER_EXCEPTION("PatternSet out of (pattern) range");
+    }
+    positions[i] = other.position(pats[i]);
+  }
+  gsl_matrix matrix = *other.m_data;
+  release();
+  m_view.matrix = matrix;
+  m_view.matrix.owner = 0;
+  m_data = &m_view.matrix;
+  m_pats.swap(positions);
+  m_layout = other.m_layout;
+  RINGER_DEBUG2("PatternSet is now a view of " << size() << " selected"
+		<< " patterns of size " << pattern_size() << ".");
 }
 
 data::PatternSet::PatternSet(const PatternSet& other,
 					 const std::vector<size_t>& pats)
-  : m_data(0)
+  : m_data(0),
+    m_layout(other.m_layout)
 {
   RINGER_DEBUG2("Building PatternSet from selected patterns of another"
 		<< " PatternSet (kind-of-copy construct).");
-  m_data = gsl_matrix_alloc(pats.size(), other.m_data->size2);
+  m_data = allocate(pats.size(), other.pattern_size());
   if (!m_data) {
     RINGER_DEBUG1("Allocation of internal matrix failed. Exception thrown.");
     throw RINGER_EXCEPTION("Failed internal matrix allocation");
   }
   RINGER_DEBUG1("Allocated new GSL matrix with address " << m_data
 		<< ", for " << pats.size() << " patterns and with "
-		<< other.m_data->size2 << " features per pattern.");
-  for (unsigned int i=0; i<pats.size(); ++i)
-    gsl_matrix_set_row(m_data, i, 
-		       &gsl_matrix_row(other.m_data, pats[i]).vector);
+		<< other.pattern_size() << " features per pattern.");
+  for (unsigned int i=0; i<pats.size(); ++i) {
+    gsl_vector_view from = other.pattern_view(pats[i]);
+    gsl_vector_view to = pattern_view(i);
+    gsl_vector_memcpy(&to.vector, &from.vector);
+  }
   RINGER_DEBUG2("The new PatternSet has " <<pats.size()<< " patterns.");
 }
 
 data::PatternSet::PatternSet(const std::vector<Pattern*>& pats)
-  : m_data(0)
+  : m_data(0),
+    m_layout(ROW_MAJOR)
 {
   //check all patterns first
   size_t std_size = pats[0]->size();
@@ -117,13 +235,12 @@ data::PatternSet::PatternSet(const std::vector<Pattern*>& pats)
 
 data::PatternSet::~PatternSet()
 {
-  if (m_data) gsl_matrix_free(m_data);
+  release();
 }
 
 data::PatternSet& data::PatternSet::operator=
 (const std::vector<data::Pattern*>& pats) {
-  if (m_data) gsl_matrix_free(m_data);
-  m_data = 0;
+  release();
 
   //check all patterns first
   size_t std_size = pats[0]->size();
@@ -136,9 +253,11 @@ data::PatternSet& data::PatternSet::operator=
 
   //Build
   RINGER_DEBUG2("Building PatternSet from selected patterns.");
-  m_data = gsl_matrix_alloc(pats.size(), std_size);
-  for (unsigned int i=0; i<pats.size(); ++i)
-    gsl_matrix_set_row(m_data, i, pats[i]->m_vector);
+  m_data = allocate(pats.size(), std_size);
+  for (unsigned int i=0; i<pats.size(); ++i) {
+    gsl_vector_view to = pattern_view(i);
+    gsl_vector_memcpy(&to.vector, pats[i]->m_vector);
+  }
   RINGER_DEBUG2("The new PatternSet has " <<pats.size()<< " patterns.");
 
   return *this;
@@ -146,12 +265,30 @@ data::PatternSet& data::PatternSet::operator=
 
 size_t data::PatternSet::size () const
 {
-  return m_data->size1;
+  if (!m_pats.empty()) return m_pats.size();
+  return (m_layout == ROW_MAJOR)? m_data->size1 : m_data->size2;
 }
 
 size_t data::PatternSet::pattern_size () const
 {
-  return m_data->size2;
+  return (m_layout == ROW_MAJOR)? m_data->size2 : m_data->size1;
+}
+
+void data::PatternSet::set_layout (const Layout& layout)
+{
+  if (layout == m_layout) return;
+  check_owner();
+  RINGER_DEBUG2("Transposing PatternSet with " << size() << " patterns of"
+		<< " size " << pattern_size() << " to a new layout.");
+  gsl_matrix* new_data = gsl_matrix_alloc(m_data->size2, m_data->size1);
+  if (!new_data) {
+    RINGER_DEBUG1("Allocation of internal matrix failed. Exception thrown.");
+    throw RINGER_EXCEPTION("Failed internal matrix allocation");
+  }
+  transpose_copy(new_data, m_data);
+  release();
+  m_data = new_data;
+  m_layout = layout;
 }
 
 const data::Pattern data::PatternSet::pattern (const size_t& pos) const
@@ -163,7 +300,7 @@ const data::Pattern data::PatternSet::pattern (const size_t& pos) const
 		  << ". Exception thrown.");
     throw RINGER_EXCEPTION("PatternSet out of (pattern) range");
   }
-  return gsl_matrix_row(m_data, pos);
+  return pattern_view(pos);
 }
 
 const data::Ensemble data::PatternSet::ensemble (const size_t& pos) const
@@ -175,7 +312,36 @@ const data::Ensemble data::PatternSet::ensemble (const size_t& pos) const
 		  << ". Exception thrown.");
     throw RINGER_EXCEPTION("PatternSet out of (ensemble) range");
   }
-  return gsl_matrix_column(m_data, pos);
+  if (m_pats.empty()) return ensemble_view(pos);
+  //gathered patterns are not evenly spaced, so the ensemble is copied
+  data::Ensemble ens(size());
+  for (size_t i=0; i<m_pats.size(); ++i)
+    gsl_vector_set(ens.m_vector, i, *feature(i, pos));
+  return ens;
+}
+
+void data::PatternSet::ensemble (const size_t& pos,
+				 const std::vector<size_t>& pats,
+				 Ensemble& ens) const
+{
+  RINGER_DEBUG3("Gathering Ensemble[" << pos << "] for " << pats.size()
+		<< " selected patterns.");
+  if (pos >= pattern_size()) {
+    RINGER_DEBUG1("The maximum number of ensembles is " << pattern_size()
+		  << ". You are trying to access ensemble " << pos
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("PatternSet out of (ensemble) range");
+  }
+  if (ens.size() != pats.size()) ens = Ensemble(pats.size());
+  for (size_t i=0; i<pats.size(); ++i) {
+    if (pats[i] >= size()) {
+      RINGER_DEBUG1("The maximum number of patterns is " << size()
+		    << ". You are trying to access pattern " << pats[i]
+		    << ". Exception thrown.");
+      throw RINGER_EXCEPTION("PatternSet out of (pattern) range");
+    }
+    gsl_vector_set(ens.m_vector, i, *feature(pats[i], pos));
+  }
 }
 
 void data::PatternSet::set_pattern (const size_t& pos, 
@@ -195,7 +361,7 @@ void data::PatternSet::set_pattern (const size_t& pos,
 		  << ". Exception thrown.");
     throw RINGER_EXCEPTION("Different sizes in copy operation.");
   }
-  gsl_vector_view view = gsl_matrix_row(m_data, pos);
+  gsl_vector_view view = pattern_view(pos);
   gsl_vector_memcpy(&view.vector, pat.m_vector);
   return;
 }
@@ -216,7 +382,12 @@ void data::PatternSet::set_ensemble (const size_t& pos,
 		  << ens.size() << ". Exception thrown.");
     throw RINGER_EXCEPTION("Different sizes in copy operation.");
   }
-  gsl_vector_view view = gsl_matrix_column(m_data, pos);
+  if (!m_pats.empty()) {
+    for (size_t i=0; i<m_pats.size(); ++i)
+      *feature(i, pos) = gsl_vector_get(ens.m_vector, i);
+    return;
+  }
+  gsl_vector_view view = ensemble_view(pos);
   gsl_vector_memcpy(&view.vector, ens.m_vector);
   return;
 }
@@ -230,38 +401,16 @@ void data::PatternSet::erase_pattern (const size_t& pos)
 		  << " patterns. Exception thrown.");
     throw RINGER_EXCEPTION("Unexisting pattern");
   }
-  gsl_matrix* new_data = gsl_matrix_alloc(m_data->size1-1, m_data->size2);
-  if (pos != 0 && pos != m_data->size1-1) {
-    //copy before and after removal point
-    gsl_matrix_const_view before = 
-      gsl_matrix_const_submatrix(m_data, 0, 0, pos, m_data->size2);
-    gsl_matrix_const_view after = 
-      gsl_matrix_const_submatrix(m_data, pos+1, 0, m_data->size1-pos-1, 
-				 m_data->size2);
-    gsl_matrix_view new_before = 
-      gsl_matrix_submatrix(new_data, 0, 0, pos, m_data->size2);
-    gsl_matrix_view new_after = 
-      gsl_matrix_submatrix(new_data, pos, 0, 
-			   m_data->size1-pos-1, m_data->size2);
-    gsl_matrix_memcpy(&new_before.matrix, &before.matrix);
-    gsl_matrix_memcpy(&new_after.matrix, &after.matrix);
-  }
-  else { //in the extremes, it is easier to cut
-    if (pos == 0) {
-      gsl_matrix_const_view v = 
-	gsl_matrix_const_submatrix(m_data, 1, 1, 
-				   m_data->size1-1, m_data->size2);
-      gsl_matrix_memcpy(new_data, &v.matrix);
-    }
-    if (pos == m_data->size1-1) {
-      gsl_matrix_const_view v = 
-	gsl_matrix_const_submatrix(m_data, 0, 0, 
-				   m_data->size1-1, m_data->size2);
-      gsl_matrix_memcpy(new_data, &v.matrix);
-    }
+  check_owner();
+  if (size() == 1) {
+    RINGER_DEBUG1("Trying to erase the only pattern of a set. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("Cannot erase the last pattern of a set");
   }
-  gsl_matrix_free(m_data);
-  m_data = new_data;
+  //compacts in place, the capacity is kept
+  const size_t old = size();
+  for (size_t i=pos+1; i<old; ++i) copy_pattern(i, i-1);
+  set_size(old-1);
   RINGER_DEBUG3("Pattern " << pos << " was removed from set. "
 		<< "The new number of patterns is " << size() << ".");
   return;
@@ -276,6 +425,20 @@ void data::PatternSet::erase_ensemble (const size_t& pos)
 		  << " ensembles. Exception thrown.");
     throw RINGER_EXCEPTION("Unexisting ensemble");
   }
+  check_owner();
+  if (m_layout == COLUMN_MAJOR) {
+    //ensembles are rows, so they can be compacted in place
+    for (size_t i=pos+1; i<m_data->size1; ++i) {
+      gsl_vector_view from = gsl_matrix_row(m_data, i);
+      gsl_vector_view to = gsl_matrix_row(m_data, i-1);
+      gsl_vector_memcpy(&to.vector, &from.vector);
+    }
+    --m_data->size1;
+    RINGER_DEBUG3("Ensemble " << pos << " was removed from set. "
+		  << "The new number of ensembles is " << pattern_size()
+		  << ".");
+    return;
+  }
   gsl_matrix* new_data = gsl_matrix_alloc(m_data->size1, m_data->size2-1);
   if (pos != 0 && pos != m_data->size2-1) {
     //copy before and after removal point
@@ -324,13 +487,68 @@ data::PatternSet* data::PatternSet::clone
   return new data::PatternSet(*this, pats);
 }
 
+void data::PatternSet::gather (const data::PatternSet& other,
+				const std::vector<size_t>& pats)
+{
+  reshape(pats.size(), other.pattern_size());
+  for (unsigned int i=0; i<pats.size(); ++i) {
+    gsl_vector_view from = other.pattern_view(pats[i]);
+    gsl_vector_view to = pattern_view(i);
+    gsl_vector_memcpy(&to.vector, &from.vector);
+  }
+}
+
 void data::PatternSet::shuffle (void)
 {
   static data::RandomInteger rnd;
-  std::vector<size_t> pos(size());
-  rnd.draw(size(), pos);
-  data::PatternSet new_order(*this, pos);
-  *this = new_order;
+  shuffle(rnd);
+}
+
+void data::PatternSet::shuffle (const data::RandomInteger& rnd,
+				data::PatternSet* companion)
+{
+  if (companion && companion->size() != size()) {
+    RINGER_DEBUG1("Cannot shuffle a set with " << size() << " patterns"
+		  << " along with a set of " << companion->size()
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Companion set size mismatch in shuffle");
+  }
+  std::vector<size_t> swaps(size());
+  rnd.shuffle(swaps);
+  shuffle(swaps);
+  if (companion) companion->shuffle(swaps);
+}
+
+void data::PatternSet::shuffle (const std::vector<size_t>& swaps)
+{
+  if (swaps.size() != size()) {
+    RINGER_DEBUG1("Cannot shuffle a set with " << size() << " patterns"
+		  << " with " << swaps.size() << " exchanges. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("Shuffle size mismatch");
+  }
+  for (size_t i=0; i<swaps.size(); ++i) {
+    if (swaps[i] > i) {
+      RINGER_DEBUG1("Exchange " << i << " of a shuffle points ahead, to "
+		    << swaps[i] << ". Exception thrown.");
+      throw RINGER_EXCEPTION("Invalid shuffle exchange");
+    }
+  }
+  if (m_layout == COLUMN_MAJOR && m_pats.empty()) {
+    //one ensemble (row) at a time, each a contiguous block of memory
+    for (size_t e=0; e<m_data->size1; ++e) {
+      data::Feature* ens = m_data->data + e*m_data->tda;
+      for (size_t i=swaps.size(); i>1; --i)
+	std::swap(ens[i-1], ens[swaps[i-1]]);
+    }
+    return;
+  }
+  for (size_t i=swaps.size(); i>1; --i) {
+    if (swaps[i-1] == i-1) continue;
+    gsl_vector_view a = pattern_view(i-1);
+    gsl_vector_view b = pattern_view(swaps[i-1]);
+    gsl_vector_swap(&a.vector, &b.vector);
+  }
 }
 
 sys::xml_ptr data::PatternSet::dump (sys::xml_ptr any,
@@ -360,7 +578,7 @@ void data::PatternSet::apply_pattern_op (const data::PatternOperator& op)
   data::Pattern tmp(pattern(0).size());
   op(pattern(0), tmp);
   size_t std_size = tmp.size();
-  data::PatternSet newset(size(), std_size, 0);
+  data::PatternSet newset(size(), std_size, 0, m_layout);
   for (size_t i=0; i<size(); ++i) { //for every pattern
     op(pattern(i), tmp);
     if (tmp.size() != std_size) {
@@ -371,7 +589,7 @@ void data::PatternSet::apply_pattern_op (const data::PatternOperator& op)
     }
     newset.set_pattern(i, tmp);
   }
-  *this = newset; //copies result
+  swap(newset); //takes over the result
 }
 
 void data::PatternSet::apply_ensemble_op 
@@ -382,7 +600,7 @@ void data::PatternSet::apply_ensemble_op
   data::Pattern tmp(ensemble(0).size());
   op(ensemble(0), tmp);
   size_t std_size = tmp.size();
-  data::PatternSet newset(size(), std_size, 0);
+  data::PatternSet newset(size(), std_size, 0, m_layout);
   for (size_t i=0; i<pattern_size(); ++i) { //for every pattern
     op(ensemble(i), tmp);
     if (tmp.size() != std_size) {
@@ -393,7 +611,7 @@ void data::PatternSet::apply_ensemble_op
     }
     newset.set_ensemble(i, tmp);
   }
-  *this = newset; //copies result
+  swap(newset); //takes over the result
 }
 
 std::ostream& data::PatternSet::stream_out (std::ostream& os) const
@@ -427,18 +645,7 @@ data::PatternSet& data::PatternSet::merge
     throw RINGER_EXCEPTION("RHS has a different pattern size."); 
   }
 
-  gsl_matrix* new_data = gsl_matrix_alloc(size() + other.size(),
-					  pattern_size());
-  gsl_matrix_view new_before = gsl_matrix_submatrix(new_data, 0, 0, 
-						    m_data->size1, 
-						    m_data->size2);
-  gsl_matrix_view new_after = gsl_matrix_submatrix(new_data, m_data->size1, 0,
-						   other.size(), 
-						   m_data->size2);  
-  gsl_matrix_memcpy(&new_before.matrix, m_data);
-  gsl_matrix_memcpy(&new_after.matrix, other.m_data);
-  gsl_matrix_free(m_data);
-  m_data = new_data;
+  append_set(other);
   RINGER_DEBUG3("New PatternSet's contains " << size() << " patterns.");
   return *this;
 }
@@ -448,15 +655,12 @@ data::PatternSet& data::PatternSet::assign
 {
   RINGER_DEBUG2("Reseting PatternSet from selected patterns of another"
 		<< " PatternSet (kind-of-copy construct).");
-  if (m_data->size1 != other.m_data->size1 || 
-      m_data->size2 != other.m_data->size2) {
-    gsl_matrix_free(m_data);
-    m_data = gsl_matrix_alloc(pats.size(), other.m_data->size2);
-    RINGER_DEBUG1("Reallocated this PatternSet (assign()'ing)...");
+  reshape(pats.size(), other.pattern_size());
+  for (unsigned int i=0; i<pats.size(); ++i) {
+    gsl_vector_view from = other.pattern_view(pats[i]);
+    gsl_vector_view to = pattern_view(i);
+    gsl_vector_memcpy(&to.vector, &from.vector);
   }
-  for (unsigned int i=0; i<pats.size(); ++i)
-    gsl_matrix_set_row(m_data, i, 
-		       &gsl_matrix_row(other.m_data, pats[i]).vector);
   RINGER_DEBUG2("The new PatternSet has " <<pats.size()<< " patterns.");
   return *this;
 }
@@ -464,26 +668,355 @@ data::PatternSet& data::PatternSet::assign
 data::PatternSet& data::PatternSet::operator= (const PatternSet& other) {
   RINGER_DEBUG2("Copying PatternSet from another"
 		<< " PatternSet (operator=).");
-  if (m_data->size1 != other.m_data->size1 || 
-      m_data->size2 != other.m_data->size2) {
-    gsl_matrix_free(m_data);
-    m_data = gsl_matrix_alloc(other.m_data->size1, other.m_data->size2);
-  }
-  gsl_matrix_memcpy(m_data, other.m_data);
+  if (this == &other) return *this;
+  reshape(other.size(), other.pattern_size());
+  copy_from(other);
   return *this;
 }
 
+#if __cplusplus >= 201103L
+data::PatternSet& data::PatternSet::operator= (PatternSet&& other) {
+  RINGER_DEBUG2("Moving PatternSet from another"
+		<< " PatternSet (operator=).");
+  if (!owner() || !other.owner())
+    return *this = static_cast<const PatternSet&>(other);
+  std::swap(m_data, other.m_data); //other frees my old memory
+  std::swap(m_layout, other.m_layout);
+  return *this;
+}
+#endif
+
+void data::PatternSet::swap (data::PatternSet& other)
+{
+  if (this == &other) return;
+  if (owner() && other.owner()) {
+    std::swap(m_data, other.m_data);
+    std::swap(m_layout, other.m_layout);
+    return;
+  }
+  if (!m_data || !other.m_data || size() != other.size() ||
+      pattern_size() != other.pattern_size()) {
+    RINGER_DEBUG1("I cannot swap the contents of a PatternSet view with a"
+		  << " PatternSet of a different shape. Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot swap PatternSet views of different shapes");
+  }
+  for (size_t i=0; i<size(); ++i) {
+    gsl_vector_view mine = pattern_view(i);
+    gsl_vector_view theirs = other.pattern_view(i);
+    gsl_vector_swap(&mine.vector, &theirs.vector);
+  }
+}
+
+void data::PatternSet::release (void)
+{
+  if (m_data && m_data->owner) gsl_matrix_free(m_data);
+  m_data = 0;
+  m_pats.clear();
+}
+
+void data::PatternSet::check_owner (void) const
+{
+  if (owner()) return;
+  RINGER_DEBUG1("PatternSet views cannot be resized. Exception thrown.");
+  throw RINGER_EXCEPTION("Cannot resize a PatternSet view");
+}
+
+void data::PatternSet::copy_from (const data::PatternSet& other)
+{
+  if (m_pats.empty() && other.m_pats.empty()) {
+    if (m_layout == other.m_layout) gsl_matrix_memcpy(m_data, other.m_data);
+    else transpose_copy(m_data, other.m_data);
+    return;
+  }
+  for (size_t i=0; i<size(); ++i) {
+    gsl_vector_view from = other.pattern_view(i);
+    gsl_vector_view to = pattern_view(i);
+    gsl_vector_memcpy(&to.vector, &from.vector);
+  }
+}
+
+gsl_vector_view data::PatternSet::pattern_view (const size_t& pos) const
+{
+  if (m_layout == ROW_MAJOR) return gsl_matrix_row(m_data, position(pos));
+  return gsl_matrix_column(m_data, position(pos));
+}
+
+gsl_vector_view data::PatternSet::ensemble_view (const size_t& pos) const
+{
+  if (m_layout == ROW_MAJOR) return gsl_matrix_column(m_data, pos);
+  return gsl_matrix_row(m_data, pos);
+}
+
+gsl_matrix* data::PatternSet::allocate (const size_t& size,
+					const size_t& p_size) const
+{
+  if (m_layout == ROW_MAJOR) return gsl_matrix_alloc(size, p_size);
+  return gsl_matrix_alloc(p_size, size);
+}
+
+void data::PatternSet::set_size (const size_t& size)
+{
+  if (m_layout == ROW_MAJOR) m_data->size1 = size;
+  else m_data->size2 = size;
+}
+
+size_t data::PatternSet::capacity (void) const
+{
+  if (!owner()) return size();
+  if (m_layout == ROW_MAJOR) return m_data->block->size / m_data->tda;
+  return m_data->tda;
+}
+
+void data::PatternSet::reserve (const size_t& n)
+{
+  check_owner();
+  if (n <= capacity()) return;
+  RINGER_DEBUG3("Growing PatternSet capacity from " << capacity() << " to "
+		<< n << " patterns.");
+  gsl_matrix* new_data = allocate(n, pattern_size());
+  if (!new_data) {
+    RINGER_DEBUG1("Allocation of internal matrix failed. Exception thrown.");
+    throw RINGER_EXCEPTION("Failed internal matrix allocation");
+  }
+  gsl_matrix_view part = gsl_matrix_submatrix(new_data, 0, 0, m_data->size1,
+					      m_data->size2);
+  gsl_matrix_memcpy(&part.matrix, m_data);
+  const size_t old = size();
+  gsl_matrix_free(m_data);
+  m_data = new_data;
+  set_size(old); //the rest is spare capacity
+}
+
+void data::PatternSet::grow (const size_t& n)
+{
+  if (n <= capacity()) return;
+  reserve(std::max(n, 2*capacity()));
+}
+
+void data::PatternSet::reshape (const size_t& size, const size_t& p_size)
+{
+  if (!owner()) {
+    //views keep referring to their sets, if they can
+    if (this->size() == size && pattern_size() == p_size) return;
+    release();
+  }
+  if (m_data && pattern_size() == p_size && capacity() >= size) {
+    set_size(size);
+    return;
+  }
+  release();
+  m_data = allocate(size, p_size);
+  if (!m_data) {
+    RINGER_DEBUG1("Allocation of internal matrix failed. Exception thrown.");
+    throw RINGER_EXCEPTION("Failed internal matrix allocation");
+  }
+}
+
+void data::PatternSet::copy_pattern (const size_t& from, const size_t& to)
+{
+  if (m_layout == ROW_MAJOR) {
+    const size_t tda = m_data->tda;
+    std::copy(m_data->data + from*tda,
+	      m_data->data + from*tda + m_data->size2,
+	      m_data->data + to*tda);
+    return;
+  }
+  gsl_vector_view source = gsl_matrix_column(m_data, from);
+  gsl_vector_view dest = gsl_matrix_column(m_data, to);
+  gsl_vector_memcpy(&dest.vector, &source.vector);
+}
+
+void data::PatternSet::append_pattern (const data::Pattern& pat)
+{
+  if (pattern_size() != pat.size()) {
+    RINGER_DEBUG1("Trying to append a pattern with size " << pat.size()
+		  << " to a set with pattern size " << pattern_size()
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Different sizes in append operation.");
+  }
+  check_owner();
+  const size_t old = size();
+  grow(old + 1);
+  set_size(old + 1);
+  gsl_vector_view to = pattern_view(old);
+  gsl_vector_memcpy(&to.vector, pat.m_vector);
+}
+
+void data::PatternSet::append_set (const data::PatternSet& other)
+{
+  if (pattern_size() != other.pattern_size()) {
+    RINGER_DEBUG1("Trying to append PatternSet's with "
+		  << "different Pattern sizes. "
+		  << "LHS has " << pattern_size() << " ensembles while "
+		  << "RHS has " << other.pattern_size() << " ensembles.");
+    throw RINGER_EXCEPTION("RHS has a different pattern size."); 
+  }
+  check_owner();
+  //other may be myself, so its size is taken before growing
+  const size_t n = other.size();
+  const size_t old = size();
+  grow(old + n);
+  set_size(old + n);
+  if (!other.m_pats.empty()) {
+    for (size_t i=0; i<n; ++i) {
+      gsl_vector_view from = other.pattern_view(i);
+      gsl_vector_view to = pattern_view(old+i);
+      gsl_vector_memcpy(&to.vector, &from.vector);
+    }
+    return;
+  }
+  const size_t p_size = pattern_size();
+  gsl_matrix_view to = (m_layout == ROW_MAJOR)?
+    gsl_matrix_submatrix(m_data, old, 0, n, p_size) :
+    gsl_matrix_submatrix(m_data, 0, old, p_size, n);
+  gsl_matrix_const_view from = (other.m_layout == ROW_MAJOR)?
+    gsl_matrix_const_submatrix(other.m_data, 0, 0, n, p_size) :
+    gsl_matrix_const_submatrix(other.m_data, 0, 0, p_size, n);
+  if (m_layout == other.m_layout) gsl_matrix_memcpy(&to.matrix, &from.matrix);
+  else transpose_copy(&to.matrix, &from.matrix);
+}
+
+void data::PatternSet::erase_patterns (const std::vector<bool>& mask)
+{
+  if (mask.size() != size()) {
+    RINGER_DEBUG1("Trying to erase patterns with a mask of size "
+		  << mask.size() << " from a set with " << size()
+		  << " patterns. Exception thrown.");
+    throw RINGER_EXCEPTION("Erase mask size mismatch");
+  }
+  check_owner();
+  size_t kept = 0;
+  for (size_t i=0; i<mask.size(); ++i) if (!mask[i]) ++kept;
+  if (!kept) {
+    RINGER_DEBUG1("Trying to erase all patterns of a set. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("Cannot erase the last pattern of a set");
+  }
+  //a single pass, moving every kept pattern to its final place
+  size_t to = 0;
+  for (size_t i=0; i<mask.size(); ++i) {
+    if (mask[i]) continue;
+    if (i != to) copy_pattern(i, to);
+    ++to;
+  }
+  set_size(kept);
+  RINGER_DEBUG3("Erased " << mask.size() - kept << " patterns from set. "
+		<< "The new number of patterns is " << size() << ".");
+}
+
+void data::PatternSet::erase_patterns (const std::vector<size_t>& pats)
+{
+  std::vector<bool> mask(size(), false);
+  for (size_t i=0; i<pats.size(); ++i) {
+    if (pats[i] >= size()) {
+      RINGER_DEBUG1("Trying to erase pattern @" << pats[i]
+		    << " but this set has only " << size()
+		    << " patterns. Exception thrown.");
+      throw RINGER_EXCEPTION("Unexisting pattern");
+    }
+    mask[pats[i]] = true;
+  }
+  erase_patterns(mask);
+}
+
+void data::PatternSet::mask (const size_t& ens, const data::Feature& min,
+			    const data::Feature& max,
+			    std::vector<bool>& mask) const
+{
+  if (ens >= pattern_size()) {
+    RINGER_DEBUG1("The maximum number of ensembles is " << pattern_size()
+		  << ". You are trying to test ensemble " << ens
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("PatternSet out of (ensemble) range");
+  }
+  const size_t n = size();
+  mask.resize(n);
+  if (m_pats.empty()) {
+    gsl_vector_view v = ensemble_view(ens);
+    const data::Feature* x = v.vector.data;
+    const size_t stride = v.vector.stride;
+    for (size_t i=0; i<n; ++i, x+=stride) mask[i] = (*x >= min && *x <= max);
+    return;
+  }
+  for (size_t i=0; i<n; ++i) {
+    const data::Feature x = *feature(i, ens);
+    mask[i] = (x >= min && x <= max);
+  }
+}
+
+void data::PatternSet::mask (const data::FeatureExtractor& f,
+			    const data::Feature& min,
+			    const data::Feature& max,
+			    std::vector<bool>& mask) const
+{
+  mask.resize(size());
+  for (size_t i=0; i<mask.size(); ++i) {
+    const data::Feature x = f(pattern(i));
+    mask[i] = (x >= min && x <= max);
+  }
+}
+
+void data::PatternSet::filter (const std::vector<bool>& keep)
+{
+  std::vector<bool> erase(keep.size());
+  for (size_t i=0; i<keep.size(); ++i) erase[i] = !keep[i];
+  erase_patterns(erase);
+}
+
+void data::PatternSet::filter_ensembles (const std::vector<bool>& keep)
+{
+  if (keep.size() != pattern_size()) {
+    RINGER_DEBUG1("Trying to filter ensembles with a mask of size "
+		  << keep.size() << " from a set with " << pattern_size()
+		  << " ensembles. Exception thrown.");
+    throw RINGER_EXCEPTION("Filter mask size mismatch");
+  }
+  check_owner();
+  std::vector<size_t> kept; //ensembles to keep, in order
+  for (size_t i=0; i<keep.size(); ++i) if (keep[i]) kept.push_back(i);
+  if (kept.empty()) {
+    RINGER_DEBUG1("Trying to erase all ensembles of a set. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("Cannot erase all ensembles of a set");
+  }
+  if (m_layout == COLUMN_MAJOR) { //ensembles are rows: move them up
+    for (size_t i=0; i<kept.size(); ++i) {
+      if (kept[i] == i) continue;
+      gsl_vector_view from = gsl_matrix_row(m_data, kept[i]);
+      gsl_vector_view to = gsl_matrix_row(m_data, i);
+      gsl_vector_memcpy(&to.vector, &from.vector);
+    }
+    m_data->size1 = kept.size();
+  }
+  else { //compacts every pattern within its own row, tda stays the same
+    for (size_t p=0; p<m_data->size1; ++p) {
+      data::Feature* row = m_data->data + p*m_data->tda;
+      for (size_t i=0; i<kept.size(); ++i) row[i] = row[kept[i]];
+    }
+    m_data->size2 = kept.size();
+  }
+  RINGER_DEBUG3("Kept " << kept.size() << " of " << keep.size()
+		<< " ensembles.");
+}
+
 data::PatternSet& data::PatternSet::operator-= (const PatternSet& other) {
   RINGER_DEBUG2("Copying PatternSet from "
 		<< "another PatternSet (operator=).");
-  if (m_data->size1 != other.m_data->size1 || 
-      m_data->size2 != other.m_data->size2) {
+  if (size() != other.size() || pattern_size() != other.pattern_size()) {
     RINGER_DEBUG1("For operator-=, I need sets with equal sizes."
-		  << " The current set is [" << m_data->size1 << ","
-		  << m_data->size2 << "] and the assigned set is ["
-		  << other.m_data->size1 << "," << other.m_data->size2 << "]");
+		  << " The current set is [" << size() << ","
+		  << pattern_size() << "] and the assigned set is ["
+		  << other.size() << "," << other.pattern_size() << "]");
     throw RINGER_EXCEPTION("Different pattern sizes in subtraction");
   }
-  gsl_matrix_sub(m_data, other.m_data);
+  if (m_pats.empty() && other.m_pats.empty() && m_layout == other.m_layout) {
+    gsl_matrix_sub(m_data, other.m_data);
+    return *this;
+  }
+  for (size_t i=0; i<size(); ++i) {
+    gsl_vector_view mine = pattern_view(i);
+    gsl_vector_view theirs = other.pattern_view(i);
+    gsl_vector_sub(&mine.vector, &theirs.vector);
+  }
   return *this;
 }
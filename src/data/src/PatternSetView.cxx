@@ -0,0 +1,40 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/src/PatternSetView.cxx
+ *
+ * Implements PatternSet's that look at data of other sets.
+ */
+
+#include "data/PatternSetView.h"
+
+data::PatternSetView::PatternSetView (const data::PatternSet& set,
+				      const size_t& start,
+				      const size_t& count)
+  : data::PatternSet()
+{
+  view_block(set, start, count, 0, set.pattern_size());
+}
+
+data::PatternSetView::PatternSetView (const data::PatternSet& set,
+				      const std::vector<size_t>& pats)
+  : data::PatternSet()
+{
+  view_rows(set, pats);
+}
+
+data::PatternSetView::PatternSetView (const data::PatternSet& set,
+				      const size_t& start,
+				      const size_t& count,
+				      const size_t& first,
+				      const size_t& width)
+  : data::PatternSet()
+{
+  view_block(set, start, count, first, width);
+}
+
+data::PatternSetView::PatternSetView (const data::PatternSetView& other)
+  : data::PatternSet()
+{
+  view_block(other, 0, other.size(), 0, other.pattern_size());
+}
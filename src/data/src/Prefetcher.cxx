@@ -0,0 +1,108 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file data/src/Prefetcher.cxx
+ *
+ * Implements the background minibatch producer.
+ */
+
+#include "data/Prefetcher.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+#include <boost/bind.hpp>
+
+data::Prefetcher::Prefetcher (data::BatchSource& source, const size_t& batch,
+			      const size_t& depth)
+  : m_source(source),
+    m_batch(batch),
+    m_data(),
+    m_target(),
+    m_free(),
+    m_ready(),
+    m_current(0),
+    m_stop(false),
+    m_failed(false),
+    m_mutex(),
+    m_cond(),
+    m_thread()
+{
+  if (!m_batch) {
+    RINGER_DEBUG1("Cannot prefetch empty minibatches. Exception thrown.");
+    throw RINGER_EXCEPTION("Empty minibatch");
+  }
+  const size_t n = depth? depth : 1;
+  for (size_t i=0; i<n; ++i) {
+    m_data.push_back(new data::PatternSet(m_batch, m_source.pattern_size()));
+    m_target.push_back(new data::PatternSet(m_batch,
+					    m_source.target_size()));
+    m_free.push_back(i);
+  }
+  m_current = n;
+  m_thread = boost::thread(boost::bind(&data::Prefetcher::work, this));
+  RINGER_DEBUG2("Prefetching minibatches of " << m_batch << " patterns with "
+		<< n << " buffers.");
+}
+
+data::Prefetcher::~Prefetcher ()
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  m_thread.join();
+  for (size_t i=0; i<m_data.size(); ++i) {
+    delete m_data[i];
+    delete m_target[i];
+  }
+  RINGER_DEBUG2("Minibatch prefetching stopped.");
+}
+
+void data::Prefetcher::next (const data::PatternSet*& data,
+			     const data::PatternSet*& target)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (m_current < m_data.size()) {
+    m_free.push_back(m_current);
+    m_current = m_data.size();
+    m_cond.notify_all();
+  }
+  while (!m_failed && m_ready.empty()) m_cond.wait(lock);
+  if (m_failed) {
+    RINGER_DEBUG1("Minibatch prefetching failed. Exception thrown.");
+    throw RINGER_EXCEPTION("Minibatch prefetching failed");
+  }
+  m_current = m_ready.front();
+  m_ready.pop_front();
+  data = m_data[m_current];
+  target = m_target[m_current];
+}
+
+void data::Prefetcher::work (void)
+{
+  while (true) {
+    size_t slot = 0;
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (!m_stop && m_free.empty()) m_cond.wait(lock);
+      if (m_stop) return;
+      slot = m_free.front();
+      m_free.pop_front();
+    }
+    bool ok = true;
+    try {
+      m_source.next(*m_data[slot], *m_target[slot], m_batch);
+    }
+    catch (...) {
+      ok = false;
+    }
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      if (ok) m_ready.push_back(slot);
+      else m_failed = true;
+    }
+    m_cond.notify_all();
+    if (!ok) return;
+  }
+}
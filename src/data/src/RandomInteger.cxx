@@ -7,30 +7,211 @@
  */
 
 #include "data/RandomInteger.h"
+#include "sys/Exception.h"
+#include "sys/debug.h"
 #include <ctime>
-#include <cstdlib>
+#include <sstream>
+#include <boost/thread/mutex.hpp>
 
 /**
- * Initialisation
+ * Protects the run seed and the count of its streams
  */
-static data::RandomInteger s_rnd(time(0));
+static boost::mutex s_mutex;
+
+/**
+ * The seed of this run, zero until set
+ */
+static size_t s_run_seed = 0;
+
+/**
+ * The state of the next stream to take from the run seed, one long jump
+ * ahead of the last one taken, so they all differ
+ */
+static uint64_t s_next[4] = { 0, 0, 0, 0 };
+
+/**
+ * If any stream was taken from the run seed yet
+ */
+static bool s_started = false;
+
+/**
+ * Jumps 2^128 draws ahead, to split streams off a generator
+ */
+static const uint64_t JUMP[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+				 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+
+/**
+ * Jumps 2^192 draws ahead, to take streams off the run seed
+ */
+static const uint64_t LONG_JUMP[] = { 0x76e15d3efefdcbbfULL,
+				      0xc5004e441c522fb3ULL,
+				      0x77710069854ee241ULL,
+				      0x39109bb02acbe635ULL };
+
+/**
+ * Rotates the bits of a word to the left
+ *
+ * @param x The word to rotate
+ * @param k By how many bits
+ */
+static inline uint64_t rotl (const uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * The splitmix64 generator, to spread a seed over the generator state
+ *
+ * @param x The splitmix64 state, advanced by this call
+ */
+static inline uint64_t splitmix64 (uint64_t& x)
+{
+  uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
 
 data::RandomInteger::RandomInteger (const size_t& seed)
-  : m_seed(seed)
+  : m_seed(seed),
+    m_ready(false)
+{
+  if (m_seed) set_seed(m_seed);
+}
+
+size_t data::RandomInteger::run_seed (void)
 {
-  if (seed != 0) srand(seed);
-  else srand(time(0));
+  boost::mutex::scoped_lock lock(s_mutex);
+  if (!s_run_seed) s_run_seed = time(0);
+  return s_run_seed;
+}
+
+void data::RandomInteger::run_seed (const size_t& seed)
+{
+  boost::mutex::scoped_lock lock(s_mutex);
+  s_run_seed = seed? seed : time(0);
+  s_started = false;
+  RINGER_DEBUG2("The run seed is now " << s_run_seed << ".");
+}
+
+void data::RandomInteger::setup (void) const
+{
+  if (m_ready) return;
+  boost::mutex::scoped_lock lock(s_mutex);
+  if (!s_run_seed) s_run_seed = time(0);
+  m_seed = s_run_seed;
+  if (s_started) std::copy(s_next, s_next+4, m_state);
+  else set_seed(m_seed);
+  s_started = true;
+  //a single jump from my stream gives the next one
+  uint64_t mine[4];
+  std::copy(m_state, m_state+4, mine);
+  jump(LONG_JUMP);
+  std::copy(m_state, m_state+4, s_next);
+  std::copy(mine, mine+4, m_state);
+  m_ready = true;
+}
+
+void data::RandomInteger::set_seed (const size_t& seed) const
+{
+  uint64_t x = seed;
+  for (size_t i=0; i<4; ++i) m_state[i] = splitmix64(x);
+  m_ready = true;
+}
+
+uint64_t data::RandomInteger::next (void) const
+{
+  const uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+  const uint64_t t = m_state[1] << 17;
+  m_state[2] ^= m_state[0];
+  m_state[3] ^= m_state[1];
+  m_state[1] ^= m_state[2];
+  m_state[0] ^= m_state[3];
+  m_state[2] ^= t;
+  m_state[3] = rotl(m_state[3], 45);
+  return result;
+}
+
+void data::RandomInteger::jump (const uint64_t* poly) const
+{
+  uint64_t s[4] = { 0, 0, 0, 0 };
+  for (size_t i=0; i<4; ++i) {
+    for (int b=0; b<64; ++b) {
+      if (poly[i] & (1ULL << b))
+	for (size_t k=0; k<4; ++k) s[k] ^= m_state[k];
+      next();
+    }
+  }
+  for (size_t k=0; k<4; ++k) m_state[k] = s[k];
+}
+
+double data::RandomInteger::uniform (void) const
+{
+  setup();
+  //the upper 53 bits fill in a double mantissa exactly
+  return (next() >> 11) * (1.0/9007199254740992.0);
 }
 
 size_t data::RandomInteger::draw (const size_t& max) const
 {
-  double cache = (static_cast<double>(rand())/RAND_MAX)*max;
-  return static_cast<size_t>(cache);
+  if (!max) return 0;
+  //uniform() never returns 1, but rounding could still reach "max"
+  size_t retval = static_cast<size_t>(uniform()*max);
+  return (retval < max)? retval : max-1;
 }
 
-void data::RandomInteger::draw 
+void data::RandomInteger::draw
 (const size_t& max, std::vector<size_t>& c) const
 {
   for (size_t i=0; i<c.size(); ++i) c[i] = draw(max);
 }
 
+void data::RandomInteger::shuffle (std::vector<size_t>& swaps) const
+{
+  for (size_t i=swaps.size(); i>0; --i) swaps[i-1] = draw(i);
+}
+
+data::RandomInteger data::RandomInteger::stream (const size_t& n) const
+{
+  setup();
+  data::RandomInteger retval(*this);
+  for (size_t i=0; i<=n; ++i) retval.jump(JUMP);
+  return retval;
+}
+
+std::string data::RandomInteger::state (void) const
+{
+  setup();
+  std::ostringstream os;
+  os << std::hex << static_cast<uint64_t>(m_seed);
+  for (size_t i=0; i<4; ++i) os << ":" << m_state[i];
+  return os.str();
+}
+
+void data::RandomInteger::state (const std::string& s)
+{
+  std::istringstream is(s);
+  std::vector<uint64_t> word;
+  char sep = ':';
+  while (is && sep == ':') {
+    uint64_t w = 0;
+    if (!(is >> std::hex >> w)) break;
+    word.push_back(w);
+    if (!(is >> sep)) break;
+  }
+  bool valid = is.eof() && (word.size() == 4 || word.size() == 5);
+  const size_t first = word.size() - 4;
+  if (valid) {
+    valid = false;
+    for (size_t i=first; i<word.size(); ++i) if (word[i]) valid = true;
+  }
+  if (!valid) {
+    RINGER_DEBUG1("\"" << s << "\" is not a random generator state."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid random generator state");
+  }
+  if (first) m_seed = word[0];
+  else if (!m_ready && !m_seed) m_seed = run_seed();
+  for (size_t i=0; i<4; ++i) m_state[i] = word[first+i];
+  m_ready = true;
+}
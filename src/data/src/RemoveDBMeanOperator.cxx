@@ -11,7 +11,8 @@
 data::RemoveDBMeanOperator::RemoveDBMeanOperator (const data::Database& db)
   : m_mean(db.pattern_size(),0)
 {
-  data::PatternSet ps(1,1);
+  //column-major, so every ensemble below is contiguous in memory
+  data::PatternSet ps(1, 1, 0, data::PatternSet::COLUMN_MAJOR);
   db.merge(ps);
   for (unsigned int i=0; i<ps.pattern_size(); ++i) { //for all ensembles
     data::Ensemble e = ps.ensemble(i);
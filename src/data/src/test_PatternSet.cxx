@@ -12,6 +12,8 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstdlib>
+#include <vector>
 
 #include "data/Database.h"
 #include "data/RandomInteger.h"
@@ -121,6 +123,92 @@ void merge (std::ostream& os, data::PatternSet& f,
   print(os, f);
 }
 
+/**
+ * Compares a PatternSet with the Pattern's it should have, and exits with
+ * an error if they differ.
+ * @param pset The PatternSet to check
+ * @param ref The Pattern's it should have, in order
+ * @param what The operation being checked
+ */
+void compare (const data::PatternSet& pset,
+	      const std::vector<std::vector<data::Feature> >& ref,
+	      const char* what)
+{
+  if (pset.size() != ref.size()) error(what, "wrong number of patterns");
+  for (size_t i=0; i<ref.size(); ++i) {
+    const data::Pattern p = pset.pattern(i);
+    if (p.size() != ref[i].size()) error(what, "wrong pattern size");
+    for (size_t j=0; j<ref[i].size(); ++j)
+      if (p[j] != ref[i][j]) error(what, "wrong pattern contents");
+  }
+}
+
+/**
+ * Checks reserving, appending, erasing and filtering on a copy of the set,
+ * with a given memory layout, against the same operations on plain copies
+ * of its Pattern's.
+ * @param os The output stream where to print the results
+ * @param pset The PatternSet to copy, with at least 3 Pattern's
+ * @param layout The memory layout of the copy
+ */
+void layout (std::ostream& os, const data::PatternSet& pset,
+	     const data::PatternSet::Layout& layout)
+{
+  const char* name =
+    (layout == data::PatternSet::ROW_MAJOR)? "row-major" : "column-major";
+  data::PatternSet s(pset);
+  s.set_layout(layout);
+  if (s.layout() != layout) error(name, "layout not set");
+  std::vector<std::vector<data::Feature> > ref(pset.size());
+  for (size_t i=0; i<pset.size(); ++i) {
+    const data::Pattern p = pset.pattern(i);
+    for (size_t j=0; j<p.size(); ++j) ref[i].push_back(p[j]);
+  }
+  compare(s, ref, "set_layout");
+
+  s.reserve(4*s.size());
+  if (s.capacity() < 4*ref.size()) error("reserve", "capacity too small");
+  compare(s, ref, "reserve");
+
+  s.append_pattern(pset.pattern(1));
+  ref.push_back(ref[1]);
+  compare(s, ref, "append_pattern");
+
+  s.append_set(s); //appending myself
+  const size_t n = ref.size();
+  for (size_t i=0; i<n; ++i) ref.push_back(ref[i]);
+  compare(s, ref, "append_set");
+
+  for (size_t i=0; i<3*n; ++i) { //past the reserved capacity
+    s.append_pattern(pset.pattern(i % pset.size()));
+    ref.push_back(ref[i % pset.size()]);
+  }
+  compare(s, ref, "append_pattern (growing)");
+
+  s.erase_pattern(1);
+  ref.erase(ref.begin() + 1);
+  compare(s, ref, "erase_pattern");
+
+  std::vector<size_t> pats;
+  pats.push_back(ref.size() - 1);
+  pats.push_back(0);
+  s.erase_patterns(pats);
+  ref.erase(ref.end() - 1);
+  ref.erase(ref.begin());
+  compare(s, ref, "erase_patterns");
+
+  std::vector<bool> keep(ref.size(), false);
+  std::vector<std::vector<data::Feature> > kept;
+  for (size_t i=0; i<ref.size(); i+=2) {
+    keep[i] = true;
+    kept.push_back(ref[i]);
+  }
+  s.filter(keep);
+  compare(s, kept, "filter");
+  os << "OK: append, reserve, erase and filter on a " << name << " set"
+     << std::endl;
+}
+
 int main (int argc, char** argv)
 {
   sys::Reporter reporter("local");
@@ -134,7 +222,9 @@ int main (int argc, char** argv)
 		<< std::endl
 		<< "\t erase X - erase entry X on the Pattern file" 
 		<< std::endl
-		<< "\t merge - merges the two pattern sets in DB");
+		<< "\t merge - merges the two pattern sets in DB" << std::endl
+		<< "\t layout - checks growing and shrinking on both memory"
+		<< " layouts");
     RINGER_FATAL(reporter, "Insuficiente number of parameters! Bye...");
   }
   try {
@@ -179,6 +269,12 @@ int main (int argc, char** argv)
       data::Database newdb(db.header(), newdata, reporter);
       newdb.save("test.xml");
     }
+    else if ( command == "layout" ) {
+      if (mypat->size() < 3) RINGER_FATAL(reporter, "layout: the first class"
+					 << " needs at least 3 patterns!");
+      layout(std::cout, *mypat, data::PatternSet::ROW_MAJOR);
+      layout(std::cout, *mypat, data::PatternSet::COLUMN_MAJOR);
+    }
     else RINGER_FATAL(reporter, "Command \"" << command << "\" not identified.");
   }
   catch (sys::Exception& e) {
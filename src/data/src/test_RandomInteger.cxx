@@ -8,21 +8,100 @@
  *
  * The purpose of this test is to make sure that the RandomInteger is
  * responding as expected. That means, it is genearating really a
- * random sequence of integers between <code>0</code> and a limit.
+ * random sequence of integers between <code>0</code> and a limit. With the
+ * "check" command, it also checks that streams are reproducible and
+ * independent, and that a saved generator state resumes the same draws.
  */
 
 #include <iostream>
 #include <sstream>
 #include <valarray>
+#include <cstdlib>
+#include <string>
+#include <vector>
 
 #include "data/RandomInteger.h"
 #include "sys/Reporter.h"
+#include "sys/Exception.h"
+
+/**
+ * Returns an error message and exit.
+ * 
+ * @param m1 The initial part of the error message
+ * @param m2 The second part of the error message
+ */
+void error (const char* m1, const char* m2)
+{
+  std::cerr << "[test_RandomInteger::main()] "
+	    << "ERROR: " << m1 << ", " << m2 
+	    << std::endl;
+  std::exit(1);
+}
+
+/**
+ * Checks that streams of a generator are reproducible, differ from each
+ * other and from their parent, and leave their parent untouched.
+ *
+ * @param os The output stream to use
+ * @param max The maximum integer to draw
+ * @param no How many integers to draw from every generator
+ */
+void streams (std::ostream& os, const size_t& max, const size_t& no)
+{
+  data::RandomInteger base(12345);
+  std::vector<size_t> s0(no), s0again(no), s1(no), parent(no), fresh(no);
+  base.stream(0).draw(max, s0);
+  base.stream(0).draw(max, s0again);
+  base.stream(1).draw(max, s1);
+  base.draw(max, parent);
+  data::RandomInteger(12345).draw(max, fresh);
+  if (s0 != s0again) error("streams", "the same stream drew differently");
+  if (s0 == s1) error("streams", "two streams drew the same values");
+  if (parent == s0 || parent == s1)
+    error("streams", "a stream drew the same values as its parent");
+  if (parent != fresh) error("streams", "taking streams changed the parent");
+  os << "OK: streams are reproducible and independent" << std::endl;
+}
+
+/**
+ * Checks that restoring a saved state, in another generator, resumes the
+ * same draws and the same seed, and that invalid states are rejected.
+ *
+ * @param os The output stream to use
+ * @param max The maximum integer to draw
+ * @param no How many integers to draw after the state is saved
+ */
+void state (std::ostream& os, const size_t& max, const size_t& no)
+{
+  data::RandomInteger ri(54321);
+  std::vector<size_t> first(no), second(no);
+  ri.draw(max, first); //the saved state is not the initial one
+  const std::string saved = ri.state();
+  ri.draw(max, first);
+  data::RandomInteger other(999);
+  other.state(saved);
+  other.draw(max, second);
+  if (first != second) error("state", "the restored state drew differently");
+  if (other.seed() != ri.seed()) error("state", "the seed was not restored");
+  if (other.state() != ri.state())
+    error("state", "the states differ after the same draws");
+  bool rejected = false;
+  try { other.state("0:0:0:0"); }
+  catch (sys::Exception&) { rejected = true; }
+  if (!rejected) error("state", "the all-zero state was accepted");
+  rejected = false;
+  try { other.state("not a state"); }
+  catch (sys::Exception&) { rejected = true; }
+  if (!rejected) error("state", "a malformed state was accepted");
+  os << "OK: saved states resume the same draws" << std::endl;
+}
 
 int main (int argc, char** argv)
 {
   sys::Reporter reporter("local");
-  if ( argc != 3 ) 
-    RINGER_FATAL(reporter, "usage: " << argv[0] << " <max int> <no. of values>");
+  if ( argc != 3 && argc != 4 ) 
+    RINGER_FATAL(reporter, "usage: " << argv[0] << " <max int> <no. of values>"
+		 << " [check]");
   std::istringstream iss(argv[1]);
   size_t max;
   iss >> max;
@@ -30,6 +109,17 @@ int main (int argc, char** argv)
   size_t no;
   iss2 >> no;
 
+  if (argc == 4) {
+    if (std::string(argv[3]) != "check")
+      RINGER_FATAL(reporter, "Command \"" << argv[3] << "\" not identified.");
+    if (max < 2 || no < 64)
+      RINGER_FATAL(reporter, "check: draw at least 64 integers below 2 or"
+		   << " more, so sequences differ");
+    streams(std::cout, max, no);
+    state(std::cout, max, no);
+    return 0;
+  }
+
   data::RandomInteger ri(time(0));
   std::vector<size_t> rnd(no);
   ri.draw(max,rnd);
@@ -11,7 +11,7 @@ endif ("${TORCH_LINKAGE}" STREQUAL static)
 set(Boost_USE_MULTITHREADED ON)
 
 # Determine here the components you need so the system can verify
-find_package(Boost COMPONENTS python unit_test_framework)
+find_package(Boost COMPONENTS python unit_test_framework thread system)
 
 # Renaming so all works automagically
 set(boost_INCLUDE_DIRS ${Boost_INCLUDE_DIRS} CACHE INTERNAL "incdirs")
@@ -0,0 +1,120 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/AsyncTrainer.h
+ *
+ * @brief Declares a lock-free, asynchronous (Hogwild-style), multi-threaded
+ * trainer for networks.
+ */
+
+#ifndef NETWORK_ASYNCTRAINER_H
+#define NETWORK_ASYNCTRAINER_H
+
+#include <vector>
+
+#include "network/Network.h"
+#include "data/PatternSet.h"
+#include "data/RandomInteger.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * Trains a Network using several threads that update a shared set of
+   * weights without any locking.
+   *
+   * Each thread owns a private replica of the network being trained and its
+   * own random number generator. At every step, a thread reads the shared
+   * weights into its replica, trains the replica on a minibatch it draws
+   * from the (read-only) training set and adds the resulting weight changes
+   * back into the shared weights. Shared weights are read and written with
+   * relaxed atomic operations: concurrent updates to the same weight may
+   * overwrite each other and the order in which threads see each other's
+   * changes is unspecified.
+   *
+   * @warning This training mode is <b>not deterministic</b>. Two runs with
+   * the same seed and the same data will, in general, produce different
+   * networks. Use the synchronous Network::train() methods if you need
+   * reproducible results.
+   */
+  class AsyncTrainer {
+
+  public: //interface
+
+    /**
+     * Prepares asynchronous training for a network. The thread replicas are
+     * built here, in the calling thread.
+     *
+     * @param net The network to train. Its weights are updated at the end
+     * of every call to train().
+     * @param threads The number of concurrent training threads
+     * @param reporter The reporter to inform about changes or errors.
+     * @param seed The seed for the per-thread random generators. Thread
+     * <code>i</code> draws from stream <code>i</code> of a generator with
+     * this seed (see data::RandomInteger::stream()). If zero is given, that
+     * generator is a stream of the run seed.
+     */
+    AsyncTrainer (Network& net, const size_t& threads,
+		  sys::Reporter& reporter, const size_t& seed=0);
+
+    /**
+     * Destroys the thread replicas
+     */
+    virtual ~AsyncTrainer ();
+
+    /**
+     * Trains the network asynchronously. The given number of steps are
+     * distributed among all threads and, in each step, a thread trains on
+     * <code>epoch</code> randomly chosen patterns. This method returns when
+     * all threads are finished and the network is updated.
+     *
+     * @param data The PatternSet to train the neural network with.
+     * @param target What is the network target for this supervisionised
+     * training system.
+     * @param epoch The number of patterns in each minibatch
+     * @param steps The total number of minibatches to train with
+     */
+    void train (const data::PatternSet& data, const data::PatternSet& target,
+		const unsigned int& epoch, const unsigned int& steps);
+
+    /**
+     * Returns the number of training threads
+     */
+    inline size_t threads (void) const { return m_replica.size(); }
+
+    /**
+     * Returns the throughput achieved during the last call to train(), in
+     * patterns per second.
+     */
+    inline double throughput (void) const { return m_throughput; }
+
+  private: //helpers
+
+    /**
+     * The work executed by each thread.
+     *
+     * @param worker The thread number
+     * @param data The PatternSet to train the neural network with.
+     * @param target The targets for the training set
+     * @param epoch The number of patterns in each minibatch
+     * @param steps The number of minibatches this thread has to train with
+     */
+    void work (const size_t worker, const data::PatternSet* data,
+	       const data::PatternSet* target, const unsigned int epoch,
+	       const unsigned int steps);
+
+  private: //representation
+
+    Network& m_net; ///< the network being trained
+    sys::Reporter& m_reporter; ///< where to report
+    std::vector<Network*> m_replica; ///< one network per thread
+    std::vector<data::RandomInteger*> m_rnd; ///< one generator per thread
+    std::vector<data::Feature> m_weight; ///< shared, lock-free weights
+    std::vector<char> m_failed; ///< threads that exited by exception
+    double m_throughput; ///< patterns per second, last train()
+
+  };
+
+}
+
+#endif /* NETWORK_ASYNCTRAINER_H */
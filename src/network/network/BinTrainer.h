@@ -0,0 +1,159 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/BinTrainer.h
+ *
+ * @brief Declares concurrent training of one network per bin of a binned
+ * data set, e.g. per transverse energy bin.
+ */
+
+#ifndef NETWORK_BINTRAINER_H
+#define NETWORK_BINTRAINER_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "network/Sweep.h"
+#include "network/Trainer.h"
+#include "config/Header.h"
+#include "data/PatternSet.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * Trains one MLP per bin, concurrently, on data sets that are loaded only
+   * once.
+   *
+   * Bins are index lists into the training and test sets, typically built
+   * with data::Database::bin() from a feature (data::Database::column()) or
+   * an entry attribute (data::Database::attribute()), and are handed to
+   * every network::Trainer through Trainer::subset(). No pattern is ever
+   * copied. Every bin trains an MLP of the same configuration (see
+   * network::Sweep::build()), on a sys::ThreadPool task, with its input
+   * normalisation computed from its own training patterns. The best
+   * networks of all bins are kept and can be saved as a bundle.
+   */
+  class BinTrainer {
+
+  public: //interface
+
+    /**
+     * Prepares the training of all bins
+     *
+     * @param train The training set
+     * @param train_target The training set targets
+     * @param test The test set, used for evaluation
+     * @param test_target The test set targets
+     * @param train_bins The training patterns of every bin
+     * @param test_bins The test patterns of every bin
+     * @param point The MLP configuration to train in every bin
+     * @param par The training parameters. The epoch comes from
+     * <code>point</code>.
+     * @param reporter The reporter to inform about changes or errors.
+     */
+    BinTrainer (const data::PatternSet& train,
+		const data::PatternSet& train_target,
+		const data::PatternSet& test,
+		const data::PatternSet& test_target,
+		const std::vector<std::vector<size_t> >& train_bins,
+		const std::vector<std::vector<size_t> >& test_bins,
+		const SweepPoint& point,
+		const TrainerParameters& par,
+		sys::Reporter& reporter);
+
+    /**
+     * Deletes the trained networks
+     */
+    virtual ~BinTrainer ();
+
+    /**
+     * Trains all bins, returning when all are done. Bins without training
+     * or test patterns are not trained and are flagged as failed.
+     *
+     * @param threads How many bins to train concurrently. If zero is given,
+     * one per hardware thread.
+     */
+    void run (const size_t& threads=0);
+
+    /**
+     * Returns the number of bins
+     */
+    inline size_t size (void) const { return m_result.size(); }
+
+    /**
+     * Returns the outcome of every bin, valid after run()
+     */
+    inline const std::vector<SweepResult>& results (void) const
+    { return m_result; }
+
+    /**
+     * Returns the best network of a bin, or 0 if the bin failed
+     *
+     * @param i The bin
+     */
+    inline const Network* network (const size_t& i) const
+    { return m_net[i]; }
+
+    /**
+     * Saves the bundle of best networks: the network of bin <i>i</i> goes
+     * to <code>prefix.i.xml</code> and an index, with one line per bin
+     * holding its lower and upper edges and its network file name (or
+     * "none" if the bin failed), goes to <code>prefix.bins</code>.
+     *
+     * @param prefix The prefix of the files to save
+     * @param edges The bin edges, one more than there are bins
+     * @param header An optional header for the saved networks
+     */
+    void save (const std::string& prefix, const std::vector<double>& edges,
+	       const config::Header* header=0) const;
+
+    /**
+     * Writes a summary table, one line per bin
+     *
+     * @param os Where to write the table
+     */
+    void table (std::ostream& os) const;
+
+  private: //helpers
+
+    /**
+     * Builds the network of a bin, normalised by its training patterns
+     *
+     * @param i The bin
+     */
+    Network* build (const size_t& i) const;
+
+    /**
+     * Trains the network of a single bin, built by run(). Runs on a thread
+     * pool task.
+     *
+     * @param i The bin to train
+     * @param rnd Its minibatch random generator
+     */
+    void train (const size_t& i, const data::RandomInteger& rnd);
+
+  private: //not implemented
+
+    BinTrainer (const BinTrainer& other);
+    BinTrainer& operator= (const BinTrainer& other);
+
+  private: //representation
+
+    const data::PatternSet& m_train; ///< training set
+    const data::PatternSet& m_train_target; ///< training set targets
+    const data::PatternSet& m_test; ///< test set
+    const data::PatternSet& m_test_target; ///< test set targets
+    std::vector<std::vector<size_t> > m_train_bins; ///< training bins
+    std::vector<std::vector<size_t> > m_test_bins; ///< test bins
+    TrainerParameters m_par; ///< training parameters
+    sys::Reporter& m_reporter; ///< where to report
+    std::vector<SweepResult> m_result; ///< one entry per bin
+    std::vector<Network*> m_net; ///< the best network of every bin
+
+  };
+
+}
+
+#endif /* NETWORK_BINTRAINER_H */
@@ -0,0 +1,99 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/CachedTrainer.h
+ *
+ * @brief Declares a trainer that retrains only the output layer of a
+ * network, using cached hidden layer activations.
+ */
+
+#ifndef NETWORK_CACHEDTRAINER_H
+#define NETWORK_CACHEDTRAINER_H
+
+#include <vector>
+
+#include "network/Network.h"
+#include "data/PatternSet.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * Retrains the output layer of an existing network.
+   *
+   * All synapses but the ones reaching the output neurons are frozen and the
+   * training set is run through the network only once, at construction. The
+   * activations feeding the output layer are cached and, from then on,
+   * training proceeds on a single layer network fed by the cached
+   * activations, at the cost of training a single layer. Call commit() to
+   * copy the retrained weights back into the original network.
+   */
+  class CachedTrainer {
+
+  public: //interface
+
+    /**
+     * Freezes the given network and caches the output layer inputs for the
+     * given training set.
+     *
+     * @param net The network to retrain
+     * @param data The training set
+     * @param reporter The reporter to inform about changes or errors.
+     */
+    CachedTrainer (Network& net, const data::PatternSet& data,
+		   sys::Reporter& reporter);
+
+    /**
+     * Destroys the cached layer, but <b>does not</b> commit().
+     */
+    virtual ~CachedTrainer ();
+
+    /**
+     * Trains the output layer with randomly chosen patterns of the cached
+     * training set.
+     *
+     * @param target The targets for the training set
+     * @param epoch The number of patterns to use in this step
+     */
+    void train (const data::PatternSet& target, unsigned int epoch);
+
+    /**
+     * Trains the output layer with the chosen patterns of the cached
+     * training set.
+     *
+     * @param target The targets for the training set
+     * @param pats The patterns to use in this step
+     */
+    void train (const data::PatternSet& target,
+		const std::vector<size_t>& pats);
+
+    /**
+     * Runs the whole cached training set through the output layer.
+     *
+     * @param output Where to place the network outputs
+     */
+    void run (data::PatternSet& output);
+
+    /**
+     * Copies the retrained weights back into the original network.
+     */
+    void commit (void);
+
+    /**
+     * Returns the cached features (output layer inputs)
+     */
+    inline const data::PatternSet& features (void) const
+    { return m_features; }
+
+  private: //representation
+
+    Network& m_net; ///< the network being retrained
+    sys::Reporter& m_reporter; ///< where to report
+    data::PatternSet m_features; ///< the cached output layer inputs
+    Network* m_layer; ///< the output layer, fed by cached inputs
+
+  };
+
+}
+
+#endif /* NETWORK_CACHEDTRAINER_H */
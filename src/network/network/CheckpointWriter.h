@@ -0,0 +1,112 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/CheckpointWriter.h
+ *
+ * @brief Declares a background, coalescing, writer of network checkpoints.
+ */
+
+#ifndef NETWORK_CHECKPOINTWRITER_H
+#define NETWORK_CHECKPOINTWRITER_H
+
+#include <string>
+#include <vector>
+#include <boost/thread.hpp>
+
+#include "network/Network.h"
+#include "config/Header.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * Saves snapshots of a network's weights to a file on a background
+   * thread, so training never waits for XML formatting or the disk.
+   *
+   * The writer owns a private replica of the network, built at construction.
+   * Submitting a snapshot only copies the weights. If several snapshots are
+   * submitted while a write is going on, only the latest one is written
+   * next, the others are dropped. Files are first written under a temporary
+   * name and then renamed, so the checkpoint on disk is always complete.
+   *
+   * Only weights are taken from snapshots: the learning strategy parameters
+   * in the saved files are the ones the network had when the writer was
+   * built.
+   */
+  class CheckpointWriter {
+
+  public: //interface
+
+    /**
+     * Builds the network replica and starts the writer thread
+     *
+     * @param net The network whose snapshots will be written
+     * @param file The file to write
+     * @param header An optional header for the saved networks, copied here
+     * @param reporter The reporter to inform about changes or errors.
+     */
+    CheckpointWriter (const Network& net, const std::string& file,
+		      const config::Header* header, sys::Reporter& reporter);
+
+    /**
+     * Writes the last pending snapshot, if any, and stops the thread
+     */
+    virtual ~CheckpointWriter ();
+
+    /**
+     * Hands a weight snapshot to be written, replacing any snapshot still
+     * waiting to be written. Never waits for a write to finish.
+     *
+     * @param weights The network weights, as given by Network::copy_weights()
+     */
+    void submit (const std::vector<data::Feature>& weights);
+
+    /**
+     * Waits until the last submitted snapshot is on disk. If a write failed,
+     * an exception is thrown.
+     */
+    void flush (void);
+
+    /**
+     * Returns the file I write to
+     */
+    inline const std::string& file (void) const { return m_file; }
+
+    /**
+     * Returns how many snapshots were actually written so far
+     */
+    size_t written (void);
+
+  private: //helpers
+
+    /**
+     * The writer thread body
+     */
+    void work (void);
+
+  private: //not implemented
+
+    CheckpointWriter (const CheckpointWriter& other);
+    CheckpointWriter& operator= (const CheckpointWriter& other);
+
+  private: //representation
+
+    sys::Reporter& m_reporter; ///< where to report
+    Network* m_replica; ///< my private network replica
+    std::string m_file; ///< where to write
+    config::Header* m_header; ///< my copy of the header, if any
+    std::vector<data::Feature> m_pending; ///< the latest snapshot to write
+    bool m_dirty; ///< if there is a pending snapshot
+    bool m_busy; ///< if a write is going on
+    size_t m_written; ///< how many snapshots were written
+    bool m_stop; ///< tells the thread to finish
+    bool m_failed; ///< if a write failed
+    boost::mutex m_mutex; ///< protects all of the above
+    boost::condition_variable m_cond; ///< signals state changes
+    boost::thread m_thread; ///< the writer thread
+
+  };
+
+}
+
+#endif /* NETWORK_CHECKPOINTWRITER_H */
@@ -0,0 +1,147 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/CrossValidation.h
+ *
+ * @brief Declares parallel k-fold cross-validation of an MLP configuration.
+ */
+
+#ifndef NETWORK_CROSSVALIDATION_H
+#define NETWORK_CROSSVALIDATION_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "network/Sweep.h"
+#include "network/Trainer.h"
+#include "data/Pattern.h"
+#include "data/PatternSet.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * Trains one MLP per cross-validation fold, concurrently, and aggregates
+   * their figures of merit.
+   *
+   * All folds share a single data set: each fold is only a pair of index
+   * lists into it, as produced by data::Database::kfold(), and is handed to
+   * its network::Trainer through Trainer::subset(). No pattern is ever
+   * copied. Every fold trains an MLP of the same configuration (see
+   * network::Sweep::build()), on a sys::ThreadPool task, and the best
+   * evaluation of every fold on its own test part is kept.
+   */
+  class CrossValidation {
+
+  public: //interface
+
+    /**
+     * Prepares a cross-validation
+     *
+     * @param data The data set all folds take patterns from
+     * @param target The data set targets
+     * @param train The training patterns of every fold
+     * @param test The test patterns of every fold
+     * @param mean The mean to subtract from the inputs of every MLP
+     * @param stddev The value to divide the inputs of every MLP by
+     * @param point The MLP configuration to validate
+     * @param par The training parameters. The epoch comes from
+     * <code>point</code>.
+     * @param reporter The reporter to inform about changes or errors.
+     */
+    CrossValidation (const data::PatternSet& data,
+		     const data::PatternSet& target,
+		     const std::vector<std::vector<size_t> >& train,
+		     const std::vector<std::vector<size_t> >& test,
+		     const data::Pattern& mean,
+		     const data::Pattern& stddev,
+		     const SweepPoint& point,
+		     const TrainerParameters& par,
+		     sys::Reporter& reporter);
+
+    /**
+     * Destructor virtualisation
+     */
+    virtual ~CrossValidation ();
+
+    /**
+     * Optionally saves the best network of every fold, as
+     * <code>prefix.i.xml</code>, when it is done training.
+     *
+     * @param prefix The prefix of the files to save. If empty, nothing is
+     * saved.
+     */
+    inline void save (const std::string& prefix) { m_prefix = prefix; }
+
+    /**
+     * Trains all folds, returning when all are done
+     *
+     * @param threads How many folds to train concurrently. If zero is
+     * given, one per hardware thread.
+     */
+    void run (const size_t& threads=0);
+
+    /**
+     * Returns the number of folds
+     */
+    inline size_t size (void) const { return m_result.size(); }
+
+    /**
+     * Returns the outcome of every fold, valid after run()
+     */
+    inline const std::vector<SweepResult>& results (void) const
+    { return m_result; }
+
+    /**
+     * Computes the mean and standard deviation of the best SP product and
+     * MSE over all folds that trained successfully.
+     *
+     * @param sp_mean Where to place the mean SP product
+     * @param sp_stddev Where to place the SP product standard deviation
+     * @param mse_mean Where to place the mean MSE
+     * @param mse_stddev Where to place the MSE standard deviation
+     *
+     * @return The number of folds that were aggregated
+     */
+    size_t summary (double& sp_mean, double& sp_stddev,
+		    double& mse_mean, double& mse_stddev) const;
+
+    /**
+     * Writes a summary table, one line per fold, followed by the mean and
+     * standard deviation over all folds
+     *
+     * @param os Where to write the table
+     */
+    void table (std::ostream& os) const;
+
+  private: //helpers
+
+    /**
+     * Trains a single fold. Runs on a thread pool task.
+     *
+     * @param i The fold to train
+     * @param net Its network, built by run(). I delete it when done.
+     * @param rnd Its minibatch random generator
+     */
+    void train (const size_t& i, Network* net,
+		const data::RandomInteger& rnd);
+
+  private: //representation
+
+    const data::PatternSet& m_data; ///< the data set all folds share
+    const data::PatternSet& m_target; ///< the data set targets
+    std::vector<std::vector<size_t> > m_train; ///< training part of folds
+    std::vector<std::vector<size_t> > m_test; ///< test part of folds
+    data::Pattern m_mean; ///< input normalisation, subtracted
+    data::Pattern m_stddev; ///< input normalisation, divided
+    TrainerParameters m_par; ///< training parameters
+    sys::Reporter& m_reporter; ///< where to report
+    std::string m_prefix; ///< where to save the best networks, if anywhere
+    std::vector<SweepResult> m_result; ///< one entry per fold
+
+  };
+
+}
+
+#endif /* NETWORK_CROSSVALIDATION_H */
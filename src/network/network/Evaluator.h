@@ -0,0 +1,172 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/Evaluator.h
+ *
+ * @brief Declares a background evaluator of network weight snapshots.
+ */
+
+#ifndef NETWORK_EVALUATOR_H
+#define NETWORK_EVALUATOR_H
+
+#include <vector>
+#include <deque>
+#include <boost/thread.hpp>
+
+#include "network/Network.h"
+#include "data/PatternSet.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * The result of evaluating a network on the test set
+   */
+  typedef struct Evaluation {
+    unsigned int step; ///< the training step at which we evaluated
+    double mse; ///< the MSE on the test set
+    double sp; ///< the SP product on the test set (0 if not available)
+    double monitor_mse; ///< the MSE on the monitored set, if any
+    double monitor_sp; ///< the SP product on the monitored set, if any
+  } Evaluation;
+
+  /**
+   * Evaluates snapshots of a network's weights on a background thread, so
+   * evaluation overlaps with training.
+   *
+   * The evaluator owns a private replica of the network, built at
+   * construction. Weight snapshots are submitted together with the training
+   * step they were taken at, and evaluated in order. Results, together with
+   * the evaluated weights, are collected back by the training thread. At
+   * most <code>depth</code> snapshots can wait for evaluation: submit()
+   * blocks if training runs too far ahead of evaluation.
+   */
+  class Evaluator {
+
+  public: //interface
+
+    /**
+     * Builds the network replica and starts the evaluation thread
+     *
+     * @param net The network whose snapshots will be evaluated
+     * @param test The test set
+     * @param test_target The test set targets
+     * @param monitor An optional additional set to evaluate, or 0
+     * @param monitor_target The monitored set targets, or 0
+     * @param reporter The reporter to inform about changes or errors.
+     * @param depth How many snapshots can wait for evaluation
+     * @param pats If not 0, only these patterns (rows) of the test set are
+     * evaluated. The indexes are not copied and must outlive me.
+     */
+    Evaluator (const Network& net,
+	       const data::PatternSet& test,
+	       const data::PatternSet& test_target,
+	       const data::PatternSet* monitor,
+	       const data::PatternSet* monitor_target,
+	       sys::Reporter& reporter,
+	       const size_t& depth=2,
+	       const std::vector<size_t>* pats=0);
+
+    /**
+     * Evaluates whatever is still pending and stops the thread
+     */
+    virtual ~Evaluator ();
+
+    /**
+     * Hands a weight snapshot for evaluation, blocking if too many are
+     * already waiting
+     *
+     * @param step The training step the snapshot was taken at
+     * @param weights The network weights, as given by Network::copy_weights()
+     */
+    void submit (const unsigned int& step,
+		 const std::vector<data::Feature>& weights);
+
+    /**
+     * Collects the oldest available result. If the evaluation thread
+     * failed, an exception is thrown.
+     *
+     * @param e Where to place the evaluation
+     * @param weights Where to place the weights that were evaluated
+     * @param wait If <code>true</code>, waits for pending evaluations to
+     * finish, otherwise only takes results that are ready.
+     *
+     * @return <code>true</code> if a result was collected; <code>false</code>
+     * if none was ready or, when waiting, if nothing is pending anymore.
+     */
+    bool collect (Evaluation& e, std::vector<data::Feature>& weights,
+		  const bool& wait);
+
+    /**
+     * Evaluates a network on a test set and, optionally, on a monitored
+     * set, right now, in the calling thread.
+     *
+     * @param net The network to evaluate
+     * @param step The training step to tag the evaluation with
+     * @param test The test set
+     * @param test_target The test set targets
+     * @param monitor An optional additional set to evaluate, or 0
+     * @param monitor_target The monitored set targets, or 0
+     * @param pats If not 0, only these patterns (rows) of the test set are
+     * evaluated
+     */
+    static Evaluation evaluate (Network& net, const unsigned int& step,
+				const data::PatternSet& test,
+				const data::PatternSet& test_target,
+				const data::PatternSet* monitor,
+				const data::PatternSet* monitor_target,
+				const std::vector<size_t>* pats=0);
+
+  private: //helpers
+
+    /**
+     * The evaluation thread body
+     */
+    void work (void);
+
+    /**
+     * Runs a set through a network and computes its MSE and SP product
+     *
+     * @param net The network to use
+     * @param data The set to run
+     * @param target The set targets
+     * @param pats If not 0, only these patterns (rows) of the set are run
+     * @param mse Where to place the MSE
+     * @param sp Where to place the SP product (0 if not available)
+     */
+    static void measure (Network& net, const data::PatternSet& data,
+			 const data::PatternSet& target,
+			 const std::vector<size_t>* pats,
+			 double& mse, double& sp);
+
+  private: //not implemented
+
+    Evaluator (const Evaluator& other);
+    Evaluator& operator= (const Evaluator& other);
+
+  private: //representation
+
+    sys::Reporter& m_reporter; ///< where to report
+    Network* m_replica; ///< my private network replica
+    const data::PatternSet& m_test; ///< test set
+    const data::PatternSet& m_test_target; ///< test set targets
+    const data::PatternSet* m_monitor; ///< optional monitored set
+    const data::PatternSet* m_monitor_target; ///< monitored set targets
+    size_t m_depth; ///< how many snapshots may wait
+    const std::vector<size_t>* m_pats; ///< test set subset, if any
+    std::deque<unsigned int> m_step; ///< steps of waiting snapshots
+    std::deque<std::vector<data::Feature> > m_snapshot; ///< waiting weights
+    std::deque<Evaluation> m_result; ///< finished evaluations
+    std::deque<std::vector<data::Feature> > m_evaluated; ///< their weights
+    size_t m_busy; ///< snapshots being evaluated right now
+    bool m_stop; ///< tells the thread to finish
+    bool m_failed; ///< if the thread failed
+    boost::mutex m_mutex; ///< protects all of the above
+    boost::condition_variable m_cond; ///< signals changes on the queues
+    boost::thread m_thread; ///< the evaluation thread
+
+  };
+
+}
+
+#endif /* NETWORK_EVALUATOR_H */
@@ -0,0 +1,189 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/MultiStart.h
+ *
+ * @brief Declares concurrent training of several independently initialised
+ * networks on the same data.
+ */
+
+#ifndef NETWORK_MULTISTART_H
+#define NETWORK_MULTISTART_H
+
+#include <vector>
+#include <string>
+#include <map>
+
+#include "network/Trainer.h"
+#include "data/PatternSet.h"
+#include "config/Header.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * Trains several networks concurrently, one thread per network.
+   *
+   * All networks share the same, read-only, training and test sets, so data
+   * is loaded and held in memory only once. Each network is trained by its
+   * own network::Trainer, with its own minibatch random generator. The
+   * networks themselves should be initialised independently (e.g. by
+   * creating several network::MLP's in sequence) in the calling thread.
+   */
+  class MultiStart {
+
+  public: //interface
+
+    /**
+     * Prepares concurrent training for all networks
+     *
+     * @param nets The networks to train. They are not owned by me.
+     * @param train The training set
+     * @param train_target The training set targets
+     * @param test The test set, used for evaluation
+     * @param test_target The test set targets
+     * @param par The training parameters, common to all networks
+     * @param reporter The reporter to inform about changes or errors.
+     * @param seed The seed for the minibatch random generators. Run
+     * <code>i</code> gets stream <code>2i</code> of a generator with this
+     * seed (see Trainer::Trainer()). If zero is given, that generator is a stream of the run seed
+     * (see data::RandomInteger).
+     */
+    MultiStart (const std::vector<Network*>& nets,
+		const data::PatternSet& train,
+		const data::PatternSet& train_target,
+		const data::PatternSet& test,
+		const data::PatternSet& test_target,
+		const TrainerParameters& par,
+		sys::Reporter& reporter,
+		const size_t& seed=0);
+
+    /**
+     * Destroys the trainers, but not the networks
+     */
+    virtual ~MultiStart ();
+
+    /**
+     * Sets an additional set to be evaluated by all runs, see
+     * Trainer::monitor().
+     *
+     * @param data The set to monitor
+     * @param target The targets of the monitored set
+     */
+    void monitor (const data::PatternSet& data,
+		  const data::PatternSet& target);
+
+    /**
+     * Restricts all runs to subsets of the training and test sets, see
+     * Trainer::subset().
+     *
+     * @param train The patterns (rows) of the training set to draw
+     * minibatches from. If empty, the whole set is used.
+     * @param test The patterns (rows) of the test set to evaluate on. If
+     * empty, the whole set is used.
+     */
+    void subset (const std::vector<size_t>& train,
+		 const std::vector<size_t>& test);
+
+    /**
+     * Weighs the training error of every pattern in all runs, see
+     * Trainer::weights().
+     *
+     * @param weights The weight of every pattern (row) of the training set
+     */
+    void weights (const std::vector<double>& weights);
+
+    /**
+     * Streams the minibatches of all runs from a database file, see
+     * Trainer::stream().
+     *
+     * @param file The database file to stream
+     * @param targets The classes to read and their targets
+     */
+    void stream (const std::string& file,
+		 const std::map<std::string, data::Pattern*>& targets);
+
+    /**
+     * Saves the best network of every run as soon as it is found, in the
+     * background, see Trainer::checkpoint(). The files are the same ones
+     * written by save().
+     *
+     * @param prefix The prefix of the files to save
+     * @param header An optional header for the saved networks
+     */
+    void checkpoint (const std::string& prefix,
+		     const config::Header* header=0);
+
+    /**
+     * Saves the complete training state of every run periodically, see
+     * Trainer::snapshot(). Run <code>i</code> is saved at
+     * <code>prefix.i.state</code>.
+     *
+     * @param prefix The prefix of the files to save
+     * @param every How many evaluations between saves. Zero disables it.
+     */
+    void snapshot (const std::string& prefix, const unsigned int& every);
+
+    /**
+     * Restores the training state of every run from files written by
+     * snapshot(), so run() resumes training where it was, see
+     * Trainer::load().
+     *
+     * @param prefix The prefix of the files to read
+     */
+    void load (const std::string& prefix);
+
+    /**
+     * Returns the run seed the training states were saved with, see
+     * Trainer::run_seed(). All runs share it, so the state of the first
+     * one is read.
+     *
+     * @param prefix The prefix of the files to read
+     */
+    static size_t run_seed (const std::string& prefix);
+
+    /**
+     * Trains all networks concurrently, returning when all are done. A
+     * summary of all runs is reported at the end.
+     */
+    void run (void);
+
+    /**
+     * Returns the number of runs
+     */
+    inline size_t size (void) const { return m_trainer.size(); }
+
+    /**
+     * Returns the trainer for a given run
+     *
+     * @param i The run number, starting from zero
+     */
+    inline const Trainer& trainer (const size_t& i) const
+    { return *m_trainer[i]; }
+
+    /**
+     * Returns the run that produced the best network
+     */
+    size_t best (void) const;
+
+    /**
+     * Saves the best network of every run, resetting each network to its
+     * best weights. The run number is appended to the file name prefix, as
+     * in <code>prefix.3.xml</code>.
+     *
+     * @param prefix The prefix of the files to save
+     * @param header An optional header for the saved networks
+     */
+    void save (const std::string& prefix, const config::Header* header=0);
+
+  private: //representation
+
+    sys::Reporter& m_reporter; ///< where to report
+    std::vector<Trainer*> m_trainer; ///< one trainer per network
+    bool m_msestop; ///< which figure of merit to use
+
+  };
+
+}
+
+#endif /* NETWORK_MULTISTART_H */
@@ -16,6 +16,7 @@
 #include <map>
 
 #include "data/PatternSet.h"
+#include "data/RandomInteger.h"
 #include "config/Network.h"
 #include "network/Neuron.h"
 #include "network/InputNeuron.h"
@@ -42,6 +43,16 @@ namespace network {
      */
     Network (const std::string& config, sys::Reporter& reporter);
 
+    /**
+     * Builds a network from an already loaded configuration. This is handy
+     * to create replicas of an existing network without going through the
+     * filesystem (see dump()).
+     *
+     * @param config The network configuration to use
+     * @param reporter The reporter to inform about changes or errors.
+     */
+    Network (const config::Network& config, sys::Reporter& reporter);
+
     /**
      * Builds a network from a set of neurons and synapses which are
      * <b>already</b> connected and functional
@@ -70,6 +81,38 @@ namespace network {
     virtual bool save (const std::string& file,
 		       const config::Header* header=0) const;
 
+    /**
+     * Dumps the current network state into a newly allocated configuration
+     * object. The caller is responsible for deleting the returned object.
+     *
+     * @param header An optional header to state information about this
+     * (possibly) modified network.
+     */
+    config::Network* dump (const config::Header* header=0) const;
+
+    /**
+     * Creates a deep copy of this network, with the same layout, weights
+     * and learning strategies, without going through the filesystem. Every
+     * neuron and synapse is rebuilt from its own state, so this allocates
+     * a whole new network: replicas (such as the ones of Evaluator or
+     * CheckpointWriter) are cloned once and then kept up to date with
+     * copy() or set_weights(). The caller is responsible for deleting the
+     * returned object.
+     */
+    Network* clone (void) const;
+
+    /**
+     * Copies the synapse weights (biases included, as they are carried by
+     * the synapses leaving bias neurons) of a network with the same layout,
+     * such as one created with clone(), into mine. Nothing is allocated and
+     * the learning strategy state is <b>not</b> touched, so this is the
+     * cheap way to keep a snapshot of the best network seen during
+     * training.
+     *
+     * @param other The network where to copy the weights from
+     */
+    void copy (const Network& other);
+
     /**
      * Dumps the current network layout to a dot-file (graphviz)
      *
@@ -98,6 +141,21 @@ namespace network {
      */
     virtual void run (const data::PatternSet& input, 
 		      data::PatternSet& output);
+
+    /**
+     * Runs a subset of a PatternSet over the network and gets the
+     * results. Only the patterns listed in <code>pats</code> are run, and
+     * they are read directly from the input set, so no copy of the selected
+     * patterns is ever made.
+     *
+     * @param input The PatternSet where to take the patterns from
+     * @param pats The patterns (rows) of <code>input</code> to run
+     * @param output The output of the network is placed at this PatternSet,
+     * one pattern per entry in <code>pats</code>
+     */
+    virtual void run (const data::PatternSet& input,
+		      const std::vector<size_t>& pats,
+		      data::PatternSet& output);
     
     /**
      * Trains the network with this Pattern.
@@ -122,7 +180,9 @@ namespace network {
      * Trains the network with this PatternSet. The training data is chosen
      * from the "data" PatternSet randomly, a number of times it is enough to
      * fill in an epoch. The targets are selected accordingly to keep the
-     * system synchronised.
+     * system synchronised. The patterns are drawn by a generator of my own,
+     * which is a stream of the run seed, so different networks can be
+     * trained this way in different threads.
      *
      * @param data The PatternSet to train the neural network with.
      * @param target What is the network target for this supervisionised
@@ -134,6 +194,39 @@ namespace network {
 			const data::PatternSet& target,
 			unsigned int epoch);
 
+    /**
+     * Trains the network with a subset of a PatternSet. Only the patterns
+     * listed in <code>pats</code> are used, and they, together with their
+     * targets, are read directly from the given sets. This is the preferred
+     * way to do minibatch training, as no minibatch copy is ever made.
+     *
+     * @param data The PatternSet to train the neural network with.
+     * @param target What is the network target for this supervisionised
+     * training system.
+     * @param pats The patterns (rows) of <code>data</code> and
+     * <code>target</code> to use in this training step.
+     */
+    virtual void train (const data::PatternSet& data,
+			const data::PatternSet& target,
+			const std::vector<size_t>& pats);
+
+    /**
+     * Trains the network with a subset of a PatternSet, as above, weighing
+     * the error of every pattern, e.g. to balance classes of different
+     * sizes without copying them (see data::Database::balance_weights()).
+     *
+     * @param data The PatternSet to train the neural network with.
+     * @param target What is the network target for this supervisionised
+     * training system.
+     * @param pats The patterns (rows) of <code>data</code> and
+     * <code>target</code> to use in this training step.
+     * @param weights The weight of every pattern (row) of <code>data</code>
+     */
+    virtual void train (const data::PatternSet& data,
+			const data::PatternSet& target,
+			const std::vector<size_t>& pats,
+			const std::vector<double>& weights);
+
     /**
      * Returns the number of input neurons
      */
@@ -144,6 +237,108 @@ namespace network {
      */
     inline size_t output_size (void) const { return m_output.size(); }
 
+    /**
+     * Returns the number of synapses
+     */
+    inline size_t synapse_size (void) const { return m_synapse.size(); }
+
+    /**
+     * Copies all synapse weights, ordered by synapse identifier, into the
+     * given vector, which is resized if required.
+     *
+     * @param w Where to place the weights
+     */
+    void copy_weights (std::vector<data::Feature>& w) const;
+
+    /**
+     * Resets all synapse weights, ordered by synapse identifier, from the
+     * given vector. The learning strategy state is <b>not</b> touched.
+     *
+     * @param w The new weights, one per synapse
+     */
+    void set_weights (const std::vector<data::Feature>& w);
+
+    /**
+     * Computes the averaged error derivative of every synapse weight,
+     * ordered by synapse identifier, for a subset of a PatternSet, without
+     * changing any weight or learning strategy state. Derivatives computed
+     * this way on different data can be averaged and then applied with
+     * update(), which is equivalent to training with all the data at once.
+     *
+     * @param data The PatternSet to compute the derivatives with
+     * @param target The targets for <code>data</code>
+     * @param pats The patterns (rows) of <code>data</code> and
+     * <code>target</code> to use
+     * @param grad Where to place the derivatives, one per synapse. It is
+     * resized if required.
+     */
+    void gradient (const data::PatternSet& data,
+		   const data::PatternSet& target,
+		   const std::vector<size_t>& pats,
+		   std::vector<data::Feature>& grad);
+
+    /**
+     * Adjusts all synapse weights with their learning strategies, given
+     * averaged error derivatives such as the ones computed by gradient().
+     *
+     * @param grad The derivatives, one per synapse, ordered by synapse
+     * identifier
+     */
+    void update (const std::vector<data::Feature>& grad);
+
+    /**
+     * Copies the state of every synapse (weight and learning strategy
+     * state, see Synapse::copy_state()), ordered by synapse identifier. This is
+     * all it takes to resume training exactly where it was, on a network
+     * with the same layout.
+     *
+     * @param s Where to place the states, one per synapse
+     */
+    void copy_state (std::vector<std::vector<data::Feature> >& s) const;
+
+    /**
+     * Restores the state of every synapse, as taken by the method above.
+     *
+     * @param s The states to restore, one per synapse
+     */
+    void set_state (const std::vector<std::vector<data::Feature> >& s);
+
+    /**
+     * Freezes (or unfreezes) all synapses that do <b>not</b> end at an
+     * output neuron, so that only the output layer learns. This is done
+     * through Synapse::learning().
+     *
+     * @param frozen If <code>true</code>, the synapses stop learning,
+     * otherwise they learn again.
+     */
+    void freeze (const bool& frozen=true);
+
+    /**
+     * Builds a new network made only of my output layer, i.e., of my output
+     * neurons and the synapses that reach them. The neurons feeding those
+     * synapses are replaced by input neurons without normalisation, one per
+     * feature of <code>features</code>. The whole input set is run through
+     * me once and the state of those feeding neurons is cached into
+     * <code>features</code>, so the returned network can be trained on them
+     * directly. This only makes sense if the rest of the network is frozen
+     * (see freeze()). The caller is responsible for deleting the returned
+     * network.
+     *
+     * @param input The PatternSet to compute the cached features from
+     * @param features Where to place the cached features, one pattern for
+     * each pattern of <code>input</code>.
+     */
+    Network* output_layer (const data::PatternSet& input,
+			   data::PatternSet& features);
+
+    /**
+     * Copies the synapse weights of a network created by output_layer()
+     * back into my own output layer.
+     *
+     * @param layer The network where to copy the weights from
+     */
+    void output_layer (const Network& layer);
+
     /**
      * Returns the current reporter.
      */
@@ -168,6 +363,23 @@ namespace network {
     void adopt (const std::vector<network::Neuron*>& neurons,
 		const std::vector<network::Synapse*>& synapses);
 
+  private: //helpers
+
+    /**
+     * Builds neurons and synapses following my current configuration
+     */
+    void build (void);
+
+    /**
+     * Feeds the selected patterns of a PatternSet through the input and
+     * bias neurons, setting the network state.
+     *
+     * @param input The PatternSet where to take the patterns from
+     * @param pats The patterns (rows) of <code>input</code> to feed
+     */
+    void feed (const data::PatternSet& input,
+	       const std::vector<size_t>& pats);
+
   private: //representation
 
     config::Network* m_config; ///< my private configuration
@@ -177,6 +389,7 @@ namespace network {
     std::vector<BiasNeuron*> m_bias; ///< my bias neurons
     std::vector<OutputNeuron*> m_output; ///< my output neurons
     std::map<unsigned int, Synapse*> m_synapse; ///< my synapses
+    data::RandomInteger m_rnd; ///< draws minibatches for train(..., epoch)
   };
 
 }
@@ -0,0 +1,231 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/Sweep.h
+ *
+ * @brief Declares a parallel hyper-parameter sweep over MLP configurations.
+ */
+
+#ifndef NETWORK_SWEEP_H
+#define NETWORK_SWEEP_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+#include "network/Trainer.h"
+#include "data/Pattern.h"
+#include "data/PatternSet.h"
+#include "config/type.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * One MLP configuration of a sweep
+   */
+  typedef struct SweepPoint {
+    unsigned int hidden; ///< the number of hidden neurons
+    unsigned int epoch; ///< how many patterns per training step
+    config::SynapseStrategyType strategy; ///< how synapses learn
+    double lrate; ///< learning rate (BackProp) or weight update (RProp)
+    double momentum; ///< momentum (BackProp only)
+    double decay; ///< learning rate decay (BackProp only)
+  } SweepPoint;
+
+  /**
+   * The outcome of training one configuration of a sweep
+   */
+  typedef struct SweepResult {
+    SweepPoint point; ///< the configuration trained
+    Evaluation best; ///< the best evaluation seen
+    unsigned int steps; ///< how many training steps were performed
+    double elapsed; ///< the training time, in seconds
+    bool failed; ///< if training this configuration failed
+    std::string error; ///< why it failed, if it did
+  } SweepResult;
+
+  /**
+   * Trains one MLP per configuration, concurrently, on data loaded only
+   * once.
+   *
+   * Configurations are either added one by one, as a grid (all
+   * combinations of the given values) or by random search (random
+   * combinations of the given values). All MLP's share the input
+   * normalisation, the activation function (hyperbolic tangent) and the
+   * training, test and target sets, which are never copied. Each
+   * configuration is trained by a network::Trainer, on a sys::ThreadPool
+   * task, with the TrainerParameters given at construction except for the
+   * epoch, which comes from the configuration.
+   */
+  class Sweep {
+
+  public: //interface
+
+    /**
+     * Prepares a sweep
+     *
+     * @param train The training set
+     * @param train_target The training set targets
+     * @param test The test set, used for evaluation
+     * @param test_target The test set targets
+     * @param mean The mean to subtract from the inputs of every MLP
+     * @param stddev The value to divide the inputs of every MLP by
+     * @param par The training parameters, common to all configurations
+     * @param reporter The reporter to inform about changes or errors.
+     */
+    Sweep (const data::PatternSet& train,
+	   const data::PatternSet& train_target,
+	   const data::PatternSet& test,
+	   const data::PatternSet& test_target,
+	   const data::Pattern& mean,
+	   const data::Pattern& stddev,
+	   const TrainerParameters& par,
+	   sys::Reporter& reporter);
+
+    /**
+     * Destructor virtualisation
+     */
+    virtual ~Sweep ();
+
+    /**
+     * Restricts the training of all configurations to a subset of the
+     * training set, e.g. to balance its classes, see Trainer::subset().
+     *
+     * @param train The patterns (rows) of the training set to draw
+     * minibatches from. If empty, the whole set is used.
+     */
+    void subset (const std::vector<size_t>& train);
+
+    /**
+     * Adds a single configuration
+     *
+     * @param p The configuration to add
+     */
+    void add (const SweepPoint& p);
+
+    /**
+     * Adds all combinations of the given values
+     *
+     * @param hidden The hidden layer sizes to try
+     * @param epoch The epoch sizes to try
+     * @param strategy How synapses learn
+     * @param lrate The learning rates (BackProp) or weight updates (RProp)
+     * to try
+     * @param momentum The momenta to try (BackProp only)
+     * @param decay The learning rate decay, common to all configurations
+     * (BackProp only)
+     */
+    void grid (const std::vector<unsigned int>& hidden,
+	       const std::vector<unsigned int>& epoch,
+	       const config::SynapseStrategyType& strategy,
+	       const std::vector<double>& lrate,
+	       const std::vector<double>& momentum,
+	       const double& decay=1);
+
+    /**
+     * Adds configurations made of randomly chosen values. Parameters are
+     * as for grid().
+     *
+     * @param n How many configurations to add
+     * @param seed The seed for the random choices. If zero is given, a time
+     * based seed is used.
+     */
+    void random (const size_t& n,
+		 const std::vector<unsigned int>& hidden,
+		 const std::vector<unsigned int>& epoch,
+		 const config::SynapseStrategyType& strategy,
+		 const std::vector<double>& lrate,
+		 const std::vector<double>& momentum,
+		 const double& decay=1,
+		 const size_t& seed=0);
+
+    /**
+     * Optionally saves the best network of every configuration, as
+     * <code>prefix.i.xml</code>, when it is done training.
+     *
+     * @param prefix The prefix of the files to save. If empty, nothing is
+     * saved.
+     */
+    inline void save (const std::string& prefix) { m_prefix = prefix; }
+
+    /**
+     * Trains all configurations, returning when all are done
+     *
+     * @param threads How many configurations to train concurrently. If zero
+     * is given, one per hardware thread.
+     */
+    void run (const size_t& threads=0);
+
+    /**
+     * Returns the number of configurations
+     */
+    inline size_t size (void) const { return m_result.size(); }
+
+    /**
+     * Returns the outcome of all configurations, valid after run()
+     */
+    inline const std::vector<SweepResult>& results (void) const
+    { return m_result; }
+
+    /**
+     * Returns the configuration that produced the best network
+     */
+    size_t best (void) const;
+
+    /**
+     * Writes a summary table, one line per configuration
+     *
+     * @param os Where to write the table
+     */
+    void table (std::ostream& os) const;
+
+    /**
+     * Builds the MLP of a configuration. MLP's are built from static
+     * counters and generators, so this has to be called from a single
+     * thread, in a fixed order, for the initial weights to be reproducible.
+     * The caller is responsible for deleting the returned network.
+     *
+     * @param p The configuration
+     * @param input The number of inputs
+     * @param output The number of outputs
+     * @param mean The mean to subtract from the inputs
+     * @param stddev The value to divide the inputs by
+     * @param reporter The reporter to inform about changes or errors.
+     */
+    static Network* build (const SweepPoint& p, const size_t& input,
+			   const size_t& output, const data::Pattern& mean,
+			   const data::Pattern& stddev,
+			   sys::Reporter& reporter);
+
+  private: //helpers
+
+    /**
+     * Trains a single configuration. Runs on a thread pool task.
+     *
+     * @param i The configuration to train
+     * @param net Its network, built by run(). I delete it when done.
+     * @param rnd Its minibatch random generator
+     */
+    void train (const size_t& i, Network* net,
+		const data::RandomInteger& rnd);
+
+  private: //representation
+
+    const data::PatternSet& m_train; ///< training set
+    const data::PatternSet& m_train_target; ///< training set targets
+    std::vector<size_t> m_train_pats; ///< training subset, if any
+    const data::PatternSet& m_test; ///< test set
+    const data::PatternSet& m_test_target; ///< test set targets
+    data::Pattern m_mean; ///< input normalisation, subtracted
+    data::Pattern m_stddev; ///< input normalisation, divided
+    TrainerParameters m_par; ///< common training parameters
+    sys::Reporter& m_reporter; ///< where to report
+    std::string m_prefix; ///< where to save the best networks, if anywhere
+    std::vector<SweepResult> m_result; ///< one entry per configuration
+
+  };
+
+}
+
+#endif /* NETWORK_SWEEP_H */
@@ -17,6 +17,7 @@
 #include "config/type.h"
 #include "config/Synapse.h"
 #include "config/Parameter.h"
+#include <vector>
 
 namespace strategy {
   class SynapseStrategy; ///< forward
@@ -102,6 +103,34 @@ namespace network {
      */
     void learning (const bool& switch_to);
 
+    /**
+     * Changes whether the Synapse defers its weight adjustment.
+     *
+     * While deferring, learn() still propagates the error signal backwards,
+     * but instead of asking its strategy for a weight adjustment, the
+     * Synapse only records the averaged error derivative for its weight,
+     * which can be retrieved with derivative() and, possibly after being
+     * combined with derivatives computed elsewhere, applied with update().
+     *
+     * @param switch_to Shall I defer weight adjustments?
+     */
+    void defer (const bool& switch_to);
+
+    /**
+     * Returns the averaged error derivative recorded by the last call to
+     * learn() while deferring weight adjustments.
+     */
+    data::Feature derivative (void) const { return m_deriv; }
+
+    /**
+     * Adjusts the Synapse weight using its strategy and an averaged error
+     * derivative computed outside learn(). Nothing happens if the Synapse
+     * cannot learn.
+     *
+     * @param deriv The averaged error derivative for my weight
+     */
+    void update (const data::Feature& deriv);
+
     /**
      * Connect two Neurons together using this Synapse.
      *
@@ -148,6 +177,29 @@ namespace network {
      */
     data::Feature weight (void) const { return m_weight; }
 
+    /**
+     * Resets the Synapse weight. The learning strategy state is left
+     * untouched.
+     *
+     * @param w The new weight value
+     */
+    void weight (const data::Feature& w) { m_weight = w; }
+
+    /**
+     * Copies my weight followed by the learning state of my strategy, so
+     * training can later be resumed exactly where it was.
+     *
+     * @param s Where to place my state. It is resized as required.
+     */
+    void copy_state (std::vector<data::Feature>& s) const;
+
+    /**
+     * Restores a state previously taken with the method above.
+     *
+     * @param s The state to restore
+     */
+    void set_state (const std::vector<data::Feature>& s);
+
     /**
      * Default meaning
      *
@@ -195,6 +247,8 @@ namespace network {
     network::Neuron* m_in; ///< The Neuron connected to the input
     network::Neuron* m_out; ///< The Neuron connected to the output
     bool m_learns; ///< If this Synapse is able to learn
+    bool m_defer; ///< If this Synapse defers its weight adjustments
+    data::Feature m_deriv; ///< The last error derivative, when deferring
     data::Ensemble m_state; ///< This is the Synapse's current state
     config::SynapseStrategyType m_strategy; ///< This synapse's learn strategy
     strategy::SynapseStrategy* m_teacher; ///< the learning object
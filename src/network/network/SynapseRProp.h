@@ -59,6 +59,28 @@ namespace strategy {
     virtual data::Feature teach (const data::Ensemble& input,
                                  const data::Ensemble& lesson);
 
+    /**
+     * Implements the weight adjustment for Resilient BackPropagation, given an
+     * already averaged error derivative
+     *
+     * @param deriv The mean of <code>lesson*input</code> over a training step
+     */
+    virtual data::Feature update (const data::Feature& deriv);
+
+    /**
+     * Copies my learning state (weight update, previous delta and previous derivative)
+     *
+     * @param s Where to place my learning state
+     */
+    virtual void copy_state (std::vector<data::Feature>& s) const;
+
+    /**
+     * Restores my learning state
+     *
+     * @param s The learning state to restore
+     */
+    virtual void set_state (const std::vector<data::Feature>& s);
+
     /**
      * Dumps my configuration parameters on this configuration item
      */
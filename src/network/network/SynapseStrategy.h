@@ -12,6 +12,7 @@
 
 #include "data/Ensemble.h"
 #include "data/Feature.h"
+#include <vector>
 
 /**
  * The Strategy package includes algorithms for network learning and
@@ -49,6 +50,33 @@ namespace strategy {
      */
     virtual data::Feature teach (const data::Ensemble& input,
 				 const data::Ensemble& lesson) = 0;
+
+    /**
+     * Returns the weight adjustment given an error derivative that was
+     * already averaged over the patterns of a training step, i.e., the mean
+     * of <code>lesson*input</code>. This allows derivatives computed
+     * elsewhere (on other processes, for instance) to be combined before the
+     * synapse weight is changed. teach() should be equivalent to calling
+     * this method with the derivative it computes.
+     *
+     * @param deriv The averaged error derivative for the synapse weight
+     */
+    virtual data::Feature update (const data::Feature& deriv) = 0;
+
+    /**
+     * Copies everything that changes while I teach into a vector, so
+     * training can later be resumed exactly where it was.
+     *
+     * @param s Where to place my learning state. It is resized as required.
+     */
+    virtual void copy_state (std::vector<data::Feature>& s) const = 0;
+
+    /**
+     * Restores a learning state previously taken with the method above.
+     *
+     * @param s The learning state to restore
+     */
+    virtual void set_state (const std::vector<data::Feature>& s) = 0;
     
   };
 
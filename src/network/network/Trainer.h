@@ -0,0 +1,381 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/Trainer.h
+ *
+ * @brief Declares a complete training session for a single network,
+ * including periodic evaluation, best network tracking and stopping
+ * criteria.
+ */
+
+#ifndef NETWORK_TRAINER_H
+#define NETWORK_TRAINER_H
+
+#include <vector>
+#include <string>
+#include <map>
+
+#include "network/Network.h"
+#include "network/Evaluator.h"
+#include "network/CheckpointWriter.h"
+#include "data/PatternSet.h"
+#include "data/Pattern.h"
+#include "data/RandomInteger.h"
+#include "sys/Reporter.h"
+
+namespace network {
+
+  /**
+   * The parameters that control a training session
+   */
+  typedef struct TrainerParameters {
+    unsigned int epoch; ///< how many patterns per training step
+    unsigned int sample; ///< how many steps between evaluations
+    unsigned int stopiter; ///< evaluations w/o variation to stop
+    double stopthres; ///< relative variation considered as no variation
+    unsigned int hardstop; ///< maximum number of training steps
+    bool msestop; ///< use the MSE instead of the SP product as merit figure
+    bool background; ///< evaluate on a background thread, see Evaluator
+    bool prefetch; ///< prepare minibatches on a background thread
+    double subsample; ///< fraction of the test set to screen with, or 0
+    double tolerance; ///< relative distance to the best to fully evaluate
+
+    /**
+     * Sets the defaults used by mlp-train
+     */
+    TrainerParameters ()
+      : epoch(50), sample(10), stopiter(50), stopthres(0.001),
+	hardstop(10000), msestop(false), background(false),
+	prefetch(false), subsample(0), tolerance(0.05) {}
+  } TrainerParameters;
+
+  /**
+   * A screening decision, see TrainerParameters::subsample
+   */
+  typedef struct Screening {
+    Evaluation quick; ///< the evaluation on the test subsample
+    bool evaluated; ///< if the whole test set was evaluated afterwards
+  } Screening;
+
+  /**
+   * Trains a single network until one of its stop criteria is met.
+   *
+   * The network is trained with randomly chosen minibatches of the training
+   * set and, every TrainerParameters::sample steps, evaluated on the test
+   * set. Training stops when the relative variation of the figure of merit
+   * (SP product or MSE) stays below TrainerParameters::stopthres for
+   * TrainerParameters::stopiter consecutive evaluations, or when
+   * TrainerParameters::hardstop steps are reached. The weights of the best
+   * evaluated network are kept.
+   *
+   * If TrainerParameters::background is set, evaluations run on a
+   * network::Evaluator thread, against snapshots of the weights, while
+   * training goes on. Stop criteria are then checked as results arrive, so
+   * training may run a few sampling periods past the point where it would
+   * have stopped otherwise. Those extra steps never change the best network
+   * found, since every snapshot is evaluated.
+   *
+   * If TrainerParameters::prefetch is set, minibatches are drawn and
+   * gathered into contiguous buffers by a data::Prefetcher thread, while
+   * the previous minibatch is being trained on. The draws then come from a
+   * generator seeded by mine, so training is still reproducible, but a
+   * saved training state (see save()) does not resume it exactly. The
+   * minibatches can also be streamed from a database file, see stream().
+   *
+   * If TrainerParameters::subsample is set, every evaluation is first
+   * screened on a fixed, stratified subsample of the test set, drawn once
+   * with that fraction of the patterns of every target. Only networks whose
+   * subsample figure of merit is within TrainerParameters::tolerance
+   * (relative) of the best one seen so far are evaluated on the whole test
+   * set. Networks that are skipped are not recorded, but the variation of
+   * their subsample figure of merit counts for the stop criterium, as the
+   * figures of recorded networks do. Every decision is kept, see
+   * screening().
+   *
+   * Every new best network can also be saved while training goes on, see
+   * checkpoint().
+   *
+   * A Trainer does not report through its reporter while it runs, so many of
+   * them can run concurrently on different networks sharing the same
+   * (read-only) data sets.
+   */
+  class Trainer {
+
+  public: //interface
+
+    /**
+     * Prepares a training session
+     *
+     * @param net The network to train
+     * @param train The training set
+     * @param train_target The training set targets
+     * @param test The test set, used for evaluation
+     * @param test_target The test set targets
+     * @param par The training parameters
+     * @param reporter The reporter to inform about changes or errors.
+     * @param rnd The minibatch random generator, which I copy. It can be
+     * a seed, or a stream of another generator. If none is given, a stream
+     * of the run seed is taken here, in the calling thread (see
+     * data::RandomInteger). My screening subsample is drawn from its first
+     * stream, i.e. the stream that follows it, so trainers given streams of
+     * the same generator should get every other stream of it.
+     */
+    Trainer (Network& net,
+	     const data::PatternSet& train,
+	     const data::PatternSet& train_target,
+	     const data::PatternSet& test,
+	     const data::PatternSet& test_target,
+	     const TrainerParameters& par,
+	     sys::Reporter& reporter,
+	     const data::RandomInteger& rnd=data::RandomInteger());
+
+    /**
+     * Destructor virtualisation
+     */
+    virtual ~Trainer ();
+
+    /**
+     * Sets an additional set to be evaluated together with the test set,
+     * typically the original training set. Its figures are only recorded,
+     * they never influence training.
+     *
+     * @param data The set to monitor
+     * @param target The targets of the monitored set
+     */
+    void monitor (const data::PatternSet& data,
+		  const data::PatternSet& target);
+
+    /**
+     * Restricts training and evaluation to subsets of the training and test
+     * sets, given as pattern indexes. Nothing is copied, so many trainers
+     * can share the same sets with different subsets, as in
+     * cross-validation (see data::Database::kfold()). Patterns may be
+     * repeated, to oversample them, e.g. to balance classes (see
+     * data::Database::balance_index()).
+     *
+     * @param train The patterns (rows) of the training set to draw
+     * minibatches from. If empty, the whole set is used.
+     * @param test The patterns (rows) of the test set to evaluate on. If
+     * empty, the whole set is used.
+     */
+    void subset (const std::vector<size_t>& train,
+		 const std::vector<size_t>& test);
+
+    /**
+     * Weighs the training error of every pattern, e.g. to balance classes
+     * without oversampling them (see data::Database::balance_weights()).
+     * Weights are not available with TrainerParameters::prefetch, as
+     * prefetched minibatches are copies.
+     *
+     * @param weights The weight of every pattern (row) of the training
+     * set. If empty, all patterns weigh the same.
+     */
+    void weights (const std::vector<double>& weights);
+
+    /**
+     * Streams the minibatches from a database file (see data::FileSource)
+     * instead of drawing them from the training set, so the training
+     * database does not have to fit in memory. This implies
+     * TrainerParameters::prefetch. The training set given to me is then
+     * only used for its pattern sizes, and may hold a few patterns of the
+     * file. Classes are balanced by taking patterns from them in turn.
+     *
+     * @param file The database file to stream. An empty name stops
+     * streaming.
+     * @param targets The classes to read and their targets, as given to
+     * data::Database::set_target(). They must live until run() starts.
+     */
+    void stream (const std::string& file,
+		 const std::map<std::string, data::Pattern*>& targets);
+
+    /**
+     * Saves every new best network to a file, as it is found, using a
+     * background network::CheckpointWriter. run() only returns after the
+     * last best network is on disk.
+     *
+     * @param file The file to write
+     * @param header An optional header for the saved networks
+     */
+    void checkpoint (const std::string& file,
+		     const config::Header* header=0);
+
+    /**
+     * Saves my complete training state to a file every <code>every</code>
+     * evaluations, and when run() returns, so training can be resumed with
+     * load() if the process is killed. See save().
+     *
+     * @param file The file to write
+     * @param every How many evaluations between saves. Zero disables it.
+     */
+    void snapshot (const std::string& file, const unsigned int& every);
+
+    /**
+     * Saves my complete training state to a text file: the run seed (see
+     * data::RandomInteger::run_seed()), the state of every synapse (weight
+     * and learning strategy state), the state of both random generators,
+     * the number of steps performed, the stop criterium countdown, the
+     * evaluation and screening histories and the best network. Numbers are
+     * written with enough precision to be read back exactly. Calling load()
+     * on a Trainer with the same parameters, data and network layout, in a
+     * run with the same seed, resumes training exactly where it was: if
+     * evaluations run in the calling thread and minibatches are not
+     * prefetched, the resumed training is identical to an uninterrupted
+     * one.
+     *
+     * @param file The file to write
+     */
+    void save (const std::string& file) const;
+
+    /**
+     * Restores a training state written by save(). The network must have
+     * the same layout as the one that was saved, and the run seed must be
+     * the one the state was saved with (see run_seed()).
+     *
+     * @param file The file to read
+     */
+    void load (const std::string& file);
+
+    /**
+     * Returns the run seed a training state was saved with, so a resumed
+     * run can set it before anything is drawn.
+     *
+     * @param file The training state file to read
+     */
+    static size_t run_seed (const std::string& file);
+
+    /**
+     * Trains the network until a stop criterium is met.
+     */
+    void run (void);
+
+    /**
+     * Evaluates the network on the test set, right now.
+     *
+     * @param step The training step to tag the evaluation with
+     */
+    Evaluation evaluate (const unsigned int& step);
+
+    /**
+     * Returns the network being trained
+     */
+    inline Network& network (void) { return m_net; }
+
+    /**
+     * Returns the number of training steps performed so far
+     */
+    inline unsigned int steps (void) const { return m_steps; }
+
+    /**
+     * Returns the best evaluation seen so far
+     */
+    inline const Evaluation& best (void) const { return m_best; }
+
+    /**
+     * Returns the weights of the best network seen so far
+     */
+    inline const std::vector<data::Feature>& best_weights (void) const
+    { return m_best_weights; }
+
+    /**
+     * Returns all evaluations performed so far
+     */
+    inline const std::vector<Evaluation>& history (void) const
+    { return m_history; }
+
+    /**
+     * Returns the wall-clock time spent in run(), in seconds
+     */
+    inline double elapsed (void) const { return m_elapsed; }
+
+    /**
+     * Returns how many evaluations were skipped after being screened on the
+     * test subsample, see TrainerParameters::subsample
+     */
+    inline unsigned int skipped (void) const { return m_skipped; }
+
+    /**
+     * Returns all screening decisions taken so far, see
+     * TrainerParameters::subsample
+     */
+    inline const std::vector<Screening>& screening (void) const
+    { return m_screening; }
+
+  private: //helpers
+
+    /**
+     * Tells if an evaluation is better than the best seen so far
+     *
+     * @param e The evaluation to compare
+     */
+    bool better (const Evaluation& e) const;
+
+    /**
+     * Records an evaluation in my history, tracks the best network and
+     * updates the stop criterium
+     *
+     * @param e The evaluation to record
+     * @param weights The weights that were evaluated, or 0 to take the
+     * current network weights
+     */
+    void record (const Evaluation& e,
+		 const std::vector<data::Feature>* weights);
+
+    /**
+     * Updates the stop criterium with the variation of a figure of merit
+     *
+     * @param prev The previous figure of merit
+     * @param val The current figure of merit
+     */
+    void countdown (const double& prev, const double& val);
+
+    /**
+     * Draws the stratified test subsample used for screening
+     */
+    void stratify (void);
+
+    /**
+     * Evaluates the network on the test subsample and tells if it comes
+     * close enough to the best seen so far to be fully evaluated
+     *
+     * @param step The training step to tag the evaluation with
+     */
+    bool screen (const unsigned int& step);
+
+  private: //representation
+
+    Network& m_net; ///< the network being trained
+    const data::PatternSet& m_train; ///< training set
+    const data::PatternSet& m_train_target; ///< training set targets
+    const data::PatternSet& m_test; ///< test set
+    const data::PatternSet& m_test_target; ///< test set targets
+    std::vector<size_t> m_train_pats; ///< training subset, if any
+    std::vector<size_t> m_test_pats; ///< test subset, if any
+    std::vector<double> m_weights; ///< training pattern weights, if any
+    std::vector<size_t> m_quick; ///< the test subsample to screen with
+    const data::PatternSet* m_monitor; ///< optional monitored set
+    const data::PatternSet* m_monitor_target; ///< monitored set targets
+    TrainerParameters m_par; ///< my parameters
+    sys::Reporter& m_reporter; ///< where to report
+    data::RandomInteger m_rnd; ///< my private minibatch generator
+    data::RandomInteger m_quick_rnd; ///< draws the screening subsample
+    unsigned int m_steps; ///< training steps done so far
+    Evaluation m_best; ///< the best evaluation so far
+    std::vector<data::Feature> m_best_weights; ///< best network weights
+    std::vector<Evaluation> m_history; ///< all evaluations
+    CheckpointWriter* m_writer; ///< where to save best networks, if anywhere
+    double m_elapsed; ///< time spent training
+    unsigned int m_stopnow; ///< evaluations left w/o variation to stop
+    double m_val; ///< the figure of merit at the last evaluation
+    std::string m_state_file; ///< where to save my training state
+    unsigned int m_state_every; ///< evaluations between state saves
+    unsigned int m_skipped; ///< evaluations skipped after screening
+    double m_quick_val; ///< the figure of merit at the last screening
+    std::vector<Screening> m_screening; ///< all screening decisions
+    std::string m_stream; ///< the database file to stream, if any
+    std::map<std::string, data::Pattern*> m_stream_targets; ///< its targets
+
+  };
+
+}
+
+#endif /* NETWORK_TRAINER_H */
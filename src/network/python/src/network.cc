@@ -8,6 +8,9 @@
 #include <boost/python.hpp>
 #include <boost/shared_ptr.hpp>
 #include "network/MLP.h"
+#include "network/AsyncTrainer.h"
+#include "network/CachedTrainer.h"
+#include "network/MultiStart.h"
 
 using namespace boost::python;
 
@@ -57,19 +60,71 @@ boost::shared_ptr<network::MLP> make_network_2(const size_t input,
         syn_strat_type, syn_params, input_subtract, input_divide, reporter));
 }
 
+boost::shared_ptr<network::MultiStart> make_multistart(list nets,
+    const data::PatternSet& train, const data::PatternSet& train_target,
+    const data::PatternSet& test, const data::PatternSet& test_target,
+    const network::TrainerParameters& par, sys::Reporter& reporter, 
+    const size_t seed) {
+  std::vector<network::Network*> n;
+  const size_t size = len(nets);
+  for (size_t i=0; i<size; ++i) {
+    n.push_back(extract<network::Network*>(nets[i]));
+  }
+  return boost::shared_ptr<network::MultiStart>(new network::MultiStart(n,
+        train, train_target, test, test_target, par, reporter, seed));
+}
+
+boost::shared_ptr<network::Network> network_clone(const network::Network& n) {
+  return boost::shared_ptr<network::Network>(n.clone());
+}
+
+list network_gradient(network::Network& n, const data::PatternSet& data,
+    const data::PatternSet& target, list pats) {
+  std::vector<size_t> p;
+  const size_t size = len(pats);
+  for (size_t i=0; i<size; ++i) p.push_back(extract<size_t>(pats[i]));
+  std::vector<data::Feature> grad;
+  n.gradient(data, target, p, grad);
+  list retval;
+  for (size_t i=0; i<grad.size(); ++i) retval.append(grad[i]);
+  return retval;
+}
+
+void network_update(network::Network& n, list grad) {
+  std::vector<data::Feature> g;
+  const size_t size = len(grad);
+  for (size_t i=0; i<size; ++i) g.push_back(extract<data::Feature>(grad[i]));
+  n.update(g);
+}
+
+list trainer_history(const network::Trainer& t) {
+  list retval;
+  for (size_t i=0; i<t.history().size(); ++i) retval.append(t.history()[i]);
+  return retval;
+}
+
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(save_overloads, save, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ms_save_overloads, save, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(tr_checkpoint_overloads, checkpoint, 1, 2)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(ms_checkpoint_overloads, checkpoint, 1, 2)
 
 void bind_network()
 {
   class_<network::Network, boost::shared_ptr<network::Network>, boost::noncopyable>("Network", "Interface to load/save network data from files", init<const std::string&, sys::Reporter&>())
     .def("save", &network::Network::save, save_overloads((arg("self"), arg("filename")), "Saves the current network into a XML file."))
+    .def("clone", &network_clone, (arg("self")), "A deep copy of this network, made in memory")
+    .def("copy", &network::Network::copy, (arg("self"), arg("other")), "Copies the weights of a network with the same layout (e.g. a clone) into mine")
     .def("dot", &network::Network::dot, (arg("self"), arg("filename")), "Draws using dot, the current network")
     .add_property("input_size", &network::Network::input_size)
     .add_property("output_size", &network::Network::output_size)
+    .add_property("synapse_size", &network::Network::synapse_size)
     .def("train", (void (network::Network::*)(const data::Pattern&, const data::Pattern&))&network::Network::train, (arg("self"), arg("data"), arg("target")), "Single-step training")
     .def("train", (void (network::Network::*)(const data::PatternSet&, const data::PatternSet&))&network::Network::train, (arg("self"), arg("data"), arg("target")), "Train using all data from the given set, in a single step")
     .def("run", (void (network::Network::*)(const data::Pattern&, data::Pattern&))&network::Network::run, (arg("self"), arg("input"), arg("output")), "Single test")
     .def("run", (void (network::Network::*)(const data::PatternSet&, data::PatternSet&))&network::Network::run, (arg("self"), arg("input"), arg("output")), "Batch test")
+    .def("gradient", &network_gradient, (arg("self"), arg("data"), arg("target"), arg("patterns")), "Averaged error derivatives of all synapse weights for the given patterns, ordered by synapse id. Weights are not changed.")
+    .def("update", &network_update, (arg("self"), arg("gradient")), "Adjusts all synapse weights given averaged error derivatives, as returned by gradient()")
+    .def("freeze", &network::Network::freeze, (arg("self"), arg("frozen")=true), "Freezes (or unfreezes) all synapses not reaching output neurons")
     .def("reporter", &network::Network::reporter, (arg("self")), "Returns my current reporter.", return_internal_reference<>())
     ;
 
@@ -77,4 +132,69 @@ void bind_network()
     .def("__init__", make_constructor(make_network_1, default_call_policies(), (arg("input"), arg("hidden"), arg("output"), arg("neuron_strategy_type"), arg("neuron_parameters"), arg("synapse_strategy_type"), arg("synapse_parameters"), arg("input_subtract"), arg("input_divide"), arg("reporter"))))
     .def("__init__", make_constructor(make_network_2, default_call_policies(), (arg("input"), arg("hidden"), arg("output"), arg("bias"), arg("hidden_neuron_strategy_type"), arg("hidden_neuron_parameters"), arg("output_neuron_strategy_type"), arg("output_neuron_parameters"), arg("synapse_strategy_type"), arg("synapse_parameters"), arg("input_subtract"), arg("input_divide"), arg("reporter"))))
     ;
+
+  class_<network::AsyncTrainer, boost::shared_ptr<network::AsyncTrainer>, boost::noncopyable>("AsyncTrainer", "Lock-free, multi-threaded (Hogwild-style) network trainer. Results are NOT deterministic.", init<network::Network&, const size_t&, sys::Reporter&, optional<const size_t&> >((arg("network"), arg("threads"), arg("reporter"), arg("seed")), "Prepares one network replica per thread")[with_custodian_and_ward<1,2>()])
+    .def("train", &network::AsyncTrainer::train, (arg("self"), arg("data"), arg("target"), arg("epoch"), arg("steps")), "Trains the network with `steps' minibatches of `epoch' patterns, distributed among all threads")
+    .add_property("threads", &network::AsyncTrainer::threads)
+    .add_property("throughput", &network::AsyncTrainer::throughput)
+    ;
+
+  class_<network::CachedTrainer, boost::shared_ptr<network::CachedTrainer>, boost::noncopyable>("CachedTrainer", "Retrains only the output layer of a network, over cached hidden layer activations", init<network::Network&, const data::PatternSet&, sys::Reporter&>((arg("network"), arg("data"), arg("reporter")), "Freezes the network and caches the output layer inputs for the training set")[with_custodian_and_ward<1,2>()])
+    .def("train", (void (network::CachedTrainer::*)(const data::PatternSet&, unsigned int))&network::CachedTrainer::train, (arg("self"), arg("target"), arg("epoch")), "Trains the output layer with `epoch' random cached patterns")
+    .def("run", &network::CachedTrainer::run, (arg("self"), arg("output")), "Runs the cached training set through the output layer")
+    .def("commit", &network::CachedTrainer::commit, (arg("self")), "Copies the retrained weights back into the network")
+    .def("features", &network::CachedTrainer::features, (arg("self")), "The cached output layer inputs", return_internal_reference<>())
+    ;
+
+  class_<network::TrainerParameters>("TrainerParameters", "Parameters that control a training session")
+    .def_readwrite("epoch", &network::TrainerParameters::epoch)
+    .def_readwrite("sample", &network::TrainerParameters::sample)
+    .def_readwrite("stopiter", &network::TrainerParameters::stopiter)
+    .def_readwrite("stopthres", &network::TrainerParameters::stopthres)
+    .def_readwrite("hardstop", &network::TrainerParameters::hardstop)
+    .def_readwrite("msestop", &network::TrainerParameters::msestop)
+    .def_readwrite("background", &network::TrainerParameters::background)
+    .def_readwrite("prefetch", &network::TrainerParameters::prefetch)
+    .def_readwrite("subsample", &network::TrainerParameters::subsample)
+    .def_readwrite("tolerance", &network::TrainerParameters::tolerance)
+    ;
+
+  class_<network::Evaluation>("Evaluation", "The result of evaluating a network on the test set")
+    .def_readonly("step", &network::Evaluation::step)
+    .def_readonly("mse", &network::Evaluation::mse)
+    .def_readonly("sp", &network::Evaluation::sp)
+    .def_readonly("monitor_mse", &network::Evaluation::monitor_mse)
+    .def_readonly("monitor_sp", &network::Evaluation::monitor_sp)
+    ;
+
+  class_<network::Trainer, boost::shared_ptr<network::Trainer>, boost::noncopyable>("Trainer", "A complete training session for a single network", init<network::Network&, const data::PatternSet&, const data::PatternSet&, const data::PatternSet&, const data::PatternSet&, const network::TrainerParameters&, sys::Reporter&, optional<const size_t&> >((arg("network"), arg("train"), arg("train_target"), arg("test"), arg("test_target"), arg("parameters"), arg("reporter"), arg("seed")), "Prepares a training session")[with_custodian_and_ward<1,2, with_custodian_and_ward<1,3, with_custodian_and_ward<1,4, with_custodian_and_ward<1,5, with_custodian_and_ward<1,6> > > > >()])
+    .def("checkpoint", &network::Trainer::checkpoint, tr_checkpoint_overloads((arg("self"), arg("filename"), arg("header")), "Saves every new best network to a file, in the background"))
+    .def("snapshot", &network::Trainer::snapshot, (arg("self"), arg("filename"), arg("every")), "Saves the complete training state every `every' evaluations")
+    .def("save", &network::Trainer::save, (arg("self"), arg("filename")), "Saves the complete training state, so it can be resumed")
+    .def("load", &network::Trainer::load, (arg("self"), arg("filename")), "Restores a training state written by save(), in a run with the same seed")
+    .def("run_seed", &network::Trainer::run_seed, (arg("filename")), "The run seed a training state was saved with")
+    .staticmethod("run_seed")
+    .def("run", &network::Trainer::run, (arg("self")), "Trains the network until a stop criterium is met")
+    .def("evaluate", &network::Trainer::evaluate, (arg("self"), arg("step")), "Evaluates the network on the test set")
+    .add_property("steps", &network::Trainer::steps)
+    .add_property("elapsed", &network::Trainer::elapsed)
+    .add_property("skipped", &network::Trainer::skipped)
+    .def("best", &network::Trainer::best, (arg("self")), "The best evaluation seen so far", return_value_policy<copy_const_reference>())
+    .def("history", &trainer_history, (arg("self")), "All evaluations performed so far")
+    ;
+
+  class_<network::MultiStart, boost::shared_ptr<network::MultiStart>, boost::noncopyable>("MultiStart", "Trains several independently initialised networks concurrently, sharing the same data. Keep the networks and data sets alive while this object exists.", no_init)
+    .def("__init__", make_constructor(make_multistart, default_call_policies(), (arg("networks"), arg("train"), arg("train_target"), arg("test"), arg("test_target"), arg("parameters"), arg("reporter"), arg("seed")=0)))
+    .def("monitor", &network::MultiStart::monitor, (arg("self"), arg("data"), arg("target")), "Sets an additional set to be evaluated by all runs", with_custodian_and_ward<1,2, with_custodian_and_ward<1,3> >())
+    .def("checkpoint", &network::MultiStart::checkpoint, ms_checkpoint_overloads((arg("self"), arg("prefix"), arg("header")), "Saves the best network of every run as prefix.N.xml, as soon as it is found"))
+    .def("snapshot", &network::MultiStart::snapshot, (arg("self"), arg("prefix"), arg("every")), "Saves the complete training state of every run as prefix.N.state, every `every' evaluations")
+    .def("load", &network::MultiStart::load, (arg("self"), arg("prefix")), "Restores the training state of every run from prefix.N.state")
+    .def("run_seed", &network::MultiStart::run_seed, (arg("prefix")), "The run seed the training states were saved with")
+    .staticmethod("run_seed")
+    .def("run", &network::MultiStart::run, (arg("self")), "Trains all networks concurrently")
+    .def("__len__", &network::MultiStart::size)
+    .def("trainer", &network::MultiStart::trainer, (arg("self"), arg("run")), "The trainer of a given run", return_internal_reference<>())
+    .def("best", &network::MultiStart::best, (arg("self")), "The run that produced the best network")
+    .def("save", &network::MultiStart::save, ms_save_overloads((arg("self"), arg("prefix"), arg("header")), "Saves the best network of every run as prefix.N.xml"))
+    ;
 }
@@ -0,0 +1,137 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/AsyncTrainer.cxx
+ *
+ * Implements the lock-free, asynchronous network trainer.
+ */
+
+#include "network/AsyncTrainer.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+#include "sys/util.h"
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+/**
+ * Reads a shared weight without ordering guarantees
+ *
+ * @param w The weight to read
+ */
+inline data::Feature load_relaxed (data::Feature* w)
+{
+  data::Feature retval;
+  __atomic_load(w, &retval, __ATOMIC_RELAXED);
+  return retval;
+}
+
+/**
+ * Writes a shared weight without ordering guarantees
+ *
+ * @param w The weight to write
+ * @param v The new value
+ */
+inline void store_relaxed (data::Feature* w, data::Feature v)
+{
+  __atomic_store(w, &v, __ATOMIC_RELAXED);
+}
+
+network::AsyncTrainer::AsyncTrainer (network::Network& net,
+				     const size_t& threads,
+				     sys::Reporter& reporter,
+				     const size_t& seed)
+  : m_net(net),
+    m_reporter(reporter),
+    m_replica(),
+    m_rnd(),
+    m_weight(),
+    m_failed(threads, 0),
+    m_throughput(0)
+{
+  if (!threads) {
+    RINGER_DEBUG1("I cannot train asynchronously with zero threads."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Zero threads for asynchronous training");
+  }
+  data::RandomInteger base(seed);
+  for (size_t i=0; i<threads; ++i) {
+    m_replica.push_back(m_net.clone());
+    m_rnd.push_back(new data::RandomInteger(base.stream(i)));
+  }
+  RINGER_DEBUG2("Prepared " << threads << " replicas for asynchronous"
+		<< " training.");
+}
+
+network::AsyncTrainer::~AsyncTrainer ()
+{
+  for (size_t i=0; i<m_replica.size(); ++i) {
+    delete m_replica[i];
+    delete m_rnd[i];
+  }
+}
+
+void network::AsyncTrainer::work (const size_t worker,
+				  const data::PatternSet* data,
+				  const data::PatternSet* target,
+				  const unsigned int epoch,
+				  const unsigned int steps)
+{
+  try {
+    network::Network& replica = *m_replica[worker];
+    std::vector<size_t> pats(epoch);
+    std::vector<data::Feature> before(m_weight.size());
+    std::vector<data::Feature> after(m_weight.size());
+    for (unsigned int s=0; s<steps; ++s) {
+      for (size_t k=0; k<m_weight.size(); ++k)
+	before[k] = load_relaxed(&m_weight[k]);
+      replica.set_weights(before);
+      m_rnd[worker]->draw(data->size(), pats);
+      replica.train(*data, *target, pats);
+      replica.copy_weights(after);
+      for (size_t k=0; k<m_weight.size(); ++k) {
+	//racy on purpose: concurrent updates to the same weight may be lost
+	data::Feature current = load_relaxed(&m_weight[k]);
+	store_relaxed(&m_weight[k], current + (after[k] - before[k]));
+      }
+    }
+  }
+  catch (...) {
+    m_failed[worker] = 1;
+  }
+}
+
+void network::AsyncTrainer::train (const data::PatternSet& data,
+				   const data::PatternSet& target,
+				   const unsigned int& epoch,
+				   const unsigned int& steps)
+{
+  RINGER_DEBUG2("(ASYNCHRONOUS) Training network with " << steps
+		<< " minibatches of " << epoch << " patterns in "
+		<< m_replica.size() << " threads.");
+  m_net.copy_weights(m_weight);
+  double start = sys::wallclock();
+  boost::thread_group group;
+  for (size_t i=0; i<m_replica.size(); ++i) {
+    m_failed[i] = 0;
+    unsigned int share = steps/m_replica.size();
+    if (i < steps%m_replica.size()) ++share;
+    group.create_thread(boost::bind(&network::AsyncTrainer::work, this, i,
+				    &data, &target, epoch, share));
+  }
+  group.join_all();
+  double elapsed = sys::wallclock() - start;
+  for (size_t i=0; i<m_failed.size(); ++i) {
+    if (m_failed[i]) {
+      RINGER_DEBUG1("Asynchronous training thread " << i << " failed."
+		    << " Exception thrown.");
+      throw RINGER_EXCEPTION("Asynchronous training thread failed");
+    }
+  }
+  m_net.set_weights(m_weight);
+  m_throughput = (elapsed > 0)? (static_cast<double>(epoch)*steps)/elapsed:0;
+  RINGER_REPORT(m_reporter, "Asynchronous training of "
+		<< static_cast<double>(epoch)*steps << " patterns in "
+		<< m_replica.size() << " threads took " << elapsed
+		<< " seconds (" << m_throughput << " patterns/s).");
+}
@@ -0,0 +1,233 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/BinTrainer.cxx
+ *
+ * Implements concurrent training of one network per bin.
+ */
+
+#include "network/BinTrainer.h"
+#include "data/Ensemble.h"
+#include "sys/ThreadPool.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <boost/bind.hpp>
+
+network::BinTrainer::BinTrainer
+(const data::PatternSet& train, const data::PatternSet& train_target,
+ const data::PatternSet& test, const data::PatternSet& test_target,
+ const std::vector<std::vector<size_t> >& train_bins,
+ const std::vector<std::vector<size_t> >& test_bins,
+ const network::SweepPoint& point, const network::TrainerParameters& par,
+ sys::Reporter& reporter)
+  : m_train(train),
+    m_train_target(train_target),
+    m_test(test),
+    m_test_target(test_target),
+    m_train_bins(train_bins),
+    m_test_bins(test_bins),
+    m_par(par),
+    m_reporter(reporter),
+    m_result(),
+    m_net(train_bins.size(), 0)
+{
+  if (m_train_bins.size() != m_test_bins.size() || m_train_bins.empty()) {
+    RINGER_DEBUG1("Binned training needs the same number (at least 1) of"
+		  << " training and test bins, but I got "
+		  << m_train_bins.size() << " and " << m_test_bins.size()
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid bins");
+  }
+  if (!point.hidden || !point.epoch) {
+    RINGER_DEBUG1("Binned training needs at least one hidden neuron and"
+		  << " one pattern per epoch. Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid binned training configuration");
+  }
+  m_par.epoch = point.epoch;
+  network::SweepResult r;
+  r.point = point;
+  r.best.step = 0;
+  r.best.mse = 0;
+  r.best.sp = 0;
+  r.best.monitor_mse = 0;
+  r.best.monitor_sp = 0;
+  r.steps = 0;
+  r.elapsed = 0;
+  r.failed = false;
+  m_result.assign(m_train_bins.size(), r);
+}
+
+network::BinTrainer::~BinTrainer ()
+{
+  for (size_t i=0; i<m_net.size(); ++i) delete m_net[i];
+}
+
+network::Network* network::BinTrainer::build (const size_t& i) const
+{
+  const std::vector<size_t>& pats = m_train_bins[i];
+
+  //input normalisation from the bin training patterns only, as
+  //data::NormalizationOperator does for a whole database
+  const size_t n = pats.size();
+  data::Pattern mean(m_train.pattern_size(), 0);
+  data::Pattern stddev(m_train.pattern_size(), 1);
+  data::Ensemble e(n);
+  for (size_t f=0; f<m_train.pattern_size(); ++f) {
+    m_train.ensemble(f, pats, e);
+    double sum = 0, sum2 = 0;
+    for (size_t k=0; k<n; ++k) { sum += e[k]; sum2 += e[k]*e[k]; }
+    mean[f] = sum/n;
+    if (n > 1)
+      stddev[f] = std::sqrt(std::fabs(sum2 - n*mean[f]*mean[f])/(n-1));
+    if (stddev[f] < 1e-5) stddev[f] = 1; //to prevent overflowing...
+  }
+
+  return network::Sweep::build(m_result[i].point, m_train.pattern_size(),
+			       m_train_target.pattern_size(), mean, stddev,
+			       m_reporter);
+}
+
+void network::BinTrainer::train (const size_t& i,
+				 const data::RandomInteger& rnd)
+{
+  network::SweepResult& r = m_result[i];
+  try {
+    network::Trainer trainer(*m_net[i], m_train, m_train_target, m_test,
+			     m_test_target, m_par, m_reporter, rnd);
+    trainer.subset(m_train_bins[i], m_test_bins[i]);
+    trainer.run();
+    r.best = trainer.best();
+    r.steps = trainer.steps();
+    r.elapsed = trainer.elapsed();
+    m_net[i]->set_weights(trainer.best_weights());
+  }
+  catch (sys::Exception& ex) {
+    delete m_net[i];
+    m_net[i] = 0;
+    r.failed = true;
+    r.error = ex.info();
+    throw;
+  }
+  catch (...) {
+    delete m_net[i];
+    m_net[i] = 0;
+    r.failed = true;
+    r.error = "unknown exception";
+    throw;
+  }
+}
+
+void network::BinTrainer::run (const size_t& threads)
+{
+  for (size_t i=0; i<m_net.size(); ++i) {
+    delete m_net[i];
+    m_net[i] = 0;
+    m_result[i].failed = false;
+    m_result[i].error.clear();
+  }
+  sys::ThreadPool pool(threads);
+  RINGER_REPORT(m_reporter, "Training " << m_result.size()
+		<< " bins on " << pool.size() << " threads.");
+  //networks and generators are set up here, in order, so the initial
+  //weights and minibatches do not depend on how the threads are scheduled
+  //(trainers take every other stream, as they use the next one as well)
+  data::RandomInteger base;
+  bool failed = false;
+  for (size_t i=0; i<m_result.size(); ++i) {
+    if (m_train_bins[i].empty() || m_test_bins[i].empty()) {
+      m_result[i].failed = true;
+      m_result[i].error = "no training or test patterns";
+      continue;
+    }
+    try {
+      m_net[i] = build(i);
+    }
+    catch (sys::Exception& ex) {
+      m_result[i].failed = failed = true;
+      m_result[i].error = ex.info();
+      continue;
+    }
+    pool.submit(boost::bind(&network::BinTrainer::train, this, i,
+			    base.stream(2*i)));
+  }
+  try {
+    pool.wait();
+  }
+  catch (sys::Exception&) {
+    failed = true;
+  }
+  if (failed)
+    RINGER_WARN(m_reporter, "Some bins failed to train. They are flagged"
+		<< " in the summary.");
+  for (size_t i=0; i<m_result.size(); ++i) {
+    if (m_train_bins[i].empty() || m_test_bins[i].empty())
+      RINGER_WARN(m_reporter, "Bin " << i << " has no training or no test"
+		  << " patterns and was not trained.");
+  }
+}
+
+void network::BinTrainer::save (const std::string& prefix,
+				const std::vector<double>& edges,
+				const config::Header* header) const
+{
+  if (edges.size() != m_net.size() + 1) {
+    RINGER_DEBUG1("Saving " << m_net.size() << " bins needs "
+		  << m_net.size() + 1 << " edges, but I got " << edges.size()
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Bin edges do not match bins");
+  }
+  const std::string index = prefix + ".bins";
+  const std::string tmp = index + ".tmp";
+  std::ofstream os(tmp.c_str());
+  os << std::setprecision(17);
+  for (size_t i=0; i<m_net.size(); ++i) {
+    os << edges[i] << " " << edges[i+1] << " ";
+    if (!m_net[i]) {
+      os << "none\n";
+      continue;
+    }
+    std::ostringstream name;
+    name << prefix << "." << i << ".xml";
+    if (!m_net[i]->save(name.str(), header)) {
+      RINGER_DEBUG1("Could not save the network of bin " << i << " to \""
+		    << name.str() << "\". Exception thrown.");
+      throw RINGER_EXCEPTION("Cannot save bin network");
+    }
+    os << name.str() << "\n";
+  }
+  os.close();
+  if (!os || std::rename(tmp.c_str(), index.c_str()) != 0) {
+    RINGER_DEBUG1("Could not write the bin index \"" << index << "\"."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot write bin index");
+  }
+  RINGER_DEBUG2("Bundle of " << m_net.size() << " bin networks saved with"
+		<< " index \"" << index << "\".");
+}
+
+void network::BinTrainer::table (std::ostream& os) const
+{
+  os << "#  bin    train     test     best-sp    best-mse  at-step  steps"
+     << "   time(s)\n";
+  for (size_t i=0; i<m_result.size(); ++i) {
+    const network::SweepResult& r = m_result[i];
+    os << std::setw(6) << i << " " << std::setw(8) << m_train_bins[i].size()
+       << " " << std::setw(8) << m_test_bins[i].size() << " ";
+    if (r.failed) {
+      os << std::setw(11) << "failed" << " " << r.error << "\n";
+      continue;
+    }
+    os << std::setw(11) << r.best.sp << " " << std::setw(11) << r.best.mse
+       << " " << std::setw(8) << r.best.step << " " << std::setw(6)
+       << r.steps << " " << std::setw(9) << std::fixed
+       << std::setprecision(2) << r.elapsed << "\n";
+    os.unsetf(std::ios_base::floatfield);
+    os << std::setprecision(6);
+  }
+}
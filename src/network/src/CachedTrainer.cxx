@@ -0,0 +1,53 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/CachedTrainer.cxx
+ *
+ * Implements output layer retraining over cached activations.
+ */
+
+#include "network/CachedTrainer.h"
+#include "sys/debug.h"
+
+network::CachedTrainer::CachedTrainer (network::Network& net,
+				       const data::PatternSet& data,
+				       sys::Reporter& reporter)
+  : m_net(net),
+    m_reporter(reporter),
+    m_features(1, 1),
+    m_layer(0)
+{
+  m_net.freeze();
+  m_layer = m_net.output_layer(data, m_features);
+  RINGER_REPORT(m_reporter, "Cached " << m_features.pattern_size()
+		<< " output layer inputs for " << m_features.size()
+		<< " training patterns.");
+}
+
+network::CachedTrainer::~CachedTrainer ()
+{
+  delete m_layer;
+}
+
+void network::CachedTrainer::train (const data::PatternSet& target,
+				    unsigned int epoch)
+{
+  m_layer->train(m_features, target, epoch);
+}
+
+void network::CachedTrainer::train (const data::PatternSet& target,
+				    const std::vector<size_t>& pats)
+{
+  m_layer->train(m_features, target, pats);
+}
+
+void network::CachedTrainer::run (data::PatternSet& output)
+{
+  m_layer->run(m_features, output);
+}
+
+void network::CachedTrainer::commit (void)
+{
+  RINGER_DEBUG2("Copying retrained output layer weights back.");
+  m_net.output_layer(*m_layer);
+}
@@ -0,0 +1,119 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/CheckpointWriter.cxx
+ *
+ * Implements background writing of network checkpoints.
+ */
+
+#include "network/CheckpointWriter.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+#include <cstdio>
+#include <boost/bind.hpp>
+
+network::CheckpointWriter::CheckpointWriter (const network::Network& net,
+					     const std::string& file,
+					     const config::Header* header,
+					     sys::Reporter& reporter)
+  : m_reporter(reporter),
+    m_replica(0),
+    m_file(file),
+    m_header(header? new config::Header(*header) : 0),
+    m_pending(),
+    m_dirty(false),
+    m_busy(false),
+    m_written(0),
+    m_stop(false),
+    m_failed(false),
+    m_mutex(),
+    m_cond(),
+    m_thread()
+{
+  try {
+    m_replica = net.clone();
+  }
+  catch (...) {
+    delete m_header;
+    throw;
+  }
+  m_thread = boost::thread(boost::bind(&network::CheckpointWriter::work,
+				       this));
+  RINGER_DEBUG2("Background checkpoints to \"" << m_file << "\" started.");
+}
+
+network::CheckpointWriter::~CheckpointWriter ()
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  m_thread.join();
+  delete m_replica;
+  delete m_header;
+  RINGER_DEBUG2("Background checkpoints to \"" << m_file << "\" stopped"
+		<< " after " << m_written << " writes.");
+}
+
+void network::CheckpointWriter::submit
+(const std::vector<data::Feature>& weights)
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_pending = weights;
+    m_dirty = true;
+  }
+  m_cond.notify_all();
+}
+
+void network::CheckpointWriter::flush (void)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (!m_failed && (m_dirty || m_busy)) m_cond.wait(lock);
+  if (m_failed) {
+    RINGER_DEBUG1("Writing a checkpoint to \"" << m_file << "\" failed."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Checkpoint write failed");
+  }
+}
+
+size_t network::CheckpointWriter::written (void)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  return m_written;
+}
+
+void network::CheckpointWriter::work (void)
+{
+  std::vector<data::Feature> weights;
+  const std::string tmp = m_file + ".tmp";
+  while (true) {
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (!m_stop && !m_dirty) m_cond.wait(lock);
+      if (!m_dirty) return; //stopped and nothing left to write
+      weights.swap(m_pending);
+      m_dirty = false;
+      m_busy = true;
+    }
+    bool ok = true;
+    try {
+      m_replica->set_weights(weights);
+      m_replica->save(tmp, m_header);
+      ok = (std::rename(tmp.c_str(), m_file.c_str()) == 0);
+    }
+    catch (...) {
+      ok = false;
+    }
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      m_busy = false;
+      if (ok) ++m_written;
+      else m_failed = true;
+    }
+    m_cond.notify_all();
+    if (!ok) return;
+  }
+}
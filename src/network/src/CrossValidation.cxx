@@ -0,0 +1,189 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/CrossValidation.cxx
+ *
+ * Implements parallel k-fold cross-validation.
+ */
+
+#include "network/CrossValidation.h"
+#include "sys/ThreadPool.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <boost/bind.hpp>
+
+network::CrossValidation::CrossValidation
+(const data::PatternSet& data, const data::PatternSet& target,
+ const std::vector<std::vector<size_t> >& train,
+ const std::vector<std::vector<size_t> >& test,
+ const data::Pattern& mean, const data::Pattern& stddev,
+ const network::SweepPoint& point, const network::TrainerParameters& par,
+ sys::Reporter& reporter)
+  : m_data(data),
+    m_target(target),
+    m_train(train),
+    m_test(test),
+    m_mean(mean),
+    m_stddev(stddev),
+    m_par(par),
+    m_reporter(reporter),
+    m_prefix(),
+    m_result()
+{
+  if (m_train.size() != m_test.size() || m_train.size() < 2) {
+    RINGER_DEBUG1("Cross-validation needs the same number (at least 2) of"
+		  << " training and test folds, but I got " << m_train.size()
+		  << " and " << m_test.size() << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid cross-validation folds");
+  }
+  if (!point.hidden || !point.epoch) {
+    RINGER_DEBUG1("Cross-validation needs at least one hidden neuron and"
+		  << " one pattern per epoch. Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid cross-validation configuration");
+  }
+  m_par.epoch = point.epoch;
+  network::SweepResult r;
+  r.point = point;
+  r.best.step = 0;
+  r.best.mse = 0;
+  r.best.sp = 0;
+  r.best.monitor_mse = 0;
+  r.best.monitor_sp = 0;
+  r.steps = 0;
+  r.elapsed = 0;
+  r.failed = false;
+  m_result.assign(m_train.size(), r);
+}
+
+network::CrossValidation::~CrossValidation ()
+{
+}
+
+void network::CrossValidation::train (const size_t& i, network::Network* net,
+				      const data::RandomInteger& rnd)
+{
+  network::SweepResult& r = m_result[i];
+  try {
+    network::Trainer trainer(*net, m_data, m_target, m_data, m_target,
+			     m_par, m_reporter, rnd);
+    trainer.subset(m_train[i], m_test[i]);
+    trainer.run();
+    r.best = trainer.best();
+    r.steps = trainer.steps();
+    r.elapsed = trainer.elapsed();
+    if (m_prefix.size()) {
+      std::ostringstream name;
+      name << m_prefix << "." << i << ".xml";
+      net->set_weights(trainer.best_weights());
+      net->save(name.str());
+    }
+  }
+  catch (sys::Exception& ex) {
+    delete net;
+    r.failed = true;
+    r.error = ex.info();
+    throw;
+  }
+  catch (...) {
+    delete net;
+    r.failed = true;
+    r.error = "unknown exception";
+    throw;
+  }
+  delete net;
+}
+
+void network::CrossValidation::run (const size_t& threads)
+{
+  sys::ThreadPool pool(threads);
+  RINGER_REPORT(m_reporter, "Cross-validating " << m_result.size()
+		<< " folds on " << pool.size() << " threads.");
+  //networks and generators are set up here, in order, so the initial
+  //weights and minibatches do not depend on how the threads are scheduled
+  //(trainers take every other stream, as they use the next one as well)
+  data::RandomInteger base;
+  bool failed = false;
+  for (size_t i=0; i<m_result.size(); ++i) {
+    m_result[i].failed = false;
+    m_result[i].error.clear();
+    network::Network* net = 0;
+    try {
+      net = network::Sweep::build(m_result[i].point, m_data.pattern_size(),
+				  m_target.pattern_size(), m_mean, m_stddev,
+				  m_reporter);
+    }
+    catch (sys::Exception& ex) {
+      m_result[i].failed = failed = true;
+      m_result[i].error = ex.info();
+      continue;
+    }
+    pool.submit(boost::bind(&network::CrossValidation::train, this, i, net,
+			    base.stream(2*i)));
+  }
+  try {
+    pool.wait();
+  }
+  catch (sys::Exception&) {
+    failed = true;
+  }
+  if (failed)
+    RINGER_WARN(m_reporter, "Some folds failed to train. They are left out"
+		<< " of the summary.");
+}
+
+size_t network::CrossValidation::summary (double& sp_mean, double& sp_stddev,
+					  double& mse_mean,
+					  double& mse_stddev) const
+{
+  size_t n = 0;
+  double sp_sum = 0, sp_sum2 = 0, mse_sum = 0, mse_sum2 = 0;
+  for (size_t i=0; i<m_result.size(); ++i) {
+    if (m_result[i].failed) continue;
+    ++n;
+    sp_sum += m_result[i].best.sp;
+    sp_sum2 += m_result[i].best.sp * m_result[i].best.sp;
+    mse_sum += m_result[i].best.mse;
+    mse_sum2 += m_result[i].best.mse * m_result[i].best.mse;
+  }
+  sp_mean = sp_stddev = mse_mean = mse_stddev = 0;
+  if (!n) return 0;
+  sp_mean = sp_sum/n;
+  mse_mean = mse_sum/n;
+  if (n > 1) { //unbiased estimate
+    sp_stddev =
+      std::sqrt(std::max(0.0, (sp_sum2 - n*sp_mean*sp_mean)/(n-1)));
+    mse_stddev =
+      std::sqrt(std::max(0.0, (mse_sum2 - n*mse_mean*mse_mean)/(n-1)));
+  }
+  return n;
+}
+
+void network::CrossValidation::table (std::ostream& os) const
+{
+  os << "# fold    train     test     best-sp    best-mse  at-step  steps"
+     << "   time(s)\n";
+  for (size_t i=0; i<m_result.size(); ++i) {
+    const network::SweepResult& r = m_result[i];
+    os << std::setw(6) << i << " " << std::setw(8) << m_train[i].size()
+       << " " << std::setw(8) << m_test[i].size() << " ";
+    if (r.failed) {
+      os << std::setw(11) << "failed" << " " << r.error << "\n";
+      continue;
+    }
+    os << std::setw(11) << r.best.sp << " " << std::setw(11) << r.best.mse
+       << " " << std::setw(8) << r.best.step << " " << std::setw(6)
+       << r.steps << " " << std::setw(9) << std::fixed
+       << std::setprecision(2) << r.elapsed << "\n";
+    os.unsetf(std::ios_base::floatfield);
+    os << std::setprecision(6);
+  }
+  double sp_mean, sp_stddev, mse_mean, mse_stddev;
+  size_t n = summary(sp_mean, sp_stddev, mse_mean, mse_stddev);
+  os << "# " << n << " folds: SP = " << sp_mean << " +- " << sp_stddev
+     << ", MSE = " << mse_mean << " +- " << mse_stddev << "\n";
+}
@@ -0,0 +1,183 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/Evaluator.cxx
+ *
+ * Implements background evaluation of network weight snapshots.
+ */
+
+#include "network/Evaluator.h"
+#include "data/util.h"
+#include "data/PatternSetView.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+#include <boost/bind.hpp>
+
+network::Evaluator::Evaluator (const network::Network& net,
+			       const data::PatternSet& test,
+			       const data::PatternSet& test_target,
+			       const data::PatternSet* monitor,
+			       const data::PatternSet* monitor_target,
+			       sys::Reporter& reporter,
+			       const size_t& depth,
+			       const std::vector<size_t>* pats)
+  : m_reporter(reporter),
+    m_replica(0),
+    m_test(test),
+    m_test_target(test_target),
+    m_monitor(monitor),
+    m_monitor_target(monitor_target),
+    m_depth(depth? depth : 1),
+    m_pats(pats),
+    m_step(),
+    m_snapshot(),
+    m_result(),
+    m_evaluated(),
+    m_busy(0),
+    m_stop(false),
+    m_failed(false),
+    m_mutex(),
+    m_cond(),
+    m_thread()
+{
+  m_replica = net.clone();
+  m_thread = boost::thread(boost::bind(&network::Evaluator::work, this));
+  RINGER_DEBUG2("Background evaluation started.");
+}
+
+network::Evaluator::~Evaluator ()
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  m_thread.join();
+  delete m_replica;
+  RINGER_DEBUG2("Background evaluation stopped.");
+}
+
+void network::Evaluator::submit (const unsigned int& step,
+				 const std::vector<data::Feature>& weights)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (!m_failed && m_snapshot.size() + m_busy >= m_depth)
+    m_cond.wait(lock);
+  if (m_failed) {
+    RINGER_DEBUG1("Background evaluation failed. Exception thrown.");
+    throw RINGER_EXCEPTION("Background evaluation failed");
+  }
+  m_step.push_back(step);
+  m_snapshot.push_back(weights);
+  m_cond.notify_all();
+}
+
+bool network::Evaluator::collect (network::Evaluation& e,
+				  std::vector<data::Feature>& weights,
+				  const bool& wait)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (wait) {
+    while (!m_failed && m_result.empty() &&
+	   (m_busy || !m_snapshot.empty())) m_cond.wait(lock);
+  }
+  if (m_failed) {
+    RINGER_DEBUG1("Background evaluation failed. Exception thrown.");
+    throw RINGER_EXCEPTION("Background evaluation failed");
+  }
+  if (m_result.empty()) return false;
+  e = m_result.front();
+  m_result.pop_front();
+  weights.swap(m_evaluated.front());
+  m_evaluated.pop_front();
+  return true;
+}
+
+void network::Evaluator::work (void)
+{
+  while (true) {
+    unsigned int step = 0;
+    std::vector<data::Feature> weights;
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (!m_stop && m_snapshot.empty()) m_cond.wait(lock);
+      if (m_snapshot.empty()) return; //stopped and nothing left to do
+      step = m_step.front();
+      m_step.pop_front();
+      weights.swap(m_snapshot.front());
+      m_snapshot.pop_front();
+      ++m_busy;
+    }
+    network::Evaluation e;
+    bool ok = true;
+    try {
+      m_replica->set_weights(weights);
+      e = evaluate(*m_replica, step, m_test, m_test_target,
+		   m_monitor, m_monitor_target, m_pats);
+    }
+    catch (...) {
+      ok = false;
+    }
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      --m_busy;
+      if (ok) {
+	m_result.push_back(e);
+	m_evaluated.push_back(std::vector<data::Feature>());
+	m_evaluated.back().swap(weights);
+      }
+      else m_failed = true;
+    }
+    m_cond.notify_all();
+    if (!ok) return;
+  }
+}
+
+void network::Evaluator::measure (network::Network& net,
+				  const data::PatternSet& data,
+				  const data::PatternSet& target,
+				  const std::vector<size_t>* pats,
+				  double& mse, double& sp)
+{
+  if (pats) {
+    //the targets of the subset are only looked at, never copied
+    data::PatternSet output(pats->size(), net.output_size());
+    net.run(data, *pats, output);
+    data::PatternSetView subset(target, *pats);
+    mse = data::mse(output, subset);
+    sp = 0;
+    if (subset.pattern_size() == 1) {
+      double eff1, eff2, thres;
+      sp = data::sp(output, subset, eff1, eff2, thres);
+    }
+    return;
+  }
+  data::PatternSet output(data.size(), net.output_size());
+  net.run(data, output);
+  mse = data::mse(output, target);
+  sp = 0;
+  if (target.pattern_size() == 1) {
+    double eff1, eff2, thres;
+    sp = data::sp(output, target, eff1, eff2, thres);
+  }
+}
+
+network::Evaluation network::Evaluator::evaluate
+(network::Network& net, const unsigned int& step,
+ const data::PatternSet& test, const data::PatternSet& test_target,
+ const data::PatternSet* monitor, const data::PatternSet* monitor_target,
+ const std::vector<size_t>* pats)
+{
+  network::Evaluation retval;
+  retval.step = step;
+  measure(net, test, test_target, pats, retval.mse, retval.sp);
+  retval.monitor_mse = 0;
+  retval.monitor_sp = 0;
+  if (monitor)
+    measure(net, *monitor, *monitor_target, 0, retval.monitor_mse,
+	    retval.monitor_sp);
+  RINGER_DEBUG2("[step " << step << "] MSE = " << retval.mse
+		<< ", SP = " << retval.sp);
+  return retval;
+}
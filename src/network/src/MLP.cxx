@@ -29,9 +29,8 @@ static data::RandomInteger rnd; //default initializer, do it once
 network::Synapse* create_synapse (const config::SynapseStrategyType& type,
 				  const config::Parameter* params)
 {
-  data::Feature weight = rnd.draw(RAND_MAX);
-  weight -= ((data::Feature)RAND_MAX)/2;
-  weight /= 10*((data::Feature)RAND_MAX)/2;
+  //between -0.1 and +0.1
+  data::Feature weight = (rnd.uniform() - 0.5)/5;
   return new network::Synapse(weight, type, params);
 }
 
@@ -0,0 +1,171 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/MultiStart.cxx
+ *
+ * Implements concurrent training of several networks.
+ */
+
+#include "network/MultiStart.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+#include <sstream>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+/**
+ * Runs a trainer, flagging if it failed, so exceptions do not escape threads
+ *
+ * @param t The trainer to run
+ * @param failed Set to 1 if the trainer threw
+ */
+static void run_trainer (network::Trainer* t, char* failed)
+{
+  try { t->run(); }
+  catch (...) { *failed = 1; }
+}
+
+network::MultiStart::MultiStart (const std::vector<network::Network*>& nets,
+				 const data::PatternSet& train,
+				 const data::PatternSet& train_target,
+				 const data::PatternSet& test,
+				 const data::PatternSet& test_target,
+				 const network::TrainerParameters& par,
+				 sys::Reporter& reporter,
+				 const size_t& seed)
+  : m_reporter(reporter),
+    m_trainer(),
+    m_msestop(par.msestop)
+{
+  //trainers take every other stream, as they use the next one as well
+  data::RandomInteger base(seed);
+  for (size_t i=0; i<nets.size(); ++i)
+    m_trainer.push_back(new network::Trainer(*nets[i], train, train_target,
+					     test, test_target, par,
+					     reporter, base.stream(2*i)));
+}
+
+network::MultiStart::~MultiStart ()
+{
+  for (size_t i=0; i<m_trainer.size(); ++i) delete m_trainer[i];
+}
+
+void network::MultiStart::monitor (const data::PatternSet& data,
+				   const data::PatternSet& target)
+{
+  for (size_t i=0; i<m_trainer.size(); ++i) 
+    m_trainer[i]->monitor(data, target);
+}
+
+void network::MultiStart::subset (const std::vector<size_t>& train,
+				  const std::vector<size_t>& test)
+{
+  for (size_t i=0; i<m_trainer.size(); ++i) 
+    m_trainer[i]->subset(train, test);
+}
+
+void network::MultiStart::weights (const std::vector<double>& weights)
+{
+  for (size_t i=0; i<m_trainer.size(); ++i) 
+    m_trainer[i]->weights(weights);
+}
+
+void network::MultiStart::stream (const std::string& file,
+				  const std::map<std::string, data::Pattern*>&
+				  targets)
+{
+  for (size_t i=0; i<m_trainer.size(); ++i) 
+    m_trainer[i]->stream(file, targets);
+}
+
+/**
+ * Returns the name of the file for a run
+ *
+ * @param prefix The file name prefix
+ * @param i The run number
+ * @param ext The file name extension
+ */
+static std::string run_file (const std::string& prefix, const size_t& i,
+			     const std::string& ext="xml")
+{
+  std::ostringstream name;
+  name << prefix << "." << i << "." << ext;
+  return name.str();
+}
+
+void network::MultiStart::checkpoint (const std::string& prefix,
+				      const config::Header* header)
+{
+  for (size_t i=0; i<m_trainer.size(); ++i)
+    m_trainer[i]->checkpoint(run_file(prefix, i), header);
+}
+
+void network::MultiStart::snapshot (const std::string& prefix,
+				    const unsigned int& every)
+{
+  for (size_t i=0; i<m_trainer.size(); ++i)
+    m_trainer[i]->snapshot(run_file(prefix, i, "state"), every);
+}
+
+void network::MultiStart::load (const std::string& prefix)
+{
+  for (size_t i=0; i<m_trainer.size(); ++i)
+    m_trainer[i]->load(run_file(prefix, i, "state"));
+  RINGER_REPORT(m_reporter, "Resumed " << m_trainer.size() << " runs from"
+		<< " training states with prefix \"" << prefix << "\".");
+}
+
+size_t network::MultiStart::run_seed (const std::string& prefix)
+{
+  return network::Trainer::run_seed(run_file(prefix, 0, "state"));
+}
+
+void network::MultiStart::run (void)
+{
+  RINGER_REPORT(m_reporter, "Training " << m_trainer.size()
+		<< " networks concurrently.");
+  std::vector<char> failed(m_trainer.size(), 0);
+  boost::thread_group group;
+  for (size_t i=0; i<m_trainer.size(); ++i)
+    group.create_thread(boost::bind(run_trainer, m_trainer[i], &failed[i]));
+  group.join_all();
+  for (size_t i=0; i<failed.size(); ++i) {
+    if (failed[i]) {
+      RINGER_DEBUG1("Training run " << i << " failed. Exception thrown.");
+      throw RINGER_EXCEPTION("Concurrent training run failed");
+    }
+  }
+  for (size_t i=0; i<m_trainer.size(); ++i) {
+    const network::Evaluation& b = m_trainer[i]->best();
+    RINGER_REPORT(m_reporter, "[run " << i << "] best at step " << b.step
+		  << " of " << m_trainer[i]->steps() << ": MSE = " << b.mse
+		  << ", SP = " << b.sp << " (" << m_trainer[i]->elapsed()
+		  << " s)");
+  }
+  RINGER_REPORT(m_reporter, "Best network was produced by run " << best()
+		<< ".");
+}
+
+size_t network::MultiStart::best (void) const
+{
+  size_t retval = 0;
+  for (size_t i=1; i<m_trainer.size(); ++i) {
+    const network::Evaluation& b = m_trainer[i]->best();
+    const network::Evaluation& r = m_trainer[retval]->best();
+    if (m_msestop? (b.mse < r.mse) : (b.sp > r.sp)) retval = i;
+  }
+  return retval;
+}
+
+void network::MultiStart::save (const std::string& prefix,
+				const config::Header* header)
+{
+  for (size_t i=0; i<m_trainer.size(); ++i) {
+    std::string name = run_file(prefix, i);
+    m_trainer[i]->network().set_weights(m_trainer[i]->best_weights());
+    m_trainer[i]->network().save(name, header);
+    RINGER_DEBUG1("Saved best network of run " << i << " at \""
+		  << name << "\".");
+  }
+}
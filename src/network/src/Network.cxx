@@ -22,46 +22,77 @@
 
 #include <fstream>
 
-/**
- * A static random integer generator
- */
-static data::RandomInteger static_rnd;
-
 network::Network::Network (const std::string& config, 
 			   sys::Reporter& reporter)
   : m_config(0),
     m_reporter(reporter),
     m_neuron(),
-    m_synapse()
+    m_synapse(),
+    m_rnd()
 {
   m_config = new config::Network(config, reporter);
+  build();
+}
+
+network::Network::Network (const config::Network& config, 
+			   sys::Reporter& reporter)
+  : m_config(0),
+    m_reporter(reporter),
+    m_neuron(),
+    m_synapse(),
+    m_rnd()
+{
+  m_config = new config::Network(config.header(), config.synapses(),
+				 config.neurons(), reporter);
+  build();
+}
+
+/**
+ * Creates a neuron of the type given by its configuration
+ *
+ * @param config The neuron configuration
+ */
+static network::Neuron* make_neuron (const config::Neuron& config)
+{
+  switch (config.type()) {
+  case config::INPUT:
+    RINGER_DEBUG1("Creating input neuron " << config.id());
+    return new network::InputNeuron(config);
+  case config::BIAS:
+    RINGER_DEBUG1("Creating bias neuron " << config.id());
+    return new network::BiasNeuron(config);
+  case config::HIDDEN:
+    RINGER_DEBUG1("Creating hidden neuron " << config.id());
+    return new network::HiddenNeuron(config);
+  case config::OUTPUT:
+    RINGER_DEBUG1("Creating output neuron " << config.id());
+    return new network::OutputNeuron(config);
+  default:
+    throw RINGER_EXCEPTION("Unknown neuron type");
+  }
+}
+
+void network::Network::build (void)
+{
   /**
    * BUILD NEURONS FIRST
    */
   for (std::vector<config::Neuron*>::const_iterator it =
 	 m_config->neurons().begin(); it != m_config->neurons().end(); ++it) {
+    network::Neuron* n = make_neuron(**it);
+    m_neuron[(*it)->id()] = n;
     switch ((*it)->type()) {
     case config::INPUT:
-      m_input.push_back(new InputNeuron(**it));
-      m_neuron[(*it)->id()] = m_input[m_input.size()-1];
-      RINGER_DEBUG1("Created input neuron " << (*it)->id());
+      m_input.push_back(static_cast<InputNeuron*>(n));
       break;
     case config::BIAS:
-      m_bias.push_back(new BiasNeuron(**it));
-      m_neuron[(*it)->id()] = m_bias[m_bias.size()-1];
-      RINGER_DEBUG1("Created bias neuron " << (*it)->id());
-      break;
-    case config::HIDDEN:
-      m_neuron[(*it)->id()] = new HiddenNeuron(**it);
-      RINGER_DEBUG1("Created hidden neuron " << (*it)->id());
+      m_bias.push_back(static_cast<BiasNeuron*>(n));
       break;
     case config::OUTPUT:
-      m_output.push_back(new OutputNeuron(**it));
-      m_neuron[(*it)->id()] = m_output[m_output.size()-1];
-      RINGER_DEBUG1("Created output neuron " << (*it)->id());
+      m_output.push_back(static_cast<OutputNeuron*>(n));
       break;
     default:
-      throw RINGER_EXCEPTION("Unknown neuron type");
+      break;
     }
   }
 
@@ -106,7 +137,8 @@ network::Network::Network (const std::vector<network::Neuron*>& neurons,
     m_input(),
     m_bias(),
     m_output(),
-    m_synapse()
+    m_synapse(),
+    m_rnd()
 {
   adopt(neurons, synapses);
 }
@@ -118,7 +150,8 @@ network::Network::Network (sys::Reporter& reporter)
     m_input(),
     m_bias(),
     m_output(),
-    m_synapse()
+    m_synapse(),
+    m_rnd()
 {
 }
 
@@ -135,10 +168,9 @@ network::Network::~Network ()
   }
 }
 
-bool network::Network::save (const std::string& file,
-			     const config::Header* header) const
+config::Network* network::Network::dump
+(const config::Header* header) const
 {
-  RINGER_DEBUG3("Saving network state at file \"" << file << "\".");
   std::vector<config::Neuron*> neuron_config;
   std::vector<config::Synapse*> synapse_config;
   for (std::map<unsigned int, Neuron*>::const_iterator it =
@@ -160,11 +192,11 @@ bool network::Network::save (const std::string& file,
 			       "UNSET COMMENT");
     header_allocated = true;
   }
-  config::Network new_config(touse, synapse_config, neuron_config, m_reporter);
+  config::Network* retval = new config::Network(touse, synapse_config, 
+						neuron_config, m_reporter);
   if (header_allocated) delete touse;
 
-  //save and delete the acquired resources
-  bool retval = new_config.save(file);
+  //delete the acquired resources
   for (std::vector<config::Neuron*>::iterator it =
 	 neuron_config.begin(); it != neuron_config.end(); ++it) {
     delete *it;
@@ -173,6 +205,16 @@ bool network::Network::save (const std::string& file,
 	 synapse_config.begin(); it != synapse_config.end(); ++it) {
     delete *it;
   }
+  return retval;
+}
+
+bool network::Network::save (const std::string& file,
+			     const config::Header* header) const
+{
+  RINGER_DEBUG3("Saving network state at file \"" << file << "\".");
+  config::Network* new_config = dump(header);
+  bool retval = new_config->save(file);
+  delete new_config;
   if (!retval) {
     RINGER_WARN(m_reporter, "I could not save network state in \"" 
 	      << file << "\". Exception thrown.");
@@ -182,6 +224,237 @@ bool network::Network::save (const std::string& file,
   return true;
 }
 
+network::Network* network::Network::clone (void) const
+{
+  //every neuron and synapse is rebuilt from its own state, so no
+  //config::Network of the whole graph is ever assembled and copied
+  std::vector<network::Neuron*> neurons;
+  std::vector<network::Synapse*> synapses;
+  std::map<unsigned int, network::Neuron*> neuron;
+  network::Network* retval = 0;
+  try {
+    for (std::map<unsigned int, Neuron*>::const_iterator it =
+	   m_neuron.begin(); it != m_neuron.end(); ++it) {
+      neurons.push_back(make_neuron(it->second->dump()));
+      neuron[it->first] = neurons.back();
+    }
+    for (std::map<unsigned int, Synapse*>::const_iterator it =
+	   m_synapse.begin(); it != m_synapse.end(); ++it) {
+      synapses.push_back(new network::Synapse(it->second->dump()));
+      synapses.back()->connect(neuron[it->second->input()->id()],
+			       neuron[it->second->output()->id()]);
+    }
+    retval = new network::Network(neurons, synapses, m_reporter);
+  }
+  catch (...) {
+    for (size_t i=0; i<synapses.size(); ++i) delete synapses[i];
+    for (size_t i=0; i<neurons.size(); ++i) delete neurons[i];
+    throw;
+  }
+  //the header is all the configuration a clone needs, e.g. to be saved
+  if (m_config)
+    retval->m_config = new config::Network(m_config->header(),
+					   std::vector<config::Synapse*>(),
+					   std::vector<config::Neuron*>(),
+					   m_reporter);
+  return retval;
+}
+
+void network::Network::copy (const network::Network& other)
+{
+  if (other.m_synapse.size() != m_synapse.size()) {
+    RINGER_DEBUG1("I cannot copy the weights of a network with "
+		  << other.m_synapse.size() << " synapses into one with "
+		  << m_synapse.size() << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Network layout mismatch");
+  }
+  std::map<unsigned int, Synapse*>::const_iterator jt =
+    other.m_synapse.begin();
+  for (std::map<unsigned int, Synapse*>::iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it, ++jt) {
+    if (it->first != jt->first) {
+      RINGER_DEBUG1("Synapse " << jt->first << " has no counterpart in"
+		    << " this network. Exception thrown.");
+      throw RINGER_EXCEPTION("Network layout mismatch");
+    }
+    it->second->weight(jt->second->weight());
+  }
+}
+
+void network::Network::copy_weights (std::vector<data::Feature>& w) const
+{
+  if (w.size() != m_synapse.size()) w.resize(m_synapse.size());
+  size_t k = 0;
+  for (std::map<unsigned int, Synapse*>::const_iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it, ++k) 
+    w[k] = it->second->weight();
+}
+
+void network::Network::set_weights (const std::vector<data::Feature>& w)
+{
+  if (w.size() != m_synapse.size()) {
+    RINGER_DEBUG1("I cannot set " << m_synapse.size() << " synapse weights"
+		  << " from a vector with " << w.size() << " entries."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Weight vector size mismatch");
+  }
+  size_t k = 0;
+  for (std::map<unsigned int, Synapse*>::iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it, ++k) 
+    it->second->weight(w[k]);
+}
+
+void network::Network::gradient (const data::PatternSet& data,
+				 const data::PatternSet& target,
+				 const std::vector<size_t>& pats,
+				 std::vector<data::Feature>& grad)
+{
+  for (std::map<unsigned int, Synapse*>::iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it) 
+    it->second->defer(true);
+  try {
+    train(data, target, pats);
+  }
+  catch (...) {
+    for (std::map<unsigned int, Synapse*>::iterator it =
+	   m_synapse.begin(); it != m_synapse.end(); ++it) 
+      it->second->defer(false);
+    throw;
+  }
+  if (grad.size() != m_synapse.size()) grad.resize(m_synapse.size());
+  size_t k = 0;
+  for (std::map<unsigned int, Synapse*>::iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it, ++k) {
+    grad[k] = it->second->derivative();
+    it->second->defer(false);
+  }
+}
+
+void network::Network::update (const std::vector<data::Feature>& grad)
+{
+  if (grad.size() != m_synapse.size()) {
+    RINGER_DEBUG1("I cannot update " << m_synapse.size() << " synapses"
+		  << " from a vector with " << grad.size() << " derivatives."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Derivative vector size mismatch");
+  }
+  size_t k = 0;
+  for (std::map<unsigned int, Synapse*>::iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it, ++k) 
+    it->second->update(grad[k]);
+}
+
+void network::Network::copy_state
+(std::vector<std::vector<data::Feature> >& s) const
+{
+  if (s.size() != m_synapse.size()) s.resize(m_synapse.size());
+  size_t k = 0;
+  for (std::map<unsigned int, Synapse*>::const_iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it, ++k) 
+    it->second->copy_state(s[k]);
+}
+
+void network::Network::set_state
+(const std::vector<std::vector<data::Feature> >& s)
+{
+  if (s.size() != m_synapse.size()) {
+    RINGER_DEBUG1("I cannot restore " << m_synapse.size() << " synapse"
+		  << " states from a vector with " << s.size() << " entries."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Synapse state vector size mismatch");
+  }
+  size_t k = 0;
+  for (std::map<unsigned int, Synapse*>::iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it, ++k) 
+    it->second->set_state(s[k]);
+}
+
+/**
+ * Tells if a neuron is one of the given output neurons
+ *
+ * @param output The output neurons of a network
+ * @param n The neuron to check
+ */
+static bool is_output (const std::vector<network::OutputNeuron*>& output,
+		       const network::Neuron* n)
+{
+  for (std::vector<network::OutputNeuron*>::const_iterator 
+	 it = output.begin(); it != output.end(); ++it)
+    if (*it == n) return true;
+  return false;
+}
+
+void network::Network::freeze (const bool& frozen)
+{
+  RINGER_DEBUG2((frozen?"Freezing":"Unfreezing") 
+		<< " all synapses not reaching output neurons.");
+  for (std::map<unsigned int, Synapse*>::iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it) {
+    if (!is_output(m_output, it->second->output()))
+      it->second->learning(!frozen);
+  }
+}
+
+network::Network* network::Network::output_layer
+(const data::PatternSet& input, data::PatternSet& features)
+{
+  RINGER_DEBUG2("Caching the output layer inputs for " << input.size()
+		<< " patterns.");
+  //which neurons feed the output layer, in the order I'll cache them?
+  std::vector<const Neuron*> source;
+  std::vector<config::Synapse*> synapse_config;
+  for (std::map<unsigned int, Synapse*>::const_iterator it =
+	 m_synapse.begin(); it != m_synapse.end(); ++it) {
+    if (!is_output(m_output, it->second->output())) continue;
+    synapse_config.push_back(new config::Synapse(it->second->dump()));
+    const Neuron* from = it->second->input();
+    bool seen = false;
+    for (size_t k=0; k<source.size(); ++k) 
+      if (source[k] == from) { seen = true; break; }
+    if (!seen) source.push_back(from);
+  }
+
+  //run the whole set once and cache the feeding neurons state
+  data::PatternSet output(input.size(), m_output.size());
+  run(input, output);
+  data::PatternSet(input.size(), source.size()).swap(features);
+  for (size_t k=0; k<source.size(); ++k) 
+    features.set_ensemble(k, source[k]->state());
+
+  //build the single layer network
+  std::vector<config::Neuron*> neuron_config;
+  for (size_t k=0; k<source.size(); ++k)
+    neuron_config.push_back(new config::Neuron(source[k]->id(), 
+					       config::INPUT));
+  for (std::vector<OutputNeuron*>::const_iterator it = m_output.begin();
+       it != m_output.end(); ++it) 
+    neuron_config.push_back(new config::Neuron((*it)->dump()));
+  config::Header header("UNSET AUTHOR", "OUTPUT LAYER", "0.0", time(0),
+			"Output layer with cached inputs");
+  config::Network config(&header, synapse_config, neuron_config, m_reporter);
+  for (std::vector<config::Neuron*>::iterator it =
+	 neuron_config.begin(); it != neuron_config.end(); ++it) delete *it;
+  for (std::vector<config::Synapse*>::iterator it =
+	 synapse_config.begin(); it != synapse_config.end(); ++it) delete *it;
+  RINGER_DEBUG2("Output layer has " << source.size() << " cached inputs.");
+  return new network::Network(config, m_reporter);
+}
+
+void network::Network::output_layer (const network::Network& layer)
+{
+  for (std::map<unsigned int, Synapse*>::const_iterator it =
+	 layer.m_synapse.begin(); it != layer.m_synapse.end(); ++it) {
+    std::map<unsigned int, Synapse*>::iterator mine = 
+      m_synapse.find(it->first);
+    if (mine == m_synapse.end()) {
+      RINGER_DEBUG1("Synapse " << it->first << " from the output layer does"
+		    << " not exist in this network. Exception thrown.");
+      throw RINGER_EXCEPTION("Output layer does not match network");
+    }
+    mine->second->weight(it->second->weight());
+  }
+}
+
 bool network::Network::dot (const std::string& filename) const
 {
   RINGER_DEBUG2("Trying to build a dot representation at \"" 
@@ -261,7 +534,7 @@ void network::Network::run (const data::PatternSet& input,
 		<< ". Currently the output size is " << output.size() 
 		<< " and the pattern size is " << output.pattern_size() 
 		<< ".");
-    output = data::PatternSet(input.size(), m_output.size(), 0);
+    data::PatternSet(input.size(), m_output.size(), 0).swap(output);
   }
   for (std::vector<OutputNeuron*>::iterator it = m_output.begin();
        it != m_output.end(); ++it, ++i) {
@@ -311,14 +584,82 @@ void network::Network::train (const data::PatternSet& data,
   RINGER_DEBUG3("(BATCH-RANDOM) Training network with " 
 		<< epoch << " Patterns");
   std::vector<size_t> pats(epoch);
-  static_rnd.draw(data.size(), pats); //get random positions
-  data::PatternSet input(data, pats); //get patterns for this iteration
-  data::PatternSet output(epoch, m_output.size()); //empty
-  run(input, output); //set network state
-  data::PatternSet error(target, pats);
-  error -= output; // calculates the error for this iteration
+  m_rnd.draw(data.size(), pats); //get random positions
+  train(data, target, pats);
+}
+
+void network::Network::feed (const data::PatternSet& input,
+			     const std::vector<size_t>& pats)
+{
+  data::Ensemble buffer(pats.size()); //re-used by all input neurons
+  unsigned int i=0;
+  for (std::vector<InputNeuron*>::iterator it = m_input.begin();
+       it != m_input.end(); ++it, ++i) {
+    input.ensemble(i, pats, buffer);
+    (*it)->run(buffer);
+  }
+  data::Ensemble dummy(pats.size(), 1);
+  for (std::vector<BiasNeuron*>::iterator it = m_bias.begin();
+       it != m_bias.end(); ++it) (*it)->run(dummy);
+}
+
+void network::Network::run (const data::PatternSet& input,
+			    const std::vector<size_t>& pats,
+			    data::PatternSet& output)
+{
+  RINGER_DEBUG3("Running " << pats.size() 
+		<< " selected pattern(s) through network.");
+  feed(input, pats);
+  if (output.size() != pats.size() || 
+      output.pattern_size() != m_output.size()) {
+    RINGER_DEBUG1("Resizing output... If you want to have faster processing"
+		<< " please consider giving an output PatternSet with as many"
+		<< " positions as selected patterns and as many ensembles as"
+		<< " output neurons, i.e., size = " << pats.size() << " and"
+		<< " ensemble size = " << m_output.size()
+		<< ". Currently the output size is " << output.size() 
+		<< " and the pattern size is " << output.pattern_size() 
+		<< ".");
+    data::PatternSet(pats.size(), m_output.size(), 0).swap(output);
+  }
   for (unsigned int j=0; j<m_output.size(); ++j)
-    m_output[j]->train(error.ensemble(j));
+    output.set_ensemble(j, m_output[j]->state());
+  RINGER_DEBUG3("Ran " << pats.size() << " pattern(s) through network.");
+}
+
+void network::Network::train (const data::PatternSet& data,
+			      const data::PatternSet& target,
+			      const std::vector<size_t>& pats)
+{
+  RINGER_DEBUG3("(BATCH-INDEXED) Training network with " 
+		<< pats.size() << " Patterns");
+  feed(data, pats); //set network state
+  data::Ensemble error(pats.size());
+  for (unsigned int j=0; j<m_output.size(); ++j) {
+    target.ensemble(j, pats, error);
+    error -= m_output[j]->state(); // calculates the error for this iteration
+    m_output[j]->train(error);
+  }
+  RINGER_DEBUG3("Network trained.");
+}
+
+void network::Network::train (const data::PatternSet& data,
+			      const data::PatternSet& target,
+			      const std::vector<size_t>& pats,
+			      const std::vector<double>& weights)
+{
+  RINGER_DEBUG3("(BATCH-WEIGHTED) Training network with " 
+		<< pats.size() << " Patterns");
+  feed(data, pats); //set network state
+  data::Ensemble weight(pats.size());
+  for (size_t i=0; i<pats.size(); ++i) weight[i] = weights[pats[i]];
+  data::Ensemble error(pats.size());
+  for (unsigned int j=0; j<m_output.size(); ++j) {
+    target.ensemble(j, pats, error);
+    error -= m_output[j]->state(); // calculates the error for this iteration
+    error *= weight;
+    m_output[j]->train(error);
+  }
   RINGER_DEBUG3("Network trained.");
 }
 
@@ -0,0 +1,290 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/Sweep.cxx
+ *
+ * Implements the parallel hyper-parameter sweep.
+ */
+
+#include "network/Sweep.h"
+#include "network/MLP.h"
+#include "config/NeuronBackProp.h"
+#include "config/SynapseBackProp.h"
+#include "config/SynapseRProp.h"
+#include "data/RandomInteger.h"
+#include "sys/ThreadPool.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+
+#include <sstream>
+#include <iomanip>
+#include <boost/bind.hpp>
+
+network::Sweep::Sweep (const data::PatternSet& train,
+		       const data::PatternSet& train_target,
+		       const data::PatternSet& test,
+		       const data::PatternSet& test_target,
+		       const data::Pattern& mean,
+		       const data::Pattern& stddev,
+		       const network::TrainerParameters& par,
+		       sys::Reporter& reporter)
+  : m_train(train),
+    m_train_target(train_target),
+    m_train_pats(),
+    m_test(test),
+    m_test_target(test_target),
+    m_mean(mean),
+    m_stddev(stddev),
+    m_par(par),
+    m_reporter(reporter),
+    m_prefix(),
+    m_result()
+{
+}
+
+network::Sweep::~Sweep ()
+{
+}
+
+void network::Sweep::subset (const std::vector<size_t>& train)
+{
+  m_train_pats = train;
+}
+
+void network::Sweep::add (const network::SweepPoint& p)
+{
+  if (!p.hidden || !p.epoch) {
+    RINGER_DEBUG1("Sweep configurations need at least one hidden neuron and"
+		  << " one pattern per epoch. Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid sweep configuration");
+  }
+  network::SweepResult r;
+  r.point = p;
+  r.best.step = 0;
+  r.best.mse = 0;
+  r.best.sp = 0;
+  r.best.monitor_mse = 0;
+  r.best.monitor_sp = 0;
+  r.steps = 0;
+  r.elapsed = 0;
+  r.failed = false;
+  m_result.push_back(r);
+}
+
+/**
+ * Tells if a list of sweep values is empty, throwing if so
+ *
+ * @param n How many values are in the list
+ * @param what The name of the list
+ */
+static void check_values (const size_t& n, const char* what)
+{
+  if (!n) {
+    RINGER_DEBUG1("The list of " << what << " values to sweep is empty."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Empty sweep value list");
+  }
+}
+
+void network::Sweep::grid (const std::vector<unsigned int>& hidden,
+			   const std::vector<unsigned int>& epoch,
+			   const config::SynapseStrategyType& strategy,
+			   const std::vector<double>& lrate,
+			   const std::vector<double>& momentum,
+			   const double& decay)
+{
+  check_values(hidden.size(), "hidden");
+  check_values(epoch.size(), "epoch");
+  check_values(lrate.size(), "learning rate");
+  std::vector<double> mom(momentum);
+  if (strategy != config::SYNAPSE_BACKPROP || mom.empty())
+    mom.assign(1, 0);
+  network::SweepPoint p;
+  p.strategy = strategy;
+  p.decay = decay;
+  for (size_t h=0; h<hidden.size(); ++h) {
+    p.hidden = hidden[h];
+    for (size_t e=0; e<epoch.size(); ++e) {
+      p.epoch = epoch[e];
+      for (size_t l=0; l<lrate.size(); ++l) {
+	p.lrate = lrate[l];
+	for (size_t m=0; m<mom.size(); ++m) {
+	  p.momentum = mom[m];
+	  add(p);
+	}
+      }
+    }
+  }
+}
+
+void network::Sweep::random (const size_t& n,
+			     const std::vector<unsigned int>& hidden,
+			     const std::vector<unsigned int>& epoch,
+			     const config::SynapseStrategyType& strategy,
+			     const std::vector<double>& lrate,
+			     const std::vector<double>& momentum,
+			     const double& decay,
+			     const size_t& seed)
+{
+  check_values(hidden.size(), "hidden");
+  check_values(epoch.size(), "epoch");
+  check_values(lrate.size(), "learning rate");
+  std::vector<double> mom(momentum);
+  if (strategy != config::SYNAPSE_BACKPROP || mom.empty())
+    mom.assign(1, 0);
+  data::RandomInteger rnd(seed);
+  network::SweepPoint p;
+  p.strategy = strategy;
+  p.decay = decay;
+  for (size_t i=0; i<n; ++i) {
+    p.hidden = hidden[rnd.draw(hidden.size())];
+    p.epoch = epoch[rnd.draw(epoch.size())];
+    p.lrate = lrate[rnd.draw(lrate.size())];
+    p.momentum = mom[rnd.draw(mom.size())];
+    add(p);
+  }
+}
+
+network::Network* network::Sweep::build (const network::SweepPoint& p,
+					  const size_t& input,
+					  const size_t& output,
+					  const data::Pattern& mean,
+					  const data::Pattern& stddev,
+					  sys::Reporter& reporter)
+{
+  std::vector<size_t> hlayer(1, p.hidden);
+  std::vector<bool> biaslayer(2, true);
+  config::NeuronBackProp nsparam(config::NeuronBackProp::TANH);
+  config::Parameter* ssparam = 0;
+  if (p.strategy == config::SYNAPSE_BACKPROP)
+    ssparam = new config::SynapseBackProp(p.lrate, p.momentum, p.decay);
+  else ssparam = new config::SynapseRProp(p.lrate);
+  network::Network* retval = 0;
+  try {
+    retval = new network::MLP(input, hlayer, output, biaslayer,
+			      config::NEURON_BACKPROP, &nsparam,
+			      config::NEURON_BACKPROP, &nsparam,
+			      p.strategy, ssparam, mean, stddev, reporter);
+  }
+  catch (...) {
+    delete ssparam;
+    throw;
+  }
+  delete ssparam;
+  return retval;
+}
+
+void network::Sweep::train (const size_t& i, network::Network* net,
+			    const data::RandomInteger& rnd)
+{
+  network::SweepResult& r = m_result[i];
+  try {
+    network::TrainerParameters par(m_par);
+    par.epoch = r.point.epoch;
+    network::Trainer trainer(*net, m_train, m_train_target, m_test,
+			     m_test_target, par, m_reporter, rnd);
+    trainer.subset(m_train_pats, std::vector<size_t>());
+    trainer.run();
+    r.best = trainer.best();
+    r.steps = trainer.steps();
+    r.elapsed = trainer.elapsed();
+    if (m_prefix.size()) {
+      std::ostringstream name;
+      name << m_prefix << "." << i << ".xml";
+      net->set_weights(trainer.best_weights());
+      net->save(name.str());
+    }
+  }
+  catch (sys::Exception& ex) {
+    delete net;
+    r.failed = true;
+    r.error = ex.info();
+    throw;
+  }
+  catch (...) {
+    delete net;
+    r.failed = true;
+    r.error = "unknown exception";
+    throw;
+  }
+  delete net;
+}
+
+void network::Sweep::run (const size_t& threads)
+{
+  sys::ThreadPool pool(threads);
+  RINGER_REPORT(m_reporter, "Sweeping " << m_result.size()
+		<< " configurations on " << pool.size() << " threads.");
+  //networks and generators are set up here, in order, so the initial
+  //weights and minibatches do not depend on how the threads are scheduled
+  //(trainers take every other stream, as they use the next one as well)
+  data::RandomInteger base;
+  bool failed = false;
+  for (size_t i=0; i<m_result.size(); ++i) {
+    m_result[i].failed = false;
+    m_result[i].error.clear();
+    network::Network* net = 0;
+    try {
+      net = build(m_result[i].point, m_train.pattern_size(),
+		  m_train_target.pattern_size(), m_mean, m_stddev, m_reporter);
+    }
+    catch (sys::Exception& ex) {
+      m_result[i].failed = failed = true;
+      m_result[i].error = ex.info();
+      continue;
+    }
+    pool.submit(boost::bind(&network::Sweep::train, this, i, net,
+			    base.stream(2*i)));
+  }
+  try {
+    pool.wait();
+  }
+  catch (sys::Exception&) {
+    failed = true;
+  }
+  if (failed)
+    RINGER_WARN(m_reporter, "Some sweep configurations failed to train."
+		<< " They are flagged in the summary.");
+}
+
+size_t network::Sweep::best (void) const
+{
+  size_t retval = m_result.size();
+  for (size_t i=0; i<m_result.size(); ++i) {
+    if (m_result[i].failed) continue;
+    if (retval == m_result.size()) { retval = i; continue; }
+    const network::Evaluation& b = m_result[i].best;
+    const network::Evaluation& r = m_result[retval].best;
+    if (m_par.msestop? (b.mse < r.mse) : (b.sp > r.sp)) retval = i;
+  }
+  if (retval == m_result.size()) {
+    RINGER_DEBUG1("No sweep configuration was trained successfully."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("No successful sweep configuration");
+  }
+  return retval;
+}
+
+void network::Sweep::table (std::ostream& os) const
+{
+  os << "#   id hidden  epoch strategy      lrate   momentum     best-sp"
+     << "    best-mse  at-step  steps   time(s)\n";
+  for (size_t i=0; i<m_result.size(); ++i) {
+    const network::SweepResult& r = m_result[i];
+    os << std::setw(6) << i << " " << std::setw(6) << r.point.hidden << " "
+       << std::setw(6) << r.point.epoch << " " << std::setw(8)
+       << (r.point.strategy == config::SYNAPSE_BACKPROP? "backprop" : "rprop")
+       << " " << std::setw(10) << r.point.lrate << " " << std::setw(10)
+       << r.point.momentum << " ";
+    if (r.failed) {
+      os << std::setw(11) << "failed" << " " << r.error << "\n";
+      continue;
+    }
+    os << std::setw(11) << r.best.sp << " " << std::setw(11) << r.best.mse
+       << " " << std::setw(8) << r.best.step << " " << std::setw(6)
+       << r.steps << " " << std::setw(9) << std::fixed
+       << std::setprecision(2) << r.elapsed << "\n";
+    os.unsetf(std::ios_base::floatfield);
+    os << std::setprecision(6);
+  }
+}
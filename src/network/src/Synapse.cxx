@@ -13,6 +13,8 @@
 #include "sys/debug.h"
 #include "network/SynapseBackProp.h"
 #include "network/SynapseRProp.h"
+#include "data/MeanExtractor.h"
+#include <algorithm>
 
 unsigned int network::Synapse::s_id = 0; ///< initialisation
 
@@ -25,6 +27,8 @@ network::Synapse::Synapse (const data::Feature& init,
     m_in(0),
     m_out(0),
     m_learns(true),
+    m_defer(false),
+    m_deriv(0),
     m_state(1, 0),
     m_strategy(strategy),
     m_teacher(0)
@@ -57,6 +61,8 @@ network::Synapse::Synapse (const config::Synapse& config)
     m_in(0),
     m_out(0),
     m_learns(true),
+    m_defer(false),
+    m_deriv(0),
     m_state(1, 0),
     m_strategy(config.strategy()),
     m_teacher(0)
@@ -85,6 +91,19 @@ void network::Synapse::learning (const bool& switch_to)
   m_learns = switch_to;
 }
 
+void network::Synapse::defer (const bool& switch_to)
+{
+  m_defer = switch_to;
+  m_deriv = 0;
+}
+
+void network::Synapse::update (const data::Feature& deriv)
+{
+  if (!m_learns) return;
+  m_weight += m_teacher->update(deriv);
+  RINGER_DEBUG2("Synapse[" << id() << "] weight is " << m_weight << " now.");
+}
+
 void network::Synapse::pass (const data::Ensemble& data)
 {
   RINGER_DEBUG3("Passing data through synapse " << m_id 
@@ -118,7 +137,11 @@ void network::Synapse::learn (const data::Ensemble& lesson)
   if (m_learns) {
     // Calls the input neuron, *before* adjusting the synaptic weight, to get
     // the weight adjustment right.
-    weight_change = m_teacher->teach(m_in->state(), lesson);
+    if (m_defer) {
+      data::MeanExtractor mean;
+      m_deriv = mean(lesson * m_in->state());
+    }
+    else weight_change = m_teacher->teach(m_in->state(), lesson);
   }
   // Forwards the error signal backward, before applying the weight adjustment
   m_state *= m_weight;
@@ -130,6 +153,26 @@ void network::Synapse::learn (const data::Ensemble& lesson)
   RINGER_DEBUG2("Synapse[" << id() << "] weight is " << m_weight << " now.");
 }
 
+void network::Synapse::copy_state (std::vector<data::Feature>& s) const
+{
+  std::vector<data::Feature> learning;
+  m_teacher->copy_state(learning);
+  s.resize(1 + learning.size());
+  s[0] = m_weight;
+  std::copy(learning.begin(), learning.end(), s.begin()+1);
+}
+
+void network::Synapse::set_state (const std::vector<data::Feature>& s)
+{
+  if (s.empty()) {
+    RINGER_DEBUG1("Synapse[" << id() << "] state cannot be empty."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Empty synapse state");
+  }
+  m_teacher->set_state(std::vector<data::Feature>(s.begin()+1, s.end()));
+  m_weight = s[0];
+}
+
 unsigned int network::Synapse::new_id (void)
 {
   return s_id++;
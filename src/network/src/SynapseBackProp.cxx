@@ -52,7 +52,12 @@ data::Feature strategy::SynapseBackProp::teach (const data::Ensemble& input,
 {
   RINGER_DEBUG3("SynapseBackProp::teach called.");
   data::MeanExtractor mean;
-  data::Feature delta = m_lrate * mean(lesson * input);
+  return update(mean(lesson * input));
+}
+
+data::Feature strategy::SynapseBackProp::update (const data::Feature& deriv)
+{
+  data::Feature delta = m_lrate * deriv;
   RINGER_DEBUG2("Calculating synaptic weight adjustment with change = "
 		<< delta << ", learning rate = " << m_lrate
 		<< ", momentum = " << m_momentum
@@ -73,6 +78,24 @@ data::Feature strategy::SynapseBackProp::teach (const data::Ensemble& input,
   return retval;
 }
 
+void strategy::SynapseBackProp::copy_state (std::vector<data::Feature>& s) const
+{
+  s.resize(2);
+  s[0] = m_lrate;
+  s[1] = m_prev_delta;
+}
+
+void strategy::SynapseBackProp::set_state (const std::vector<data::Feature>& s)
+{
+  if (s.size() != 2) {
+    RINGER_DEBUG1("BackProp learning state has 2 entries, not " << s.size()
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid BackProp learning state");
+  }
+  m_lrate = s[0];
+  m_prev_delta = s[1];
+}
+
 config::SynapseBackProp strategy::SynapseBackProp::dump (void) const
 {
   return config::SynapseBackProp(m_lrate, m_momentum, m_decay);
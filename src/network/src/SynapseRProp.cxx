@@ -53,7 +53,11 @@ data::Feature strategy::SynapseRProp::teach (const data::Ensemble& input,
 {
   RINGER_DEBUG3("SynapseRProp::teach called.");
   data::MeanExtractor mean;
-  data::Feature deriv = mean(lesson * input);
+  return update(mean(lesson * input));
+}
+
+data::Feature strategy::SynapseRProp::update (const data::Feature& deriv)
+{
   RINGER_DEBUG1("Calculating synaptic weight adjustment with change = "
                 << deriv << ", weight update = " << m_weight_update
                 << ", previous derivative = " << m_prev_deriv
@@ -81,6 +85,26 @@ data::Feature strategy::SynapseRProp::teach (const data::Ensemble& input,
   return retval;
 }
 
+void strategy::SynapseRProp::copy_state (std::vector<data::Feature>& s) const
+{
+  s.resize(3);
+  s[0] = m_weight_update;
+  s[1] = m_prev_delta;
+  s[2] = m_prev_deriv;
+}
+
+void strategy::SynapseRProp::set_state (const std::vector<data::Feature>& s)
+{
+  if (s.size() != 3) {
+    RINGER_DEBUG1("RProp learning state has 3 entries, not " << s.size()
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid RProp learning state");
+  }
+  m_weight_update = s[0];
+  m_prev_delta = s[1];
+  m_prev_deriv = s[2];
+}
+
 config::SynapseRProp strategy::SynapseRProp::dump (void) const
 {
   return config::SynapseRProp(m_weight_update);
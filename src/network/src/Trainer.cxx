@@ -0,0 +1,560 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file network/src/Trainer.cxx
+ *
+ * Implements a complete training session for a single network.
+ */
+
+#include "network/Trainer.h"
+#include "data/MemorySource.h"
+#include "data/FileSource.h"
+#include "data/Prefetcher.h"
+#include "sys/debug.h"
+#include "sys/Exception.h"
+#include "sys/util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+
+network::Trainer::Trainer (network::Network& net,
+			   const data::PatternSet& train,
+			   const data::PatternSet& train_target,
+			   const data::PatternSet& test,
+			   const data::PatternSet& test_target,
+			   const network::TrainerParameters& par,
+			   sys::Reporter& reporter,
+			   const data::RandomInteger& rnd)
+  : m_net(net),
+    m_train(train),
+    m_train_target(train_target),
+    m_test(test),
+    m_test_target(test_target),
+    m_train_pats(),
+    m_test_pats(),
+    m_weights(),
+    m_quick(),
+    m_monitor(0),
+    m_monitor_target(0),
+    m_par(par),
+    m_reporter(reporter),
+    m_rnd(rnd),
+    m_quick_rnd(m_rnd.stream(0)),
+    m_steps(0),
+    m_best(),
+    m_best_weights(),
+    m_history(),
+    m_writer(0),
+    m_elapsed(0),
+    m_stopnow(0),
+    m_val(0),
+    m_state_file(),
+    m_state_every(0),
+    m_skipped(0),
+    m_quick_val(0),
+    m_screening(),
+    m_stream(),
+    m_stream_targets()
+{
+  if (!m_par.epoch || !m_par.sample || !m_par.stopiter || !m_par.hardstop) {
+    RINGER_DEBUG1("The epoch, sample, stop iteration and hard stop"
+		  << " parameters have to be greater than zero. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("Invalid training parameters");
+  }
+  if (m_par.subsample < 0 || m_par.subsample >= 1 || m_par.tolerance < 0) {
+    RINGER_DEBUG1("The test subsample fraction has to be in [0,1) and the"
+		  << " screening tolerance cannot be negative. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("Invalid screening parameters");
+  }
+  if (!m_par.msestop && m_test_target.pattern_size() != 1) {
+    RINGER_DEBUG1("I can only use the SP product as figure of merit for"
+		  << " networks with a single output. Exception thrown.");
+    throw RINGER_EXCEPTION("SP product requires a single output");
+  }
+  m_best.step = 0;
+  m_best.mse = 0;
+  m_best.sp = 0;
+  m_best.monitor_mse = 0;
+  m_best.monitor_sp = 0;
+}
+
+network::Trainer::~Trainer ()
+{
+  delete m_writer;
+}
+
+void network::Trainer::checkpoint (const std::string& file,
+				   const config::Header* header)
+{
+  delete m_writer;
+  m_writer = 0;
+  m_writer = new network::CheckpointWriter(m_net, file, header, m_reporter);
+}
+
+/**
+ * Checks all indexes of a subset point to patterns of a set
+ *
+ * @param pats The subset
+ * @param size The size of the set
+ */
+static void check_subset (const std::vector<size_t>& pats, const size_t& size)
+{
+  for (size_t i=0; i<pats.size(); ++i) {
+    if (pats[i] >= size) {
+      RINGER_DEBUG1("Subset index " << pats[i] << " is out of a set with "
+		    << size << " patterns. Exception thrown.");
+      throw RINGER_EXCEPTION("Subset index out of range");
+    }
+  }
+}
+
+void network::Trainer::subset (const std::vector<size_t>& train,
+			       const std::vector<size_t>& test)
+{
+  check_subset(train, m_train.size());
+  check_subset(test, m_test.size());
+  m_train_pats = train;
+  m_test_pats = test;
+  m_quick.clear();
+}
+
+void network::Trainer::weights (const std::vector<double>& weights)
+{
+  if (!weights.empty() && weights.size() != m_train.size()) {
+    RINGER_DEBUG1("There are " << weights.size() << " weights for a training"
+		  << " set with " << m_train.size() << " patterns. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("Training weights do not match the training set");
+  }
+  if (!weights.empty() && m_par.prefetch) {
+    RINGER_DEBUG1("Training weights cannot be used with prefetched"
+		  << " minibatches. Exception thrown.");
+    throw RINGER_EXCEPTION("Training weights cannot be prefetched");
+  }
+  m_weights = weights;
+}
+
+void network::Trainer::stream (const std::string& file,
+			       const std::map<std::string, data::Pattern*>&
+			       targets)
+{
+  if (!file.empty() && !m_weights.empty()) {
+    RINGER_DEBUG1("Training weights cannot be used with minibatches"
+		  << " streamed from \"" << file << "\". Exception thrown.");
+    throw RINGER_EXCEPTION("Training weights cannot be streamed");
+  }
+  if (!file.empty() && targets.empty()) {
+    RINGER_DEBUG1("I need the targets of the classes to stream from \""
+		  << file << "\". Exception thrown.");
+    throw RINGER_EXCEPTION("No targets to stream with");
+  }
+  m_stream = file;
+  m_stream_targets = targets;
+  if (!m_stream.empty()) m_par.prefetch = true;
+}
+
+void network::Trainer::monitor (const data::PatternSet& data,
+				const data::PatternSet& target)
+{
+  m_monitor = &data;
+  m_monitor_target = &target;
+}
+
+network::Evaluation network::Trainer::evaluate (const unsigned int& step)
+{
+  return network::Evaluator::evaluate(m_net, step, m_test, m_test_target,
+				      m_monitor, m_monitor_target,
+				      m_test_pats.empty()? 0 : &m_test_pats);
+}
+
+bool network::Trainer::better (const network::Evaluation& e) const
+{
+  if (m_par.msestop) return e.mse < m_best.mse;
+  return e.sp > m_best.sp;
+}
+
+void network::Trainer::record (const network::Evaluation& e,
+			       const std::vector<data::Feature>* weights)
+{
+  m_history.push_back(e);
+  double prev = m_val;
+  m_val = m_par.msestop? e.mse : e.sp;
+  if (better(e)) {
+    m_best = e;
+    if (weights) m_best_weights = *weights;
+    else m_net.copy_weights(m_best_weights);
+    if (m_writer) m_writer->submit(m_best_weights);
+  }
+  countdown(prev, m_val);
+}
+
+void network::Trainer::countdown (const double& prev, const double& val)
+{
+  double var = (prev != 0)? std::fabs(val-prev)/std::fabs(prev) : 1;
+  if (var >= m_par.stopthres) m_stopnow = m_par.stopiter;
+  else if (m_stopnow) --m_stopnow;
+}
+
+void network::Trainer::stratify (void)
+{
+  //the subsample must not change the minibatch draws, so it gets its own
+  //generator, which is copied to draw the same subsample every time
+  data::RandomInteger rnd(m_quick_rnd);
+  std::map<std::vector<data::Feature>, std::vector<size_t> > strata;
+  std::vector<data::Feature> key(m_test_target.pattern_size());
+  const size_t n = m_test_pats.empty()? m_test.size() : m_test_pats.size();
+  for (size_t i=0; i<n; ++i) {
+    size_t p = m_test_pats.empty()? i : m_test_pats[i];
+    const data::Pattern t = m_test_target.pattern(p);
+    for (size_t j=0; j<key.size(); ++j) key[j] = t[j];
+    strata[key].push_back(p);
+  }
+  m_quick.clear();
+  for (std::map<std::vector<data::Feature>, std::vector<size_t> >::iterator
+	 it = strata.begin(); it != strata.end(); ++it) {
+    std::vector<size_t>& pool = it->second;
+    size_t take = lrint(std::ceil(m_par.subsample * pool.size()));
+    //partial Fisher-Yates: the first "take" entries are the sample
+    for (size_t i=0; i<take; ++i)
+      std::swap(pool[i], pool[i + rnd.draw(pool.size() - i)]);
+    m_quick.insert(m_quick.end(), pool.begin(), pool.begin() + take);
+  }
+  std::sort(m_quick.begin(), m_quick.end());
+  RINGER_DEBUG2("Screening evaluations on " << m_quick.size() << " of " << n
+		<< " test patterns, in " << strata.size() << " strata.");
+}
+
+bool network::Trainer::screen (const unsigned int& step)
+{
+  if (!m_par.subsample) return true;
+  if (m_quick.empty()) stratify();
+  network::Evaluation e =
+    network::Evaluator::evaluate(m_net, step, m_test, m_test_target, 0, 0,
+				 &m_quick);
+  bool close = m_par.msestop?
+    (e.mse <= m_best.mse * (1 + m_par.tolerance)) :
+    (e.sp >= m_best.sp * (1 - m_par.tolerance));
+  //subsample figures are only compared to each other
+  double prev = m_quick_val;
+  m_quick_val = m_par.msestop? e.mse : e.sp;
+  if (!close) {
+    ++m_skipped;
+    countdown(prev, m_quick_val);
+  }
+  network::Screening s;
+  s.quick = e;
+  s.evaluated = close;
+  m_screening.push_back(s);
+  RINGER_DEBUG2("[step " << step << "] Subsample "
+		<< (m_par.msestop? "MSE = " : "SP = ")
+		<< (m_par.msestop? e.mse : e.sp) << ", best "
+		<< (m_par.msestop? m_best.mse : m_best.sp) << ": "
+		<< (close? "evaluating the whole test set." : "skipped."));
+  return close;
+}
+
+void network::Trainer::run (void)
+{
+  double start = sys::wallclock();
+  std::vector<size_t> pats(m_par.epoch);
+  if (m_history.empty()) {
+    m_history.push_back(evaluate(m_steps));
+    m_best = m_history.back();
+    m_net.copy_weights(m_best_weights);
+    if (m_writer) m_writer->submit(m_best_weights);
+    m_val = m_par.msestop? m_best.mse : m_best.sp;
+    //a resumed run keeps its countdown, even if it was over already
+    m_stopnow = m_par.stopiter;
+  }
+  network::Evaluator* bg = 0;
+  data::BatchSource* source = 0;
+  data::Prefetcher* prefetch = 0;
+  try {
+    if (m_par.background)
+      bg = new network::Evaluator(m_net, m_test, m_test_target, m_monitor,
+				  m_monitor_target, m_reporter, 2,
+				  m_test_pats.empty()? 0 : &m_test_pats);
+    if (m_par.prefetch) {
+      //minibatches are contiguous copies, trained on in order
+      if (m_stream.empty())
+	source = new data::MemorySource(m_train, m_train_target, m_train_pats,
+					m_rnd.draw(1<<30) + 1);
+      else {
+	source = new data::FileSource(m_stream, m_stream_targets);
+	if (source->pattern_size() != m_train.pattern_size() ||
+	    source->target_size() != m_train_target.pattern_size()) {
+	  RINGER_DEBUG1("The patterns streamed from \"" << m_stream
+			<< "\" do not match the training set. Exception"
+			<< " thrown.");
+	  throw RINGER_EXCEPTION("Streamed patterns do not fit the network");
+	}
+      }
+      prefetch = new data::Prefetcher(*source, m_par.epoch);
+      for (size_t i=0; i<pats.size(); ++i) pats[i] = i;
+    }
+    network::Evaluation e;
+    std::vector<data::Feature> w;
+    const data::PatternSet* batch = 0;
+    const data::PatternSet* batch_target = 0;
+    while (m_stopnow && m_steps < m_par.hardstop) {
+      if (prefetch) {
+	prefetch->next(batch, batch_target);
+	m_net.train(*batch, *batch_target, pats);
+      }
+      else {
+	if (m_train_pats.empty()) m_rnd.draw(m_train.size(), pats);
+	else {
+	  m_rnd.draw(m_train_pats.size(), pats);
+	  for (size_t i=0; i<pats.size(); ++i) 
+	    pats[i] = m_train_pats[pats[i]];
+	}
+	if (m_weights.empty()) m_net.train(m_train, m_train_target, pats);
+	else m_net.train(m_train, m_train_target, pats, m_weights);
+      }
+      ++m_steps;
+      if (bg) {
+	while (m_stopnow && bg->collect(e, w, false)) record(e, &w);
+      }
+      if (m_steps % m_par.sample) continue;
+      if (screen(m_steps)) {
+	if (bg) {
+	  m_net.copy_weights(w);
+	  bg->submit(m_steps, w);
+	}
+	else record(evaluate(m_steps), 0);
+      }
+      if (m_state_every && !(m_steps % (m_par.sample*m_state_every))) {
+	//the state must not depend on evaluations still in flight
+	if (bg) while (bg->collect(e, w, true)) record(e, &w);
+	double now = sys::wallclock();
+	m_elapsed += now - start;
+	start = now;
+	save(m_state_file);
+      }
+    }
+    //all submitted snapshots are evaluated, one of them may be the best
+    if (bg) while (bg->collect(e, w, true)) record(e, &w);
+  }
+  catch (...) {
+    delete prefetch;
+    delete source;
+    delete bg;
+    throw;
+  }
+  delete prefetch;
+  delete source;
+  delete bg;
+  if (m_writer) m_writer->flush();
+  m_elapsed += sys::wallclock() - start;
+  if (m_state_every) save(m_state_file);
+  RINGER_DEBUG2("Training finished after " << m_steps << " steps. Best"
+		<< " network was seen at step " << m_best.step << ".");
+}
+
+void network::Trainer::snapshot (const std::string& file,
+				 const unsigned int& every)
+{
+  m_state_file = file;
+  m_state_every = every;
+}
+
+/**
+ * Writes an evaluation as a single line
+ *
+ * @param os Where to write
+ * @param e The evaluation to write
+ */
+static void write_evaluation (std::ostream& os, const network::Evaluation& e)
+{
+  os << e.step << " " << e.mse << " " << e.sp << " " << e.monitor_mse
+     << " " << e.monitor_sp << "\n";
+}
+
+/**
+ * Reads an evaluation written by write_evaluation()
+ *
+ * @param is Where to read from
+ * @param e Where to place the evaluation
+ */
+static void read_evaluation (std::istream& is, network::Evaluation& e)
+{
+  is >> e.step >> e.mse >> e.sp >> e.monitor_mse >> e.monitor_sp;
+}
+
+/**
+ * Reads a keyword from a training state file, throwing if it is not the
+ * expected one
+ *
+ * @param is Where to read from
+ * @param key The expected keyword
+ */
+static void expect (std::istream& is, const std::string& key)
+{
+  std::string word;
+  is >> word;
+  if (!is || word != key) {
+    RINGER_DEBUG1("Expected \"" << key << "\" in training state file, but"
+		  << " got \"" << word << "\". Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid training state file");
+  }
+}
+
+void network::Trainer::save (const std::string& file) const
+{
+  const std::string tmp = file + ".tmp";
+  std::ofstream os(tmp.c_str());
+  //17 significant digits make doubles survive the round trip exactly
+  os << std::setprecision(17);
+  os << "neuralringer-training-state 3\n";
+  os << "run-seed " << data::RandomInteger::run_seed() << "\n";
+  os << "steps " << m_steps << "\n";
+  os << "elapsed " << m_elapsed << "\n";
+  os << "random " << m_rnd.state() << "\n";
+  os << "screening-random " << m_quick_rnd.state() << "\n";
+  os << "stopnow " << m_stopnow << "\n";
+  os << "merit " << m_val << "\n";
+  os << "screening-merit " << m_quick_val << "\n";
+  os << "skipped " << m_skipped << "\n";
+  os << "best ";
+  write_evaluation(os, m_best);
+  os << "history " << m_history.size() << "\n";
+  for (size_t i=0; i<m_history.size(); ++i) 
+    write_evaluation(os, m_history[i]);
+  os << "screening " << m_screening.size() << "\n";
+  for (size_t i=0; i<m_screening.size(); ++i) {
+    os << m_screening[i].evaluated << " ";
+    write_evaluation(os, m_screening[i].quick);
+  }
+  os << "best-weights " << m_best_weights.size();
+  for (size_t i=0; i<m_best_weights.size(); ++i)
+    os << " " << m_best_weights[i];
+  os << "\n";
+  std::vector<std::vector<data::Feature> > state;
+  m_net.copy_state(state);
+  os << "synapses " << state.size() << "\n";
+  for (size_t i=0; i<state.size(); ++i) {
+    os << state[i].size();
+    for (size_t j=0; j<state[i].size(); ++j) os << " " << state[i][j];
+    os << "\n";
+  }
+  os.close();
+  if (!os || std::rename(tmp.c_str(), file.c_str()) != 0) {
+    RINGER_DEBUG1("Could not write training state to \"" << file << "\"."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot write training state");
+  }
+  RINGER_DEBUG2("Training state at step " << m_steps << " saved to \""
+		<< file << "\".");
+}
+
+void network::Trainer::load (const std::string& file)
+{
+  std::ifstream is(file.c_str());
+  if (!is) {
+    RINGER_DEBUG1("Could not open training state file \"" << file << "\"."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot read training state");
+  }
+  expect(is, "neuralringer-training-state");
+  expect(is, "3");
+  unsigned int steps, stopnow, skipped;
+  std::string random, quick_random;
+  double elapsed, val, quick_val;
+  network::Evaluation best;
+  size_t n, seed;
+  expect(is, "run-seed"); is >> seed;
+  if (is && seed != data::RandomInteger::run_seed()) {
+    RINGER_DEBUG1("Training state file \"" << file << "\" was saved with"
+		  << " run seed " << seed << ", but this run has seed "
+		  << data::RandomInteger::run_seed() << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Training state was saved with another seed");
+  }
+  expect(is, "steps"); is >> steps;
+  expect(is, "elapsed"); is >> elapsed;
+  expect(is, "random"); is >> random;
+  expect(is, "screening-random"); is >> quick_random;
+  expect(is, "stopnow"); is >> stopnow;
+  expect(is, "merit"); is >> val;
+  expect(is, "screening-merit"); is >> quick_val;
+  expect(is, "skipped"); is >> skipped;
+  expect(is, "best"); read_evaluation(is, best);
+  expect(is, "history"); is >> n;
+  std::vector<network::Evaluation> history(n);
+  for (size_t i=0; i<n; ++i) read_evaluation(is, history[i]);
+  expect(is, "screening"); is >> n;
+  std::vector<network::Screening> screening(n);
+  for (size_t i=0; i<n; ++i) {
+    is >> screening[i].evaluated;
+    read_evaluation(is, screening[i].quick);
+  }
+  expect(is, "best-weights"); is >> n;
+  std::vector<data::Feature> best_weights(n);
+  for (size_t i=0; i<n; ++i) is >> best_weights[i];
+  expect(is, "synapses"); is >> n;
+  std::vector<std::vector<data::Feature> > state(n);
+  for (size_t i=0; i<n && is; ++i) {
+    size_t k;
+    is >> k;
+    state[i].resize(k);
+    for (size_t j=0; j<k; ++j) is >> state[i][j];
+  }
+  if (!is) {
+    RINGER_DEBUG1("Training state file \"" << file << "\" is truncated."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid training state file");
+  }
+  if (best_weights.size() != m_net.synapse_size()) {
+    RINGER_DEBUG1("Training state file \"" << file << "\" was written for a"
+		  << " network with " << best_weights.size() << " synapses,"
+		  << " but mine has " << m_net.synapse_size() << "."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Training state does not match network");
+  }
+  data::RandomInteger rnd(m_rnd);
+  rnd.state(random); //throws before anything is changed, if invalid
+  data::RandomInteger quick_rnd(m_quick_rnd);
+  quick_rnd.state(quick_random);
+  m_net.set_state(state);
+  m_steps = steps;
+  m_elapsed = elapsed;
+  m_rnd = rnd;
+  m_quick_rnd = quick_rnd;
+  m_quick.clear(); //drawn again from the restored generator
+  m_stopnow = stopnow;
+  m_val = val;
+  m_quick_val = quick_val;
+  m_skipped = skipped;
+  m_best = best;
+  m_history.swap(history);
+  m_screening.swap(screening);
+  m_best_weights.swap(best_weights);
+  RINGER_DEBUG2("Training state at step " << m_steps << " loaded from \""
+		<< file << "\".");
+}
+
+size_t network::Trainer::run_seed (const std::string& file)
+{
+  std::ifstream is(file.c_str());
+  if (!is) {
+    RINGER_DEBUG1("Could not open training state file \"" << file << "\"."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot read training state");
+  }
+  expect(is, "neuralringer-training-state");
+  expect(is, "3");
+  expect(is, "run-seed");
+  size_t seed = 0;
+  is >> seed;
+  if (!is) {
+    RINGER_DEBUG1("Training state file \"" << file << "\" is truncated."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid training state file");
+  }
+  return seed;
+}
@@ -0,0 +1,304 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file mlp-bintrain.cxx
+ *
+ * Trains one MLP per bin of a binning variable, such as the transverse
+ * energy, concurrently. The training and test databases are loaded only
+ * once and the binning variable is either a feature (column) of the
+ * patterns or an entry attribute. The best networks are written as a
+ * bundle, see network::BinTrainer::save().
+ */
+
+#include "data/PatternSet.h"
+#include "data/Database.h"
+#include "network/BinTrainer.h"
+#include "sys/Reporter.h"
+#include "sys/Exception.h"
+#include "sys/debug.h"
+#include "sys/util.h"
+#include "sys/OptParser.h"
+#include "config/type.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+typedef struct param_t {
+  std::string traindb; ///< database to use for training
+  std::string testdb; ///< database to use for testing
+  std::string attribute; ///< the entry attribute to bin on
+  std::string edges; ///< the bin edges
+  std::string bundle; ///< the prefix of the network bundle to write
+  long int column; ///< the feature to bin on
+  long int hidden; ///< the hidden layer size
+  long int epoch; ///< the epoch size
+  data::Feature lrate; ///< the learning rate or weight update
+  data::Feature momentum; ///< the momentum (backprop only)
+  data::Feature decay; ///< the learning rate decay (backprop only)
+  bool backprop; ///< use back propagation instead of RProp
+  bool msestop; ///< use MSE product stop criteria instead of SP stabilisation
+  bool compress; ///< if I should use compressed or extended output
+  long int stopiter; ///< number of iterations w/o variance to stop
+  data::Feature stopthres; ///< the threshold to consider for stopping
+  long int sample; ///< the sample interval for MSE or SP
+  long int hardstop; ///< where to hard stop the training
+  long int threads; ///< how many bins to train concurrently
+} param_t;
+
+/**
+ * Splits a comma separated list of numbers
+ *
+ * @param s The list to split
+ * @param v Where to put the numbers
+ */
+template <typename T> bool split_list (const std::string& s,
+				       std::vector<T>& v)
+{
+  v.clear();
+  std::istringstream is(s);
+  std::string item;
+  while (std::getline(is, item, ',')) {
+    std::istringstream conv(item);
+    T value;
+    if (!(conv >> value)) return false;
+    v.push_back(value);
+  }
+  return !v.empty();
+}
+
+/**
+ * Checks and validates program options.
+ *
+ * @param p The parameters, already parsed
+ * @param reporter The reporter to use when reporting problems to the user
+ */
+bool checkopt (param_t& par, sys::Reporter& reporter)
+{
+  if (!par.traindb.size()) {
+    RINGER_DEBUG1("I cannot work without a training database. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("No training database specified.");
+  }
+  if (!par.testdb.size()) {
+    RINGER_DEBUG1("I cannot work without a testing database. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("No testing database specified.");
+  }
+  if (!sys::exists(par.traindb)) {
+    RINGER_DEBUG1("Train Database file " << par.traindb << " doesn't exist.");
+    throw RINGER_EXCEPTION("Train database file doesn't exist.");
+  }
+  if (!sys::exists(par.testdb)) {
+    RINGER_DEBUG1("Test Database file " << par.testdb << " doesn't exist.");
+    throw RINGER_EXCEPTION("Test database file doesn't exist.");
+  }
+  if ((par.column < 0) == (par.attribute.size() == 0)) {
+    RINGER_DEBUG1("Either a binning column or a binning attribute has to"
+		  << " be given, but not both.");
+    throw RINGER_EXCEPTION("Ambiguous or missing binning variable.");
+  }
+  if (!par.edges.size()) {
+    RINGER_DEBUG1("I cannot work without bin edges.");
+    throw RINGER_EXCEPTION("No bin edges specified.");
+  }
+  if (par.hidden <= 0 || par.epoch <= 0) {
+    RINGER_DEBUG1("The hidden layer and epoch sizes have to be greater"
+		  << " than zero.");
+    throw RINGER_EXCEPTION("Invalid hidden layer or epoch size.");
+  }
+  if (par.sample <= 0 || par.stopiter <= 0 || par.hardstop <= 0) {
+    RINGER_DEBUG1("The sample interval, stop iteration and hard stop have"
+		  << " to be greater than zero.");
+    throw RINGER_EXCEPTION("Invalid stop criteria.");
+  }
+  if (par.stopthres <= 0) {
+    RINGER_DEBUG1("Trying to set the stop threshold to " << par.stopthres);
+    throw RINGER_EXCEPTION("Stop threshold should be > 0.");
+  }
+  if (par.threads < 0) {
+    RINGER_DEBUG1("The number of threads cannot be negative.");
+    throw RINGER_EXCEPTION("Negative thread count.");
+  }
+  if (!par.bundle.size()) {
+    par.bundle = sys::stripname(par.traindb) + ".bin";
+    RINGER_DEBUG1("Setting network bundle prefix to " << par.bundle);
+  }
+  RINGER_DEBUG1("Command line options have been validated.");
+  return true;
+}
+
+/**
+ * Bins the merged patterns of a database
+ *
+ * @param db The database
+ * @param par The program parameters, telling what to bin on
+ * @param edges The bin edges
+ * @param bins Where to place the indexes of every bin
+ */
+void make_bins (const data::Database& db, const param_t& par,
+    const std::vector<double>& edges, std::vector<std::vector<size_t> >& bins)
+{
+  std::vector<double> values;
+  if (par.column >= 0) db.column(par.column, values);
+  else db.attribute(par.attribute, values);
+  data::Database::bin(values, edges, bins);
+}
+
+int main (int argc, char** argv)
+{
+  sys::Reporter reporter("local");
+
+  param_t par = { "", "", "", "", "", -1, 5, 50, 0.1, 0, 1, false, false,
+    true, 50, 0.001, 10, 10000, 0 };
+  sys::OptParser opt_parser(argv[0]);
+  opt_parser.add_option
+    ("attribute", 'a', par.attribute,
+     "the entry attribute to bin on, e.g. \"eta\"");
+  opt_parser.add_option
+    ("hard-stop", 'b', par.hardstop,
+     "number of epochs after which to hard stop each training session");
+  opt_parser.add_option
+    ("epoch", 'c', par.epoch,
+     "how many patterns per training step");
+  opt_parser.add_option
+    ("traindb", 'd', par.traindb,
+     "location of the database to use for training");
+  opt_parser.add_option
+    ("decay", 'e', par.decay,
+     "the learning rate decay (back propagation only)");
+  opt_parser.add_option
+    ("column", 'f', par.column,
+     "the feature (starting from 0) to bin on");
+  opt_parser.add_option
+    ("stop-iteration", 'i', par.stopiter,
+     "how many times to wait for non-variation to be considered a stop sign");
+  opt_parser.add_option
+    ("threads", 'j', par.threads,
+     "how many bins to train concurrently (0: one per core)");
+  opt_parser.add_option
+    ("backprop", 'k', par.backprop,
+     "use back propagation instead of resilient back propagation");
+  opt_parser.add_option
+    ("learn-rate", 'l', par.lrate,
+     "the learning rate (backprop) or weight update (rprop)");
+  opt_parser.add_option
+    ("momentum", 'm', par.momentum,
+     "the momentum (back propagation only)");
+  opt_parser.add_option
+    ("sample-interval", 'n', par.sample,
+     "when to sample the training process for the MSE or SP");
+  opt_parser.add_option
+    ("bundle", 'o', par.bundle,
+     "the prefix of the network bundle, <prefix>.N.xml and <prefix>.bins");
+  opt_parser.add_option
+    ("hidden", 'r', par.hidden,
+     "how many hidden neurons");
+  opt_parser.add_option
+    ("mse-stop", 't', par.msestop,
+     "if I should use MSE stop criteria instead of SP (default)");
+  opt_parser.add_option
+    ("testdb", 'u', par.testdb,
+     "location of the database to use for testing");
+  opt_parser.add_option
+    ("stop-threshold", 'w', par.stopthres,
+     "the stop threshold to consider for flagging a potential stop");
+  opt_parser.add_option
+    ("edges", 'x', par.edges,
+     "comma separated bin edges, e.g. \"0,10,20,40\"");
+  opt_parser.add_option
+    ("compress-output", 'z', par.compress,
+     "should compress the output, e.g. 2 classes -> 1 output for the network");
+  opt_parser.parse(argc, argv);
+
+  std::vector<double> edges;
+  try {
+    if (!checkopt(par, reporter))
+      RINGER_FATAL(reporter, "Terminating execution.");
+    if (!split_list(par.edges, edges))
+      RINGER_FATAL(reporter, "Bin edges should be comma separated"
+		   " numbers, e.g. \"0,10,20,40\".");
+  }
+  catch (sys::Exception& ex) {
+    RINGER_EXCEPT(reporter, ex.what());
+    RINGER_FATAL(reporter, "I can't handle that exception. Aborting.");
+  }
+
+  //loads the DBs, once for all bins
+  std::vector<std::string> attributes;
+  if (par.attribute.size()) attributes.push_back(par.attribute);
+  data::Database traindb(par.traindb, reporter, attributes);
+  data::Database testdb(par.testdb, reporter, attributes);
+  std::map<std::string, data::Pattern*> targets;
+  traindb.make_targets(par.compress, targets);
+  traindb.set_target(targets);
+  testdb.set_target(targets);
+
+  if (traindb.size() < 2) {
+    RINGER_FATAL(reporter, "The database you loaded contains only 1 class of"
+        " events. Please, reconsider your input file.");
+  }
+  if (traindb.size() > 2 && !par.msestop) {
+    RINGER_FATAL(reporter, "I cannot use the SP product with in a multi"
+        "-class scenario. Please, either re-program me or reconsider"
+        " your options.");
+  }
+
+  data::PatternSet train(1, 1);
+  traindb.merge(train);
+  data::PatternSet target(1, 1);
+  traindb.merge_target(target);
+  data::PatternSet test(1, 1);
+  testdb.merge(test);
+  data::PatternSet test_target(1, 1);
+  testdb.merge_target(test_target);
+
+  try {
+    std::vector<std::vector<size_t> > train_bins, test_bins;
+    make_bins(traindb, par, edges, train_bins);
+    make_bins(testdb, par, edges, test_bins);
+    //every bin is balanced on its own, by oversampling indexes
+    std::vector<size_t> balanced;
+    for (size_t i=0; i<train_bins.size(); ++i) {
+      traindb.balance_index(train_bins[i], balanced);
+      train_bins[i].swap(balanced);
+    }
+    network::TrainerParameters tpar;
+    tpar.sample = par.sample;
+    tpar.stopiter = par.stopiter;
+    tpar.stopthres = par.stopthres;
+    tpar.hardstop = par.hardstop;
+    tpar.msestop = par.msestop;
+    network::SweepPoint point;
+    point.hidden = par.hidden;
+    point.epoch = par.epoch;
+    point.strategy =
+      par.backprop? config::SYNAPSE_BACKPROP : config::SYNAPSE_RPROP;
+    point.lrate = par.lrate;
+    point.momentum = par.momentum;
+    point.decay = par.decay;
+    network::BinTrainer bt(train, target, test, test_target, train_bins,
+        test_bins, point, tpar, reporter);
+    bt.run(par.threads);
+    bt.save(par.bundle, edges);
+
+    std::string tfile = par.bundle + ".txt";
+    std::ofstream table(tfile.c_str());
+    bt.table(table);
+    bt.table(std::cout);
+    RINGER_REPORT(reporter, "Network bundle saved with index \""
+        << par.bundle << ".bins\" and summary table \"" << tfile << "\".");
+  }
+  catch (sys::Exception& ex) {
+    RINGER_EXCEPT(reporter, ex.what());
+    RINGER_FATAL(reporter, "I can't handle that exception. Aborting.");
+  }
+
+  for (std::map<std::string, data::Pattern*>::iterator
+      it = targets.begin(); it != targets.end(); ++it) delete it->second;
+  RINGER_REPORT(reporter, "Successful exit. Bye");
+  return 0;
+}
@@ -0,0 +1,241 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file mlp-kfold.cxx
+ *
+ * Cross-validates an MLP configuration: the database is split in K folds,
+ * stratified by class, and the K networks are trained concurrently. The
+ * mean and spread of the best SP product and MSE over all folds are
+ * reported.
+ */
+
+#include "data/PatternSet.h"
+#include "data/Database.h"
+#include "data/NormalizationOperator.h"
+#include "network/CrossValidation.h"
+#include "sys/Reporter.h"
+#include "sys/Exception.h"
+#include "sys/debug.h"
+#include "sys/util.h"
+#include "sys/OptParser.h"
+#include "config/type.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <iostream>
+
+typedef struct param_t {
+  std::string db; ///< database to cross-validate on
+  std::string table; ///< where to write the summary table
+  std::string bestnet; ///< prefix of the best network of each fold
+  long int folds; ///< how many folds
+  long int hidden; ///< the hidden layer size
+  long int epoch; ///< the epoch size
+  data::Feature lrate; ///< the learning rate or weight update
+  data::Feature momentum; ///< the momentum (backprop only)
+  data::Feature decay; ///< the learning rate decay (backprop only)
+  bool backprop; ///< use back propagation instead of RProp
+  bool shuffle; ///< shuffle the database before partitioning it
+  long int seed; ///< the seed for this run
+  bool msestop; ///< use MSE product stop criteria instead of SP stabilisation
+  bool compress; ///< if I should use compressed or extended output
+  long int stopiter; ///< number of iterations w/o variance to stop
+  data::Feature stopthres; ///< the threshold to consider for stopping
+  long int sample; ///< the sample interval for MSE or SP
+  long int hardstop; ///< where to hard stop the training
+  long int threads; ///< how many folds to train concurrently
+} param_t;
+
+/**
+ * Checks and validates program options.
+ *
+ * @param p The parameters, already parsed
+ * @param reporter The reporter to use when reporting problems to the user
+ */
+bool checkopt (param_t& par, sys::Reporter& reporter)
+{
+  if (!par.db.size()) {
+    RINGER_DEBUG1("I cannot work without a database. Exception thrown.");
+    throw RINGER_EXCEPTION("No database specified.");
+  }
+  if (!sys::exists(par.db)) {
+    RINGER_DEBUG1("Database file " << par.db << " doesn't exist.");
+    throw RINGER_EXCEPTION("Database file doesn't exist.");
+  }
+  if (par.folds < 2) {
+    RINGER_DEBUG1("Trying to cross-validate with " << par.folds
+		  << " folds.");
+    throw RINGER_EXCEPTION("The number of folds should be >= 2.");
+  }
+  if (par.hidden <= 0 || par.epoch <= 0) {
+    RINGER_DEBUG1("The hidden layer and epoch sizes have to be greater"
+		  << " than zero.");
+    throw RINGER_EXCEPTION("Invalid hidden layer or epoch size.");
+  }
+  if (par.sample <= 0 || par.stopiter <= 0 || par.hardstop <= 0) {
+    RINGER_DEBUG1("The sample interval, stop iteration and hard stop have"
+		  << " to be greater than zero.");
+    throw RINGER_EXCEPTION("Invalid stop criteria.");
+  }
+  if (par.stopthres <= 0) {
+    RINGER_DEBUG1("Trying to set the stop threshold to " << par.stopthres);
+    throw RINGER_EXCEPTION("Stop threshold should be > 0.");
+  }
+  if (par.threads < 0) {
+    RINGER_DEBUG1("The number of threads cannot be negative.");
+    throw RINGER_EXCEPTION("Negative thread count.");
+  }
+  if (!par.table.size()) {
+    par.table = sys::stripname(par.db) + ".kfold.txt";
+    RINGER_DEBUG1("Setting summary table file name to " << par.table);
+  }
+  RINGER_DEBUG1("Command line options have been validated.");
+  return true;
+}
+
+int main (int argc, char** argv)
+{
+  sys::Reporter reporter("local");
+
+  param_t par = { "", "", "", 10, 5, 50, 0.1, 0, 1, false, false, 0, false,
+    true, 50, 0.001, 10, 10000, 0 };
+  sys::OptParser opt_parser(argv[0]);
+  opt_parser.add_option
+    ("hard-stop", 'b', par.hardstop,
+     "number of epochs after which to hard stop each training session");
+  opt_parser.add_option
+    ("epoch", 'c', par.epoch,
+     "how many patterns per training step");
+  opt_parser.add_option
+    ("db", 'd', par.db,
+     "location of the database to cross-validate on");
+  opt_parser.add_option
+    ("decay", 'e', par.decay,
+     "the learning rate decay (back propagation only)");
+  opt_parser.add_option
+    ("folds", 'f', par.folds,
+     "how many folds to partition the database in");
+  opt_parser.add_option
+    ("best-net", 'g', par.bestnet,
+     "if set, the best network of fold N is saved as <prefix>.N.xml");
+  opt_parser.add_option
+    ("stop-iteration", 'i', par.stopiter,
+     "how many times to wait for non-variation to be considered a stop sign");
+  opt_parser.add_option
+    ("threads", 'j', par.threads,
+     "how many folds to train concurrently (0: one per core)");
+  opt_parser.add_option
+    ("backprop", 'k', par.backprop,
+     "use back propagation instead of resilient back propagation");
+  opt_parser.add_option
+    ("learn-rate", 'l', par.lrate,
+     "the learning rate (backprop) or weight update (rprop)");
+  opt_parser.add_option
+    ("momentum", 'm', par.momentum,
+     "the momentum (back propagation only)");
+  opt_parser.add_option
+    ("sample-interval", 'n', par.sample,
+     "when to sample the training process for the MSE or SP");
+  opt_parser.add_option
+    ("table", 'o', par.table,
+     "where to write the summary table");
+  opt_parser.add_option
+    ("hidden", 'r', par.hidden,
+     "how many hidden neurons");
+  opt_parser.add_option
+    ("shuffle", 's', par.shuffle,
+     "shuffle the database before partitioning it");
+  opt_parser.add_option
+    ("seed", 'S', par.seed,
+     "the seed for this run, recorded in the saved networks (0: time based)");
+  opt_parser.add_option
+    ("mse-stop", 't', par.msestop,
+     "if I should use MSE stop criteria instead of SP (default)");
+  opt_parser.add_option
+    ("stop-threshold", 'w', par.stopthres,
+     "the stop threshold to consider for flagging a potential stop");
+  opt_parser.add_option
+    ("compress-output", 'z', par.compress,
+     "should compress the output, e.g. 2 classes -> 1 output for the network");
+  opt_parser.parse(argc, argv);
+
+  try {
+    if (!checkopt(par, reporter))
+      RINGER_FATAL(reporter, "Terminating execution.");
+  }
+  catch (sys::Exception& ex) {
+    RINGER_EXCEPT(reporter, ex.what());
+    RINGER_FATAL(reporter, "I can't handle that exception. Aborting.");
+  }
+  //weights and minibatches are all drawn from streams of this seed
+  data::RandomInteger::run_seed(par.seed);
+  RINGER_REPORT(reporter, "The seed for this run is "
+		<< data::RandomInteger::run_seed() << ".");
+
+  //loads the DB once; folds are only index lists into it. The database is
+  //not normalised, as repeated patterns could leak between folds.
+  data::Database db(par.db, reporter);
+  if (par.shuffle) db.shuffle(data::RandomInteger());
+  std::map<std::string, data::Pattern*> targets;
+  db.make_targets(par.compress, targets);
+  db.set_target(targets);
+  data::NormalizationOperator norm_op(db);
+
+  if (db.size() < 2) {
+    RINGER_FATAL(reporter, "The database you loaded contains only 1 class of"
+        " events. Please, reconsider your input file.");
+  }
+  if (db.size() > 2 && !par.msestop) {
+    RINGER_FATAL(reporter, "I cannot use the SP product with in a multi"
+        "-class scenario. Please, either re-program me or reconsider"
+        " your options.");
+  }
+
+  data::PatternSet data(1, 1);
+  db.merge(data);
+  data::PatternSet target(1, 1);
+  db.merge_target(target);
+
+  try {
+    std::vector<std::vector<size_t> > train, test;
+    db.kfold(par.folds, train, test);
+    network::TrainerParameters tpar;
+    tpar.sample = par.sample;
+    tpar.stopiter = par.stopiter;
+    tpar.stopthres = par.stopthres;
+    tpar.hardstop = par.hardstop;
+    tpar.msestop = par.msestop;
+    network::SweepPoint point;
+    point.hidden = par.hidden;
+    point.epoch = par.epoch;
+    point.strategy =
+      par.backprop? config::SYNAPSE_BACKPROP : config::SYNAPSE_RPROP;
+    point.lrate = par.lrate;
+    point.momentum = par.momentum;
+    point.decay = par.decay;
+    network::CrossValidation cv(data, target, train, test, norm_op.mean(),
+        norm_op.stddev(), point, tpar, reporter);
+    if (par.bestnet.size()) cv.save(par.bestnet);
+    cv.run(par.threads);
+
+    std::ofstream table(par.table.c_str());
+    cv.table(table);
+    cv.table(std::cout);
+    double sp_mean, sp_stddev, mse_mean, mse_stddev;
+    cv.summary(sp_mean, sp_stddev, mse_mean, mse_stddev);
+    RINGER_REPORT(reporter, "Summary table saved to \"" << par.table
+        << "\". SP = " << sp_mean << " +- " << sp_stddev << ", MSE = "
+        << mse_mean << " +- " << mse_stddev << ".");
+  }
+  catch (sys::Exception& ex) {
+    RINGER_EXCEPT(reporter, ex.what());
+    RINGER_FATAL(reporter, "I can't handle that exception. Aborting.");
+  }
+
+  for (std::map<std::string, data::Pattern*>::iterator
+      it = targets.begin(); it != targets.end(); ++it) delete it->second;
+  RINGER_REPORT(reporter, "Successful exit. Bye");
+  return 0;
+}
@@ -0,0 +1,270 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file mlp-sweep.cxx
+ *
+ * Trains MLP's for many hyper-parameter configurations, concurrently, on a
+ * pair of databases that are loaded only once, and summarises the results
+ * in a table.
+ */
+
+#include "data/PatternSet.h"
+#include "data/Database.h"
+#include "data/NormalizationOperator.h"
+#include "network/Sweep.h"
+#include "sys/Reporter.h"
+#include "sys/Exception.h"
+#include "sys/debug.h"
+#include "sys/util.h"
+#include "sys/OptParser.h"
+#include "config/type.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+
+typedef struct param_t {
+  std::string traindb; ///< database to use for training
+  std::string testdb; ///< database to use for testing
+  std::string table; ///< where to write the summary table
+  std::string bestnet; ///< prefix of the best network of each configuration
+  std::string hidden; ///< the hidden layer sizes to try
+  std::string epoch; ///< the epoch sizes to try
+  std::string lrate; ///< the learning rates or weight updates to try
+  std::string momentum; ///< the momenta to try
+  data::Feature decay; ///< the learning rate decay (backprop only)
+  bool backprop; ///< use back propagation instead of RProp
+  bool msestop; ///< use MSE product stop criteria instead of SP stabilisation
+  bool compress; ///< if I should use compressed or extended output
+  long int stopiter; ///< number of iterations w/o variance to stop
+  data::Feature stopthres; ///< the threshold to consider for stopping
+  long int sample; ///< the sample interval for MSE or SP
+  long int hardstop; ///< where to hard stop the training
+  long int random; ///< how many random configurations (0 for a grid)
+  long int seed; ///< the seed for random search
+  long int threads; ///< how many configurations to train concurrently
+} param_t;
+
+/**
+ * Splits a comma separated list of numbers
+ *
+ * @param s The list to split
+ * @param v Where to put the numbers
+ */
+template <typename T> bool split_list (const std::string& s,
+				       std::vector<T>& v)
+{
+  v.clear();
+  std::istringstream is(s);
+  std::string item;
+  while (std::getline(is, item, ',')) {
+    std::istringstream conv(item);
+    T value;
+    if (!(conv >> value)) return false;
+    v.push_back(value);
+  }
+  return !v.empty();
+}
+
+/**
+ * Checks and validates program options.
+ *
+ * @param p The parameters, already parsed
+ * @param reporter The reporter to use when reporting problems to the user
+ */
+bool checkopt (param_t& par, sys::Reporter& reporter)
+{
+  if (!par.traindb.size()) {
+    RINGER_DEBUG1("I cannot work without a training database. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("No training database specified.");
+  }
+  if (!par.testdb.size()) {
+    RINGER_DEBUG1("I cannot work without a testing database. Exception"
+		  << " thrown.");
+    throw RINGER_EXCEPTION("No testing database specified.");
+  }
+  if (!sys::exists(par.traindb)) {
+    RINGER_DEBUG1("Train Database file " << par.traindb << " doesn't exist.");
+    throw RINGER_EXCEPTION("Train database file doesn't exist.");
+  }
+  if (!sys::exists(par.testdb)) {
+    RINGER_DEBUG1("Test Database file " << par.testdb << " doesn't exist.");
+    throw RINGER_EXCEPTION("Test database file doesn't exist.");
+  }
+  if (par.sample <= 0 || par.stopiter <= 0 || par.hardstop <= 0) {
+    RINGER_DEBUG1("The sample interval, stop iteration and hard stop have"
+		  << " to be greater than zero.");
+    throw RINGER_EXCEPTION("Invalid stop criteria.");
+  }
+  if (par.stopthres <= 0) {
+    RINGER_DEBUG1("Trying to set the stop threshold to " << par.stopthres);
+    throw RINGER_EXCEPTION("Stop threshold should be > 0.");
+  }
+  if (par.random < 0 || par.threads < 0) {
+    RINGER_DEBUG1("The number of random configurations and threads cannot"
+		  << " be negative.");
+    throw RINGER_EXCEPTION("Negative random or thread count.");
+  }
+  if (!par.table.size()) {
+    par.table = sys::stripname(par.traindb) + ".sweep.txt";
+    RINGER_DEBUG1("Setting summary table file name to " << par.table);
+  }
+  RINGER_DEBUG1("Command line options have been validated.");
+  return true;
+}
+
+int main (int argc, char** argv)
+{
+  sys::Reporter reporter("local");
+
+  param_t par = { "", "", "", "", "5", "50", "0.1", "0", 1, false, false,
+    true, 50, 0.001, 10, 10000, 0, 0, 0 };
+  sys::OptParser opt_parser(argv[0]);
+  opt_parser.add_option
+    ("hard-stop", 'b', par.hardstop,
+     "number of epochs after which to hard stop each training session");
+  opt_parser.add_option
+    ("epoch", 'c', par.epoch,
+     "comma separated epoch sizes to try");
+  opt_parser.add_option
+    ("traindb", 'd', par.traindb,
+     "location of the database to use for training");
+  opt_parser.add_option
+    ("decay", 'e', par.decay,
+     "the learning rate decay (back propagation only)");
+  opt_parser.add_option
+    ("best-net", 'g', par.bestnet,
+     "if set, the best network of configuration N is saved as <prefix>.N.xml");
+  opt_parser.add_option
+    ("stop-iteration", 'i', par.stopiter,
+     "how many times to wait for non-variation to be considered a stop sign");
+  opt_parser.add_option
+    ("threads", 'j', par.threads,
+     "how many configurations to train concurrently (0: one per core)");
+  opt_parser.add_option
+    ("backprop", 'k', par.backprop,
+     "use back propagation instead of resilient back propagation");
+  opt_parser.add_option
+    ("learn-rate", 'l', par.lrate,
+     "comma separated learning rates (backprop) or weight updates to try");
+  opt_parser.add_option
+    ("momentum", 'm', par.momentum,
+     "comma separated momenta to try (back propagation only)");
+  opt_parser.add_option
+    ("sample-interval", 'n', par.sample,
+     "when to sample the training process for the MSE or SP");
+  opt_parser.add_option
+    ("table", 'o', par.table,
+     "where to write the summary table");
+  opt_parser.add_option
+    ("random", 'q', par.random,
+     "if not zero, try this many random configurations instead of a grid");
+  opt_parser.add_option
+    ("hidden", 'r', par.hidden,
+     "comma separated hidden layer sizes to try");
+  opt_parser.add_option
+    ("seed", 'S', par.seed,
+     "the seed for random search (0: time based)");
+  opt_parser.add_option
+    ("mse-stop", 't', par.msestop,
+     "if I should use MSE stop criteria instead of SP (default)");
+  opt_parser.add_option
+    ("testdb", 'u', par.testdb,
+     "location of the database to use for testing");
+  opt_parser.add_option
+    ("stop-threshold", 'w', par.stopthres,
+     "the stop threshold to consider for flagging a potential stop");
+  opt_parser.add_option
+    ("compress-output", 'z', par.compress,
+     "should compress the output, e.g. 2 classes -> 1 output for the network");
+  opt_parser.parse(argc, argv);
+
+  std::vector<unsigned int> hidden, epoch;
+  std::vector<double> lrate, momentum;
+  try {
+    if (!checkopt(par, reporter))
+      RINGER_FATAL(reporter, "Terminating execution.");
+    if (!split_list(par.hidden, hidden) || !split_list(par.epoch, epoch) ||
+	!split_list(par.lrate, lrate) || !split_list(par.momentum, momentum))
+      RINGER_FATAL(reporter, "Value lists should be comma separated"
+		   " numbers, e.g. \"3,5,7\".");
+  }
+  catch (sys::Exception& ex) {
+    RINGER_EXCEPT(reporter, ex.what());
+    RINGER_FATAL(reporter, "I can't handle that exception. Aborting.");
+  }
+
+  //loads the DBs, once for all configurations
+  data::Database traindb(par.traindb, reporter);
+  data::Database testdb(par.testdb, reporter);
+  std::map<std::string, data::Pattern*> targets;
+  traindb.make_targets(par.compress, targets);
+  traindb.set_target(targets);
+  testdb.set_target(targets);
+  //classes are balanced by oversampling indexes, so nothing is copied
+  std::vector<size_t> balanced;
+  traindb.balance_index(balanced);
+  data::NormalizationOperator norm_op(traindb, true);
+
+  if (traindb.size() < 2) {
+    RINGER_FATAL(reporter, "The database you loaded contains only 1 class of"
+        " events. Please, reconsider your input file.");
+  }
+  if (traindb.size() > 2 && !par.msestop) {
+    RINGER_FATAL(reporter, "I cannot use the SP product with in a multi"
+        "-class scenario. Please, either re-program me or reconsider"
+        " your options.");
+  }
+
+  data::PatternSet train(1, 1);
+  traindb.merge(train);
+  data::PatternSet target(1, 1);
+  traindb.merge_target(target);
+  data::PatternSet test(1, 1);
+  testdb.merge(test);
+  data::PatternSet test_target(1, 1);
+  testdb.merge_target(test_target);
+  RINGER_REPORT(reporter, "Train set size is " << train.size()
+      << " (" << balanced.size() << " balanced), test set size is "
+      << test.size() << ".");
+
+  try {
+    network::TrainerParameters tpar;
+    tpar.sample = par.sample;
+    tpar.stopiter = par.stopiter;
+    tpar.stopthres = par.stopthres;
+    tpar.hardstop = par.hardstop;
+    tpar.msestop = par.msestop;
+    network::Sweep sweep(train, target, test, test_target, norm_op.mean(),
+        norm_op.stddev(), tpar, reporter);
+    sweep.subset(balanced);
+    config::SynapseStrategyType strategy =
+      par.backprop? config::SYNAPSE_BACKPROP : config::SYNAPSE_RPROP;
+    if (par.random)
+      sweep.random(par.random, hidden, epoch, strategy, lrate, momentum,
+          par.decay, par.seed);
+    else
+      sweep.grid(hidden, epoch, strategy, lrate, momentum, par.decay);
+    if (par.bestnet.size()) sweep.save(par.bestnet);
+    sweep.run(par.threads);
+
+    std::ofstream table(par.table.c_str());
+    sweep.table(table);
+    sweep.table(std::cout);
+    RINGER_REPORT(reporter, "Summary table saved to \"" << par.table
+        << "\". Best configuration is " << sweep.best() << ".");
+  }
+  catch (sys::Exception& ex) {
+    RINGER_EXCEPT(reporter, ex.what());
+    RINGER_FATAL(reporter, "I can't handle that exception. Aborting.");
+  }
+
+  for (std::map<std::string, data::Pattern*>::iterator
+      it = targets.begin(); it != targets.end(); ++it) delete it->second;
+  RINGER_REPORT(reporter, "Successful exit. Bye");
+  return 0;
+}
@@ -8,12 +8,13 @@
  * the patterns in that database.
  */
 
-#include "data/RoIPatternSet.h"
+#include "data/PatternSet.h"
 #include "data/Database.h"
 #include "data/NormalizationOperator.h"
 #include "data/util.h"
 #include "data/SumExtractor.h"
 #include "network/MLP.h"
+#include "network/MultiStart.h"
 #include "sys/Reporter.h"
 #include "sys/Exception.h"
 #include "sys/debug.h"
@@ -39,6 +40,7 @@ typedef struct param_t {
   std::string spevo; ///< where to save the neural network SP evolution
   std::string output; ///< where to save the last output after training
   std::string energy; ///< where to save the energies of the clusters
+  std::string state; ///< prefix of the training state files
   long int nhidden; ///< number of hidden neurons
   long int epoch; ///< each epoch size
   bool msestop; ///< use MSE product stop criteria instead of SP stabilisation
@@ -47,6 +49,17 @@ typedef struct param_t {
   data::Feature stopthres; ///< the threshold to consider for stopping
   long int sample; ///< the sample interval for MSE or SP
   long int hardstop; ///< where to hard stop the training
+  long int runs; ///< how many networks to train concurrently
+  bool background; ///< evaluate on a background thread, overlapping training
+  bool prefetch; ///< prepare minibatches on a background thread
+  std::string stream; ///< database file to stream minibatches from
+  data::Feature subsample; ///< test fraction to screen evaluations with
+  data::Feature tolerance; ///< distance to the best to fully evaluate
+  bool checkpoint; ///< save each run's best network as soon as it is found
+  long int snapshot; ///< evaluations between training state saves
+  bool resume; ///< resume training from saved training states
+  long int seed; ///< the seed for this run
+  bool weighted; ///< balance classes by weighing errors, not oversampling
 } param_t;
 
 /**
@@ -105,6 +118,15 @@ bool checkopt (param_t& par, sys::Reporter& reporter)
     par.spevo = sys::stripname(par.traindb) + ".sp.txt";
     RINGER_DEBUG1("Setting SP evolution file name to " << par.spevo);
   }
+  if (!par.state.size()) {
+    par.state = sys::stripname(par.traindb);
+    RINGER_DEBUG1("Setting training state prefix to " << par.state);
+  }
+  if (par.snapshot < 0) {
+    RINGER_DEBUG1("I cannot save training states every " << par.snapshot
+        << " evaluations.");
+    return false;
+  }
   if (!par.output.size()) {
     par.output = sys::stripname(par.traindb) + ".out.xml";
     RINGER_DEBUG1("Setting output file name to " << par.output);
@@ -123,6 +145,24 @@ bool checkopt (param_t& par, sys::Reporter& reporter)
         << " Please provide me a hardstop.");
     throw RINGER_EXCEPTION("No hardstop parameter specified.");
   }
+  if (par.subsample < 0 || par.subsample >= 1) {
+    RINGER_DEBUG1("I cannot screen evaluations on a fraction of "
+        << par.subsample << " of the test set.");
+    throw RINGER_EXCEPTION("The screening fraction should be in [0,1)");
+  }
+  if (par.tolerance < 0) {
+    RINGER_DEBUG1("I cannot use a negative screening tolerance.");
+    throw RINGER_EXCEPTION("Screening tolerance is less than zero");
+  }
+  if (par.runs <= 0) {
+    RINGER_DEBUG1("I cannot train " << par.runs << " networks.");
+    throw RINGER_EXCEPTION("The number of runs should be > 0");
+  }
+  if (par.stream.size()) par.prefetch = true;
+  if (par.weighted && par.prefetch) {
+    RINGER_DEBUG1("I cannot weigh the errors of prefetched minibatches.");
+    throw RINGER_EXCEPTION("Weighted training cannot be prefetched");
+  }
   RINGER_DEBUG1("Command line options have been validated.");
   return true;
 }
@@ -131,9 +171,14 @@ int main (int argc, char** argv)
 {
   sys::Reporter reporter("local");
 
-  param_t par = { "", "", "", "", "", "", "", "", "",
-    4, 50, false, true, 50, 0.001, 10, 10000 };
+  param_t par = { "", "", "", "", "", "", "", "", "", "",
+    4, 50, false, true, 50, 0.001, 10, 10000, 1, false, false, "", 0, 0.05,
+    false, 0,
+    false, 0, false };
   sys::OptParser opt_parser(argv[0]);
+  opt_parser.add_option
+    ("async-eval", 'a', par.background,
+     "evaluate the test set on a background thread, while training goes on");
   opt_parser.add_option
     ("hard-stop", 'b', par.hardstop,
      "number of epochs after which to hard stop the training session");
@@ -146,15 +191,31 @@ int main (int argc, char** argv)
   opt_parser.add_option
     ("end-net", 'e', par.endnet, 
      "where to write the last network");
+  opt_parser.add_option
+    ("prefetch", 'f', par.prefetch,
+     "prepare the next minibatches on a background thread, while training");
+  opt_parser.add_option
+    ("prefetch-file", 'F', par.stream,
+     "stream the minibatches from this database file instead of the train"
+     " set, implies --prefetch");
   opt_parser.add_option
     ("best-net", 'g', par.bestnet, 
      "where to write the best network");
+  opt_parser.add_option
+    ("screen-tolerance", 'h', par.tolerance,
+     "how close (relative) to the best a screened network must come");
   opt_parser.add_option
     ("energy", 'j', par.energy,
      "the name of the output file for transverse energies of input clusters");
   opt_parser.add_option
     ("stop-iteration", 'i', par.stopiter,
      "how many times to wait for non-variation to be considered a stop sign");
+  opt_parser.add_option
+    ("runs", 'k', par.runs,
+     "how many independently initialised networks to train concurrently");
+  opt_parser.add_option
+    ("snapshot", 'l', par.snapshot,
+     "save the complete training state every this many samples (0: never)");
   opt_parser.add_option
     ("mse-evolution", 'm', par.mseevo,
      "where to write the MSE evolution data, during training");
@@ -164,24 +225,43 @@ int main (int argc, char** argv)
   opt_parser.add_option
     ("output", 'o', par.output,
      "where to write the output of the last network");
+  opt_parser.add_option
+    ("seed", 'S', par.seed,
+     "the seed for this run, recorded in the saved networks (0: time based)");
   opt_parser.add_option
     ("sp-evolution", 'p', par.spevo,
      "where to write the SP evolution data, during training");
+  opt_parser.add_option
+    ("resume", 'q', par.resume,
+     "resume training from the training states saved with --snapshot");
   opt_parser.add_option
     ("hidden", 'r', par.nhidden,
      "how many hidden neurons should I use for the network");
   opt_parser.add_option
     ("start-net", 's', par.startnet,
-     "where to write the start status of the network");
+     "where to write the start status of the network (of the best run, if"
+     " there are many; run N also goes to <name>.N.xml)");
   opt_parser.add_option
     ("mse-stop", 't', par.msestop,
      "if I should use MSE stop criteria instead of SP (default)");
   opt_parser.add_option
     ("testdb", 'u', par.testdb,
      "location of the database to use for testing");
+  opt_parser.add_option
+    ("screen", 'v', par.subsample,
+     "screen evaluations on this fraction of the test set first (0 = off)");
   opt_parser.add_option
     ("stop-threshold", 'w', par.stopthres,
      "the stop threshold to consider for flagging a potential stop");
+  opt_parser.add_option
+    ("state", 'x', par.state,
+     "the prefix of the training state files, one per run (<prefix>.N.state)");
+  opt_parser.add_option
+    ("checkpoint", 'y', par.checkpoint,
+     "save the best network of every run as soon as it is found");
+  opt_parser.add_option
+    ("weighted", 'W', par.weighted,
+     "balance classes by weighing their errors instead of oversampling them");
   opt_parser.add_option
     ("compress-output", 'z', par.compress,
      "should compress the output, e.g. 2 classes -> 1 output for the network");
@@ -190,27 +270,40 @@ int main (int argc, char** argv)
   try {
     if (!checkopt(par, reporter))
       RINGER_FATAL(reporter, "Terminating execution.");
+    //a resumed run must draw from the seed its training states were saved
+    //with, which is read back unless given
+    if (par.resume && !par.seed)
+      par.seed = network::MultiStart::run_seed(par.state);
   }
   catch (sys::Exception& ex) {
     RINGER_EXCEPT(reporter, ex.what());
     RINGER_FATAL(reporter, "I can't handle that exception. Aborting.");
   }
+  //weights and minibatches are all drawn from streams of this seed
+  data::RandomInteger::run_seed(par.seed);
+  RINGER_REPORT(reporter, "The seed for this run is "
+		<< data::RandomInteger::run_seed() << ".");
 
   //loads the DB
-  data::Database<data::RoIPatternSet> traindb(par.traindb, reporter);
-  data::Database<data::RoIPatternSet> testdb(par.testdb, reporter);
+  data::Database traindb(par.traindb, reporter);
+  data::Database testdb(par.testdb, reporter);
   std::vector<std::string> cnames;
   traindb.class_names(cnames);
+  std::map<std::string, data::Pattern*> targets;
+  traindb.make_targets(par.compress, targets);
   RINGER_DEBUG1("Test set size is " << testdb.size());
 
-  //tune input DB's for size/randomness
-  data::Database<data::RoIPatternSet> 
-    traindb2(traindb); //save original train database
-  traindb.normalise();
-  //calculate the normalization factor based on the train set, but only after
-  //size normalization
-  data::NormalizationOperator norm_op(traindb);
-  RINGER_DEBUG1("Train set size is " << traindb2.size());
+  //balance classes through indexes or weights, so nothing is copied
+  traindb.set_target(targets);
+  testdb.set_target(targets);
+  std::vector<size_t> balanced;
+  std::vector<double> weights;
+  if (par.weighted) traindb.balance_weights(weights);
+  else traindb.balance_index(balanced);
+  //calculate the normalization factor based on the train set, with balanced
+  //classes
+  data::NormalizationOperator norm_op(traindb, true);
+  RINGER_DEBUG1("Train set size is " << traindb.size());
 
   //checks db size
   if (traindb.size() < 2) {
@@ -225,8 +318,9 @@ int main (int argc, char** argv)
         " your options.");
   }
 
-  //Builds the MLP network, 1 input for each feature, a compressed output
-  //schema for each class (2 classes -> 1 output)
+  //Builds the MLP networks, 1 input for each feature, a compressed output
+  //schema for each class (2 classes -> 1 output). Networks are built in
+  //sequence, so each gets different initial weights.
   std::vector<size_t> hlayer(1, par.nhidden);
   config::NeuronStrategyType nstrat = config::NEURON_BACKPROP;
   config::NeuronBackProp::ActivationFunction actfun = 
@@ -235,131 +329,134 @@ int main (int argc, char** argv)
   config::SynapseStrategyType sstrat = config::SYNAPSE_RPROP;
   config::Parameter* ssparam = new config::SynapseRProp(0.1);
   std::vector<bool> biaslayer(2, true);
-  unsigned int nout = traindb.size();
-  if (par.compress) nout = lrint(std::ceil(log2(traindb.size())));
-  network::MLP net(traindb.pattern_size(), hlayer, nout,
-      biaslayer, nstrat, nsparam, nstrat, nsparam,
-      sstrat, ssparam, norm_op.mean(), norm_op.stddev(), 
-      reporter);
+  unsigned int nout = targets.begin()->second->size();
+  std::vector<network::Network*> nets;
+  for (long int i=0; i<par.runs; ++i)
+    nets.push_back(new network::MLP(traindb.pattern_size(), hlayer, nout,
+          biaslayer, nstrat, nsparam, nstrat, nsparam,
+          sstrat, ssparam, norm_op.mean(), norm_op.stddev(), 
+          reporter));
 
-  data::RoIPatternSet train(1, 1);
+  data::PatternSet train(1, 1);
   traindb.merge(train);
-  RINGER_REPORT(reporter, "Normalised train set size is " << train.size());
-  data::RoIPatternSet train2(1, 1);
-  traindb2.merge(train2);
-  RINGER_REPORT(reporter, "Original train set size is " << train2.size());
-  RINGER_DEBUG1("Train set size is " << train.size());
-  data::RoIPatternSet target(1, 1);
-  traindb.merge_target(par.compress, -1, +1, target);
-  RINGER_REPORT(reporter, "Normalized train target set size is " 
-      << target.size());
-  data::RoIPatternSet target2(1, 1);
-  traindb2.merge_target(par.compress, -1, +1, target2);
-  RINGER_REPORT(reporter, "Original train target set size is "
-      << target2.size());
+  RINGER_REPORT(reporter, "Train set size is " << train.size());
+  if (par.weighted) {
+    RINGER_REPORT(reporter, "Classes are balanced by weighing their errors.");
+  }
+  else {
+    RINGER_REPORT(reporter, "Balanced train set size is " << balanced.size());
+  }
+  data::PatternSet target(1, 1);
+  traindb.merge_target(target);
   RINGER_DEBUG1("Train target set size is " << target.size());
-  data::RoIPatternSet test(1, 1);
+  data::PatternSet test(1, 1);
   testdb.merge(test);
   RINGER_DEBUG1("Test set size is " << test.size());
-  data::RoIPatternSet test_target(1, 1);
-  testdb.merge_target(par.compress, -1, +1, test_target);
+  data::PatternSet test_target(1, 1);
+  testdb.merge_target(test_target);
   RINGER_DEBUG1("Test target set size is " << test_target.size());
 
   try {
-    sys::File mseevo(par.mseevo, std::ios_base::trunc|std::ios_base::out);
-    mseevo << "epoch test-mse train-mse" << "\n";
-    sys::File spevo(par.spevo, std::ios_base::trunc|std::ios_base::out);
-    spevo << "epoch test-sp train-sp" << "\n";
-    data::SimplePatternSet output(target2.simple());
     config::Header net_header("Andre DOS ANJOS", par.output, "1.0", time(0),
         "Start set");
-    net.save(par.startnet, &net_header);
-    unsigned int stopnow = par.stopiter;
-
-    //Trains until the MSE or SP product stabilizes
-    double val = 1;
-    double var = 1;
-
-    double prev = 0; //previous
-    size_t i = 0;
-    double best_val = val;
-    while (stopnow) {
-      net.train(train.simple(), target.simple(), par.epoch);
-      --par.hardstop;
-      if (!par.hardstop) {
-        RINGER_REPORT(reporter, "Hard-stop limit has been reached. Stopping"
-            << " the training session by force.");
-        stopnow = 0;
-        continue;
+    //every run has its own start network, kept until the best is known. A
+    //resumed job reads them back: the networks built here are not its start
+    std::vector<std::string> startfile(nets.size(), par.startnet);
+    std::string where = par.startnet;
+    if (par.runs > 1) {
+      where = sys::stripname(par.startnet) + ".N.xml";
+      for (size_t i=0; i<nets.size(); ++i) {
+        std::ostringstream name;
+        name << sys::stripname(par.startnet) << "." << i << ".xml";
+        startfile[i] = name.str();
       }
-
-      if (i%par.sample == 0) { //time to check performance
-        double eff1, eff2, thres;
-        double eff1_test, eff2_test, thres_test;
-        {
-          //test set analysis
-          output = test_target.simple();
-          net.run(test.simple(), output);
-          double sp_val;
-          if (traindb.size() == 2)
-            sp_val = data::sp(output, test_target, eff1_test, eff2_test, thres_test);
-          double mse_val = data::mse(output, test_target.simple());
-          mseevo << (unsigned int)i << " " << mse_val;
-          spevo << (unsigned int)i << " " << sp_val;
-          prev = val;
-          if (!par.msestop) val = sp_val;
-          else val = mse_val;
-          var = std::fabs(val-prev)/prev;
-          bool savenet = false;
-          if (!par.msestop) { //the greater, the better
-            if (val > best_val) {
-              best_val = val;
-              savenet = true;
-            }
-          }
-          else {
-            if (var < best_val) {
-              best_val = val;
-              savenet = true;
-            }
-          }
-          if (savenet) { //save the current network because it is the best
-            //save result
-            RINGER_REPORT(reporter, "Saving best network so far at \""
-                << par.bestnet << "\"...");
-            config::Header end_header("Andre DOS ANJOS", par.output, 
-                "1.0", time(0), "Trained network");
-            net.save(par.bestnet, &end_header);
-          }
-        }
-        {
-          //train set analysis
-          net.run(train2.simple(), output);
-          double sp_val;
-          if (traindb.size() == 2) 
-            sp_val = data::sp(output, target2, eff1, eff2, thres);
-          double mse_val = data::mse(output, target2.simple());
-          mseevo << " " << mse_val << "\n";
-          spevo << " " << sp_val << "\n";
-        }
-        if (var < par.stopthres) {
-          --stopnow;
-          RINGER_REPORT(reporter, "Detected possible stop in " << stopnow
-              << " more iterations.");
-        }
-        else stopnow = par.stopiter;
-        if (!par.msestop) {
-          RINGER_REPORT(reporter, "[epoch " << i << "/test] SP = " << val
-              << " (variation = " << var << ") (for threshold=" 
-              << thres_test << " -> " << cnames[0]
-              << " eff=" << eff1_test*100 << "% and " << cnames[1]
-              << " eff=" << eff2_test*100 << "%)");
-        }
-        else RINGER_REPORT(reporter, "[epoch " << i << "] MSE = " << val
-            << " (variation = " << var << ")");
+    }
+    std::vector<std::vector<data::Feature> > start(nets.size());
+    if (par.resume) {
+      RINGER_REPORT(reporter, "Reading the start networks back from \""
+          << where << "\".");
+      for (size_t i=0; i<nets.size(); ++i) {
+        network::Network original(startfile[i], reporter);
+        original.copy_weights(start[i]);
       }
+    }
+    else {
+      RINGER_REPORT(reporter, "Saving the start networks at \"" << where
+          << "\"...");
+      for (size_t i=0; i<nets.size(); ++i) {
+        nets[i]->copy_weights(start[i]);
+        nets[i]->save(startfile[i], &net_header);
+      }
+    }
+
+    //Trains all networks until the MSE or SP product stabilizes
+    network::TrainerParameters tpar;
+    tpar.epoch = par.epoch;
+    tpar.sample = par.sample;
+    tpar.stopiter = par.stopiter;
+    tpar.stopthres = par.stopthres;
+    tpar.hardstop = par.hardstop;
+    tpar.msestop = par.msestop;
+    tpar.background = par.background;
+    tpar.prefetch = par.prefetch;
+    tpar.subsample = par.subsample;
+    tpar.tolerance = par.tolerance;
+    network::MultiStart runs(nets, train, target, test, test_target, tpar,
+        reporter);
+    if (par.weighted) runs.weights(weights);
+    else runs.subset(balanced, std::vector<size_t>());
+    if (par.stream.size()) {
+      RINGER_REPORT(reporter, "Streaming the minibatches from \""
+          << par.stream << "\".");
+      runs.stream(par.stream, targets);
+    }
+    runs.monitor(train, target);
+    if (par.checkpoint) {
+      RINGER_REPORT(reporter, "Checkpointing the best network of every run"
+          << " with prefix \"" << sys::stripname(par.bestnet) << "\".");
+      runs.checkpoint(sys::stripname(par.bestnet), &net_header);
+    }
+    if (par.resume) runs.load(par.state);
+    if (par.snapshot) {
+      RINGER_REPORT(reporter, "Saving training states every " << par.snapshot
+          << " samples with prefix \"" << par.state << "\".");
+      runs.snapshot(par.state, par.snapshot);
+    }
+    runs.run();
+    size_t best_run = runs.best();
+    const network::Trainer& trainer = runs.trainer(best_run);
+    network::Network& net = *nets[best_run];
+    if (tpar.subsample) {
+      RINGER_REPORT(reporter, "The best run skipped " << trainer.skipped()
+          << " evaluations after screening them on a test subsample.");
+    }
+    if (trainer.steps() >= tpar.hardstop) {
+      RINGER_REPORT(reporter, "Hard-stop limit has been reached. The"
+          << " training session was stopped by force.");
+    }
 
-      ++i; //go to next epoch
+    //save the evolution of the best run
+    sys::File mseevo(par.mseevo, std::ios_base::trunc|std::ios_base::out);
+    mseevo << "epoch test-mse train-mse" << "\n";
+    sys::File spevo(par.spevo, std::ios_base::trunc|std::ios_base::out);
+    spevo << "epoch test-sp train-sp" << "\n";
+    for (size_t i=0; i<trainer.history().size(); ++i) {
+      const network::Evaluation& e = trainer.history()[i];
+      mseevo << e.step << " " << e.mse << " " << e.monitor_mse << "\n";
+      spevo << e.step << " " << e.sp << " " << e.monitor_sp << "\n";
+    }
+    if (tpar.subsample) {
+      //and every screening decision it took
+      std::string name = sys::stripname(par.traindb) + ".screen.txt";
+      RINGER_REPORT(reporter, "Saving the screening decisions of the best"
+          << " run at \"" << name << "\".");
+      sys::File screen(name, std::ios_base::trunc|std::ios_base::out);
+      screen << "epoch subsample-mse subsample-sp evaluated" << "\n";
+      for (size_t i=0; i<trainer.screening().size(); ++i) {
+        const network::Screening& s = trainer.screening()[i];
+        screen << s.quick.step << " " << s.quick.mse << " " << s.quick.sp
+          << " " << (s.evaluated? 1 : 0) << "\n";
+      }
     }
 
     //save result
@@ -368,26 +465,36 @@ int main (int argc, char** argv)
     config::Header end_header("Andre DOS ANJOS", par.output, 
         "1.0", time(0), "Trained network");
     net.save(par.endnet, &end_header);
+    if (par.runs > 1) {
+      RINGER_REPORT(reporter, "Saving the start network of the best run at"
+          << " \"" << par.startnet << "\"...");
+      net.set_weights(start[best_run]);
+      net.save(par.startnet, &net_header);
+      RINGER_REPORT(reporter, "Saving the best network of every run with"
+          << " prefix \"" << sys::stripname(par.bestnet) << "\"...");
+      runs.save(sys::stripname(par.bestnet), &end_header);
+    }
+    RINGER_REPORT(reporter, "Saving best network at \""
+        << par.bestnet << "\"...");
+    net.set_weights(trainer.best_weights());
+    net.save(par.bestnet, &end_header);
 
     RINGER_REPORT(reporter,
         "Saving training and testing outputs and targets.");
 
-    //reload the best network saved so far.
-    network::Network bestnet(par.endnet, reporter);
-    data::SimplePatternSet simple_train_output(target2.simple());
-    bestnet.run(train2.simple(), simple_train_output);
-    data::RoIPatternSet train_output(simple_train_output, train2.attributes());
-    double mse_train = data::mse(train_output, target2);
+    //use the best network seen so far.
+    data::PatternSet train_output(target);
+    net.run(train, train_output);
+    double mse_train = data::mse(train_output, target);
     double sp_train = 0;
     double train_eff1 = 0;
     double train_eff2 = 0;
     double train_thres = 0;
     if (traindb.size() == 2) 
-      sp_train = data::sp(train_output, target2, train_eff1, train_eff2, 
+      sp_train = data::sp(train_output, target, train_eff1, train_eff2, 
           train_thres);
-    data::SimplePatternSet simple_test_output(target.simple());
-    bestnet.run(test.simple(), simple_test_output);
-    data::RoIPatternSet test_output(simple_test_output, test.attributes());
+    data::PatternSet test_output(test_target);
+    net.run(test, test_output);
     double mse_test = data::mse(test_output, test_target);
     double sp_test = 0;
     double test_eff1 = 0;
@@ -397,26 +504,24 @@ int main (int argc, char** argv)
         test_eff1, test_eff2, test_thres);
 
     //energy estimations
-    data::RoIPatternSet train_energy(train_output.size(), 1);
+    data::PatternSet train_energy(train_output.size(), 1);
     data::Ensemble train_energies(train_output.size(), 0);
     data::SumExtractor add;
     for (size_t i = 0; i < train_output.size(); ++i) {
-      train_energies[i] = add(train2.pattern(i));
+      train_energies[i] = add(train.pattern(i));
     }
     train_energy.set_ensemble(0, train_energies);
-    train_energy.set_attribute(train2.attributes());
 
-    data::RoIPatternSet test_energy(test_output.size(), 1);
+    data::PatternSet test_energy(test_output.size(), 1);
     data::Ensemble test_energies(test_output.size(), 0);
     for (size_t i = 0; i < test_output.size(); ++i) {
       test_energies[i] = add(test.pattern(i));
     }
     test_energy.set_ensemble(0, test_energies);
-    test_energy.set_attribute(test.attributes());
 
-    std::map<std::string, data::RoIPatternSet*> data;
+    std::map<std::string, data::PatternSet*> data;
     data["train-output"] = &train_output;
-    data["train-target"] = &target2;
+    data["train-target"] = &target;
     data["train-energy"] = &train_energy;
     data["test-output"] = &test_output;
     data["test-target"] = &test_target;
@@ -430,7 +535,7 @@ int main (int argc, char** argv)
     comment << ".";
     data::Header header("Andre DOS ANJOS", par.output, "1.0", time(0),
         comment.str());
-    data::Database<data::RoIPatternSet> output_db(&header, data, reporter);
+    data::Database output_db(&header, data, reporter);
     output_db.save(par.output);
     RINGER_REPORT(reporter, "Network output saved to \"" << par.output
         << "\".");
@@ -452,6 +557,9 @@ int main (int argc, char** argv)
           << " eff=" << test_eff1*100 << "% and " << cnames[1]
           << " eff=" << test_eff2*100 << "%.");
     }
+    for (size_t i=0; i<nets.size(); ++i) delete nets[i];
+    for (std::map<std::string, data::Pattern*>::iterator it =
+        targets.begin(); it != targets.end(); ++it) delete it->second;
   }
   catch (const sys::Exception& ex) {
     RINGER_EXCEPT(reporter, ex.what());
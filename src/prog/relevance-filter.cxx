@@ -11,7 +11,6 @@
  * removing their less relevant ensembles and saving a new database.
  */
 
-#include "data/RoIPatternSet.h"
 #include "data/Database.h"
 #include "sys/Reporter.h"
 #include "sys/Exception.h"
@@ -213,43 +212,38 @@ int main (int argc, char** argv)
     }
        
     //loads the DB
-    data::Database<data::RoIPatternSet> db(par.db, reporter);
+    data::Database db(par.db, reporter);
     
-    if (db.data("electron")->pattern_size() != relevance.size()) {
+    if (db.pattern_size() != relevance.size()) {
       RINGER_FATAL(reporter, "The number of relevance entries in " 
 		   << par.relevance << " (" << relevance.size() 
 		   << ") differs from the " << " database pattern size (" 
-		   << db.data("electron")->pattern_size() << "). Aborting.");
+		   << db.pattern_size() << "). Aborting.");
     }
 
     RINGER_REPORT(reporter, "Cutting on " << relevance.size()
 		  << " ensembles.");
 
-    //backwards, because when I remove ensembles, they cease to exist, and
-    //that will, potentially, create an exception of "unexisting" ensemble.
-    for (std::map<unsigned int, double>::reverse_iterator
-	   it = relevance.rbegin(); it != relevance.rend(); ++it) {
-      RINGER_REPORT(reporter, "Processing ensemble `" << it->first
-		    << "'.");
-      const std::map<std::string, data::RoIPatternSet*>& data = db.data();
-      //@warning: this is a hack
-      std::map<std::string, data::RoIPatternSet*>* change = 
-	const_cast<std::map<std::string, data::RoIPatternSet*>*>(&data);
-      for (std::map<std::string, data::RoIPatternSet*>::iterator
-	     jt = change->begin(); jt != change->end(); ++jt) {
-	if (it->second < par.thres && !par.reverse) { //cut
-	  RINGER_DEBUG1("Removing ensemble `" << it->first << "'.");
-	  jt->second->erase_ensemble(it->first);
-	}
-	else if (it->second >= par.thres && par.reverse) { //cut
-	  RINGER_DEBUG1("Removing ensemble `" << it->first << "'.");
-	  jt->second->erase_ensemble(it->first);
-	}
+    //marks the ensembles to keep, then compacts all classes in one pass
+    std::vector<bool> keep(db.pattern_size(), true);
+    for (std::map<unsigned int, double>::const_iterator
+	   it = relevance.begin(); it != relevance.end(); ++it) {
+      if (it->first >= keep.size()) {
+	RINGER_FATAL(reporter, "Ensemble `" << it->first << "' in "
+		     << par.relevance << " does not exist in the database."
+		     << " Aborting.");
+      }
+      bool cut = par.reverse? (it->second >= par.thres) :
+	(it->second < par.thres);
+      if (cut) {
+	RINGER_DEBUG1("Removing ensemble `" << it->first << "'.");
+	keep[it->first] = false;
       }
     }
+    db.filter_ensembles(keep);
 
     RINGER_REPORT(reporter, "The resulting ensemble size after cutting is " 
-		  << db.data("electron")->pattern_size() << ".");
+		  << db.pattern_size() << ".");
     //save db
     db.save(par.output);
     RINGER_REPORT(reporter, "Saved new database with name " << par.output
@@ -7,7 +7,9 @@
  * $Revision$
  * $Date$
  *
- * Splits a database in two, according to the proportions given
+ * Splits a database in two, according to the proportions given. Every class
+ * is split by the same proportion, either in order or, if a seed is given,
+ * at random.
  */
 
 #include "sys/Reporter.h"
@@ -16,6 +18,7 @@
 #include "sys/util.h"
 #include "sys/OptParser.h"
 #include "data/Database.h"
+#include "data/RandomInteger.h"
 #include "data/SumExtractor.h"
 #include <iostream>
 #include <cstdio>
@@ -28,6 +31,7 @@ typedef struct param_t {
   std::string out2; ///< second output database
   double percentage; ///< the splitting percentage
   double energy_cut; ///< at which eT to cut
+  long int seed; ///< if not zero, split at random with this seed
 } param_t;
 
 /**
@@ -69,7 +73,7 @@ int main (int argc, char** argv)
 {
   sys::Reporter reporter("local");
 
-  param_t par = { "", "", "", 0.5, 170000 };
+  param_t par = { "", "", "", 0.5, 170000, 0 };
   sys::OptParser opt_parser(argv[0]);
 
   opt_parser.add_option
@@ -81,6 +85,9 @@ int main (int argc, char** argv)
   opt_parser.add_option
     ("db", 'd', par.db,
      "location of the database to use for the operation");
+  opt_parser.add_option
+    ("seed", 'S', par.seed,
+     "split every class at random, with this seed (0: split in order)");
   opt_parser.add_option
     ("out1", 't', par.out1, "name of the first output file");
   opt_parser.add_option
@@ -97,28 +104,28 @@ int main (int argc, char** argv)
   }
 
   //loads the DB
-  data::Database<data::SimplePatternSet> db(par.db, reporter);
+  data::Database db(par.db, reporter);
 
-  //execute the cutting operation
-  for (std::map<std::string, data::SimplePatternSet*>::const_iterator
-         it = db.data().begin(); it != db.data().end(); ++it) {
-    for (size_t i = 0; i < it->second->size();) {
-      data::SumExtractor sum;
-      if ( sum(it->second->pattern(i)) > par.energy_cut ) {
-        RINGER_REPORT(reporter, "Erasing pattern " << i << " from " 
-                      << it->first << " set.");
-        const_cast<data::SimplePatternSet*>(it->second)->erase_pattern(i);
-      }
-      else ++i;
-    }
-  }
+  //execute the cutting operation: keeps events up to the energy threshold,
+  //testing every class in one pass and compacting it in another
+  std::map<std::string, size_t> before;
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+         it = db.data().begin(); it != db.data().end(); ++it)
+    before[it->first] = it->second->size();
+  db.filter(data::SumExtractor(), -HUGE_VAL, par.energy_cut);
+  for (std::map<std::string, data::PatternSet*>::const_iterator
+         it = db.data().begin(); it != db.data().end(); ++it)
+    RINGER_REPORT(reporter, "Erased " << before[it->first] - it->second->size()
+                  << " patterns from " << it->first << " set.");
 
-  //splits the database in train and test
-  data::Database<data::SimplePatternSet>* traindb;
-  data::Database<data::SimplePatternSet>* testdb;
+  //splits the database in train and test, as views of the loaded one, so
+  //patterns are only copied out when saved
+  data::Database* traindb;
+  data::Database* testdb;
   std::vector<std::string> cnames;
   db.class_names(cnames);
-  db.split(par.percentage, traindb, testdb);
+  data::RandomInteger rnd(par.seed);
+  db.split(par.percentage, traindb, testdb, par.seed? &rnd : 0);
   RINGER_REPORT(reporter, "Train set size is " << traindb->size());
   RINGER_REPORT(reporter, "Test set size is " << testdb->size());
 
@@ -14,8 +14,9 @@ import data
 import config
 import network
 import error
+import runner
 
 pysys.setdlopenflags(default_flags)
 del default_flags
 
-__all__ = ['sys', 'data', 'config', 'network', 'error']
+__all__ = ['sys', 'data', 'config', 'network', 'error', 'runner']
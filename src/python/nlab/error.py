@@ -63,7 +63,12 @@ class Observer(object):
       #print '[%d] Saving current network, MSE = %.4e < %.4e' % \
       #  (step, result['devel'], self.lowest_mse[1])
       self.lowest_mse = (step, result['devel'])
-      self.best_classifier_seen = (step, self.classifier.clone())
+      if hasattr(self, 'best_classifier_seen'):
+        best = self.best_classifier_seen[1]
+        best.copy(self.classifier)
+      else:
+        best = self.classifier.clone()
+      self.best_classifier_seen = (step, best)
     
     self.mse.append(result)
 
@@ -0,0 +1,176 @@
+#!/usr/bin/env python
+# vim: set fileencoding=utf-8 :
+
+"""Runs batches of shell jobs on the local machine, without a queue system.
+
+Jobs are shell scripts, such as the ones our SGE launchers hand to qsub
+(lines starting with '#$' are plain comments for the shell). They are
+executed by a bounded pool of workers, each pinned to its own set of cores.
+The output of every job goes to its own log file and failed jobs are retried
+a given number of times.
+"""
+
+__all__ = ['Job', 'LocalRunner']
+
+import os, sys, time, subprocess, threading
+
+try:
+  import Queue as queue
+except ImportError:
+  import queue
+
+class Job(object):
+  """A shell script to be run by a LocalRunner."""
+
+  def __init__(self, name, script, cwd=None):
+    """Creates a new job.
+
+    name -- a unique name, used for the log file and for reporting
+    script -- the shell script to run (with /bin/bash)
+    cwd -- where to start the script (defaults to the current directory)
+    """
+    self.name = name
+    self.script = script
+    self.cwd = cwd
+    self.returncode = None
+    self.attempts = 0
+    self.log = None
+
+  def ok(self):
+    """Tells if the last attempt of this job succeeded."""
+    return self.returncode == 0
+
+def available_cores():
+  """Returns the cores this process may run on."""
+  if hasattr(os, 'sched_getaffinity'): return sorted(os.sched_getaffinity(0))
+  import multiprocessing
+  return range(multiprocessing.cpu_count())
+
+def _which(program):
+  """Returns the full path to an executable in the PATH, or None."""
+  for d in os.environ.get('PATH', '').split(os.pathsep):
+    path = os.path.join(d, program)
+    if os.path.isfile(path) and os.access(path, os.X_OK): return path
+  return None
+
+class LocalRunner(object):
+  """Runs jobs on a bounded pool of local workers.
+
+  Every worker owns a fixed set of cores, assigned round-robin from the
+  available ones, and its jobs are pinned to them (through taskset or, if it
+  is not installed, sched_setaffinity() on the job right after it starts).
+  Pinning keeps jobs from migrating between cores and from competing for the
+  same ones, so the timing of concurrent trainings is reproducible.
+  """
+
+  def __init__(self, workers=0, retries=0, logdir=os.curdir, pin=True,
+      verbose=True):
+    """Prepares the runner.
+
+    workers -- how many jobs to run at once (0 means one per available core)
+    retries -- how many more times to run a job that fails
+    logdir -- where to write the log files, <logdir>/<job name>.log
+    pin -- pin the jobs of every worker to its own cores
+    verbose -- report job starts and ends on stdout
+    """
+    cores = list(available_cores())
+    if workers <= 0: workers = len(cores)
+    self.workers = workers
+    self.retries = retries
+    self.logdir = logdir
+    self.verbose = verbose
+    self.cores = [cores[w::workers] for w in range(workers)]
+    if len(cores) < workers: #more workers than cores: share them
+      self.cores = [[cores[w % len(cores)]] for w in range(workers)]
+    self.taskset = None
+    if pin: self.taskset = _which('taskset')
+    self.pin = pin and (hasattr(os, 'sched_setaffinity') or
+        self.taskset is not None)
+    self.lock = threading.Lock()
+
+  def report(self, message):
+    """Writes a message on stdout, if I'm verbose."""
+    if not self.verbose: return
+    self.lock.acquire()
+    try:
+      sys.stdout.write('[%s] %s\n' % (time.strftime('%H:%M:%S'), message))
+      sys.stdout.flush()
+    finally:
+      self.lock.release()
+
+  def command(self, job, cores):
+    """Returns the command line that runs a job pinned to the given cores."""
+    cmd = ['/bin/bash', '-c', job.script]
+    if self.pin and self.taskset:
+      cmd = [self.taskset, '-c', ','.join([str(k) for k in cores])] + cmd
+    return cmd
+
+  def attempt(self, job, cores):
+    """Runs a job once, appending its output to its log file."""
+    job.attempts += 1
+    log = open(job.log, 'a')
+    try:
+      log.write('# attempt %d, started %s on cores %s\n' % (job.attempts,
+        time.strftime('%Y.%m.%d-%H:%M:%S'), ','.join([str(k) for k in cores])))
+      log.flush()
+      devnull = open(os.devnull)
+      try:
+        p = subprocess.Popen(self.command(job, cores), cwd=job.cwd,
+            stdin=devnull, stdout=log, stderr=subprocess.STDOUT)
+      finally:
+        devnull.close()
+      #no preexec_fn, it is not safe to use it from threads
+      if self.pin and not self.taskset:
+        try: os.sched_setaffinity(p.pid, cores)
+        except OSError: pass #the job is over already
+      job.returncode = p.wait()
+      log.write('# attempt %d, finished %s with exit code %d\n' % \
+          (job.attempts, time.strftime('%Y.%m.%d-%H:%M:%S'), job.returncode))
+    finally:
+      log.close()
+
+  def work(self, worker, pending):
+    """The body of every worker thread."""
+    cores = self.cores[worker]
+    while True:
+      try:
+        job = pending.get_nowait()
+      except queue.Empty:
+        return
+      while True:
+        self.report('%s: starting (worker %d, attempt %d)' % \
+            (job.name, worker, job.attempts + 1))
+        try:
+          self.attempt(job, cores)
+        except OSError as e:
+          job.returncode = -1
+          self.report('%s: cannot be started (%s)' % (job.name, e))
+        if job.ok():
+          self.report('%s: OK' % job.name)
+          break
+        if job.attempts > self.retries:
+          self.report('%s: failed with exit code %d, giving up' % \
+              (job.name, job.returncode))
+          break
+        self.report('%s: failed with exit code %d, retrying' % \
+            (job.name, job.returncode))
+
+  def run(self, jobs):
+    """Runs all jobs, in order, and waits for them to finish.
+
+    Returns the number of jobs that failed, even after retries.
+    """
+    if not os.path.exists(self.logdir): os.makedirs(self.logdir)
+    pending = queue.Queue()
+    for job in jobs:
+      job.log = os.path.join(self.logdir, job.name + '.log')
+      job.attempts = 0
+      job.returncode = None
+      pending.put(job)
+    threads = []
+    for w in range(min(self.workers, len(jobs))):
+      t = threading.Thread(target=self.work, args=(w, pending))
+      t.start()
+      threads.append(t)
+    for t in threads: t.join()
+    return len([j for j in jobs if not j.ok()])
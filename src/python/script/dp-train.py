@@ -0,0 +1,185 @@
+#!/usr/bin/env python
+# vim: set fileencoding=utf-8 :
+
+"""Trains an MLP neural net (RProp technique) using Neural Lab, with several
+data-parallel worker processes on the same machine. Each worker owns a shard
+of the training database and computes the error derivatives of the current
+network on it. Derivatives are averaged through shared memory before every
+RProp update, so all workers hold the same network at all times. Worker 0
+evaluates the network, decides when to stop and analyzes the performance of
+the best network on the given data sets, like rprop-train.py does.
+
+If no --rank is given, this program is a launcher: it starts --workers copies
+of itself, one per rank, and waits for all of them.
+"""
+
+import os, sys, time, subprocess
+import nlab
+
+def get_options():
+  import optparse
+
+  parser = optparse.OptionParser(description=__doc__)
+  parser.add_option('--train', dest="trainset", default="train.xml",
+      help="the input dataset containing the training data (defaults to %default)", metavar="FILE")
+  parser.add_option('--devel', dest="develset", default="devel.xml",
+      help="the input dataset containing the development data (defaults to %default)", metavar="FILE")
+  parser.add_option('--test', dest="testset", default="test.xml",
+      help="the input dataset containing the final test data (defaults to %default)", metavar="FILE")
+  parser.add_option('--hidden', dest="nhidden", default=5,
+      help="number of neurons on the MLP hidden layer (defaults to %default)", metavar="INT")
+  parser.add_option('--batch-size', dest="batch_size", default=20,
+      help="how many patterns each worker picks in each class for a single train step (defaults to %default)", metavar="INT")
+  parser.add_option('--epoch-size', dest="epoch_size", default=100,
+      help="How many training steps to wait until sample network performance (defaults to %default)", metavar="INT")
+  parser.add_option('--stop-after', dest="stop", default=20000,
+      help="how many training steps should go by w/o improvements to the classification, before I stop training (defaults to %default)", metavar="INT")
+  parser.add_option('--weight-update', dest="weight_update", default=0.1,
+      help="The weight update constant for the R-Prop algorithm (defaults to %default)", metavar="FLOAT")
+  parser.add_option('--workers', dest="workers", default=2,
+      help="how many worker processes to use (defaults to %default)", metavar="INT")
+  parser.add_option('--rank', dest="rank", default=None,
+      help="the rank of this worker; if unset, I launch all workers", metavar="INT")
+  parser.add_option('--group', dest="group", default=None,
+      help="the name of the reduction group; set by the launcher", metavar="NAME")
+  parser.add_option('--verbose', dest="verbose", default=False,
+      action='store_true', help="Turn on some debugging messages")
+
+  options, args = parser.parse_args()
+
+  if len(args) != 0:
+    parser.error("this program does not accept positional arguments")
+
+  #some tweaking
+  options.nhidden = int(options.nhidden)
+  options.batch_size = int(options.batch_size)
+  options.epoch_size = int(options.epoch_size)
+  options.stop = int(options.stop)
+  options.weight_update = float(options.weight_update)
+  options.workers = int(options.workers)
+  if options.workers < 1:
+    parser.error("the number of workers must be at least 1")
+  if options.rank is not None:
+    options.rank = int(options.rank)
+    if options.group is None:
+      parser.error("workers need the name of their reduction group")
+
+  return options
+
+def launch(options):
+  """Starts all workers and waits for them. Returns the number of failed
+  workers."""
+
+  group = 'nlab-dp-%d' % os.getpid()
+  procs = []
+  for rank in range(options.workers):
+    cmd = [sys.executable, os.path.realpath(__file__)] + sys.argv[1:] + \
+        ['--rank=%d' % rank, '--group=%s' % group]
+    procs.append(subprocess.Popen(cmd))
+
+  failed = 0
+  for rank, p in enumerate(procs):
+    if p.wait() != 0:
+      print 'Worker %d failed with status %d' % (rank, p.returncode)
+      failed += 1
+  return failed
+
+def shard(db, rank, workers):
+  """Keeps, in place, only the entries of each class that belong to the
+  given rank. Entries are not copied. Returns the database."""
+
+  for k in db.data.keys():
+    db.data[k] = db.data[k][rank::workers]
+  return db
+
+def work(options):
+  reporter = nlab.sys.Reporter()
+  rank = options.rank
+  start = '%s.start.xml' % options.group
+
+  #some hard-coded targets
+  targets = {'Real-access': (+1,), 'Attack': (-1,)}
+
+  #loads the DBs, keeping only my share of the training data. Worker 0 also
+  #normalises and evaluates on the whole training set, so it keeps it too:
+  #its shard shares the entries of the whole set
+  train = nlab.data.Database(options.trainset)
+  train.set_target(targets)
+  if rank == 0:
+    myshard = shard(nlab.data.Database(train), rank, options.workers)
+  else:
+    myshard = shard(train, rank, options.workers)
+    del train
+
+  if rank == 0:
+    devel = nlab.data.Database(options.develset)
+    devel.set_target(targets)
+    test  = nlab.data.Database(options.testset)
+    test.set_target(targets)
+
+    #calculates the normalization factor over the whole training set
+    mean, stddev = [nlab.data.Pattern(k) for k in nlab.data.extractors.standard(train)]
+
+    #creates the network and shares it before anybody can join
+    actfun = nlab.config.NeuronBackProp.ActivationFunction.TANH
+    net = nlab.network.MLP(train.pattern_size(), [options.nhidden],
+        1, [True, True],
+        nlab.config.NeuronStrategyType.NEURON_BACKPROP, #hidden layer
+        nlab.config.NeuronBackProp(actfun),
+        nlab.config.NeuronStrategyType.NEURON_BACKPROP, #output layer
+        nlab.config.NeuronBackProp(actfun),
+        nlab.config.SynapseStrategyType.SYNAPSE_RPROP,
+        nlab.config.SynapseRProp(options.weight_update), mean, stddev, reporter)
+    net.save(start + '.tmp')
+    os.rename(start + '.tmp', start) #atomically, for the others to load
+    group = nlab.sys.AllReduce(options.group, rank, options.workers,
+        net.synapse_size + 1)
+    os.unlink(start) #everybody has joined, so it was loaded
+    observer = nlab.error.Observer(net, train, devel, test)
+
+  else:
+    #waits for the coordinator to share the start network
+    deadline = time.time() + 60
+    while not os.path.exists(start):
+      if time.time() > deadline:
+        raise RuntimeError, "Worker 0 did not share the start network"
+      time.sleep(0.1)
+    net = nlab.network.Network(start, reporter)
+    group = nlab.sys.AllReduce(options.group, rank, options.workers,
+        net.synapse_size + 1)
+
+  npats = options.batch_size * myshard.size()
+  patterns = range(npats)
+  stop = 0 #only rank 0 ever raises this, in the slot after the derivatives
+  step = 1 #current training step
+  start_time = time.time()
+
+  while True: #trains until net stabilizes
+    data, target = myshard.random_sample(options.batch_size)
+    grad = net.gradient(data, target, patterns) + [stop]
+    grad = group.sum(grad)
+    if grad[-1] > 0: break
+    net.update([k/options.workers for k in grad[:-1]])
+    if rank == 0 and not step % options.epoch_size:
+      observer.evaluate(step)
+      if options.verbose:
+        print observer.statistics(step), '(%.1f steps/s)' % \
+            (step/(time.time()-start_time))
+      if options.stop < observer.stalled(step): stop = 1
+    step += 1
+
+  if rank != 0: return
+
+  #Finalize all statistics using the best network saved so far.
+  observer.save_best('network.xml')
+  analyzer = nlab.error.Analyzer(observer)
+  hint = os.sep.join(os.path.realpath(os.curdir).split(os.sep)[-4:-1])
+  analyzer.pdf_all('results.pdf', hint)
+  print analyzer.error()
+
+def main():
+  options = get_options()
+  if options.rank is None: sys.exit(launch(options))
+  work(options)
+
+if __name__ == '__main__': main()
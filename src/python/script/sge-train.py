@@ -3,37 +3,46 @@
 # Andre Anjos <andre.anjos@idiap.ch>
 # Mon 25 Oct 2010 02:54:15 PM CEST 
 
-"""Catapults training into SGE.
+"""Catapults training into SGE or, with --local, into the local machine.
 
-usage: sge-train.py N <dir> [+<dir>]
+usage: sge-train.py [options] N <dir> [+<dir>]
 
 N - Number of times to repeat each training.
+
+The very same job script is used in both cases. Locally, jobs run on a
+bounded pool of workers pinned to their own cores, log to
+<logdir>/<job>.log and can be retried if they fail (see nlab.runner).
 """
 
 SCRIPT = """#!/bin/bash
 #$ -N %(prog)s-%(params)s
 #$ -cwd
-basedir=/idiap/home/aanjos/work/replay/shaking
-source /idiap/home/aanjos/sw/setup.sh
-source ${basedir}/neurallab/setup.sh
+basedir=%(basedir)s
+%(setup)s
 workdir=${basedir}/%(dir)s
 cd ${workdir}
 now=$(date +'%%y.%%m.%%d-%%H:%%M:%%S')
-while [ -d ${workdir}/${now} ]; do
+until mkdir ${workdir}/${now} 2> /dev/null; do
   sleep 1
   now=$(date +'%%y.%%m.%%d-%%H:%%M:%%S')
 done
-mkdir ${workdir}/${now}
 cd ${workdir}/${now}
 %(prog)s --train=../train.xml --devel=../devel.xml --test=../test.xml >& log.out
 """
 
-import os, sys, subprocess, tempfile
+BASEDIR = '/idiap/home/aanjos/work/replay/shaking'
+SETUP = ['/idiap/home/aanjos/sw/setup.sh', '${basedir}/neurallab/setup.sh']
+
+import os, sys, subprocess, tempfile, optparse
+
+def script(directory, options):
+  return SCRIPT % {'dir': directory, 'prog': 'rprop-train.py',
+    'params': directory.replace('/', '.'), 'basedir': options.basedir,
+    'setup': '\n'.join(['source %s' % k for k in options.setup])}
 
-def sge_train(directory):
+def sge_train(directory, options):
   tmp = tempfile.TemporaryFile()
-  tmp.write(SCRIPT % {'dir': directory, 'prog': 'rprop-train.py',
-    'params': directory.replace('/', '.')}) 
+  tmp.write(script(directory, options))
   tmp.seek(0)
   cmd = ['qsub']
   p = subprocess.Popen(cmd, stdin=tmp, stdout=subprocess.PIPE,
@@ -42,13 +51,45 @@ def sge_train(directory):
   tmp.close() #also unlinks
   return not p.returncode
 
+def local_train(repeat, directories, options):
+  from nlab.runner import Job, LocalRunner
+  jobs = []
+  for N in range(repeat):
+    for k in directories:
+      jobs.append(Job('%s-%d' % (k.replace('/', '.'), N),
+        script(k, options)))
+  runner = LocalRunner(options.local, options.retries, options.logdir)
+  print 'Running %d jobs on %d local workers...' % (len(jobs), runner.workers)
+  failed = runner.run(jobs)
+  print '%d jobs done, %d failed.' % (len(jobs), failed)
+  return not failed
+
 if __name__ == '__main__':
-  if len(sys.argv) == 1:
+  parser = optparse.OptionParser(usage=__doc__.strip())
+  parser.add_option('-j', '--local', type='int', default=None,
+      metavar='WORKERS', help='run on this machine with that many workers'
+      ' (0 = one per core), instead of submitting to SGE')
+  parser.add_option('-r', '--retries', type='int', default=0,
+      help='how many more times to run a failed local job (default: %default)')
+  parser.add_option('-l', '--logdir', default='logs',
+      help='where to place the local job logs (default: %default)')
+  parser.add_option('-b', '--basedir', default=BASEDIR,
+      help='the base directory of the experiments (default: %default)')
+  parser.add_option('-s', '--setup', action='append', default=None,
+      help='an environment script to source before training; can be given'
+      ' more than once (default: %s)' % ', '.join(SETUP))
+  (options, args) = parser.parse_args()
+  if options.setup is None: options.setup = SETUP
+
+  if len(args) < 2:
     print __doc__
     sys.exit(1)
 
-  for N in range(int(sys.argv[1])):
-    for k in sys.argv[2:]:
+  if options.local is not None:
+    sys.exit(not local_train(int(args[0]), args[1:], options))
+
+  for N in range(int(args[0])):
+    for k in args[1:]:
       print 'Qsub\'ing: %s, try %d...' % (k, N),
-      if sge_train(k): print 'OK'
+      if sge_train(k, options): print 'OK'
       else: print 'Failed'
@@ -0,0 +1,29 @@
+/**
+ * @file allreduce.cc
+ *
+ * @brief Binds the shared memory all-reduce into python
+ */
+
+#include <boost/python.hpp>
+#include "sys/AllReduce.h"
+
+using namespace boost::python;
+
+list allreduce_sum(sys::AllReduce& ar, list v) {
+  std::vector<double> tmp(len(v));
+  for (size_t i=0; i<tmp.size(); ++i) tmp[i] = extract<double>(v[i]);
+  ar.sum(tmp);
+  list retval;
+  for (size_t i=0; i<tmp.size(); ++i) retval.append(tmp[i]);
+  return retval;
+}
+
+void bind_sys_allreduce()
+{
+  class_<sys::AllReduce, boost::shared_ptr<sys::AllReduce>, boost::noncopyable>("AllReduce", "Sums vectors across a group of processes on the same machine, using POSIX shared memory and Unix-domain sockets. Rank 0 coordinates the group and must be started for the others to join.", init<const std::string&, const size_t&, const size_t&, const size_t&, optional<const unsigned int&> >((arg("name"), arg("rank"), arg("size"), arg("length"), arg("timeout")), "Joins a reduction group, blocking until it is complete"))
+    .def("sum", &allreduce_sum, (arg("self"), arg("values")), "Returns the sum of the given list over all processes in the group")
+    .add_property("rank", &sys::AllReduce::rank)
+    .add_property("size", &sys::AllReduce::size)
+    .add_property("length", &sys::AllReduce::length)
+    ;
+}
@@ -10,8 +10,10 @@
 using namespace boost::python;
 
 void bind_sys_reporter();
+void bind_sys_allreduce();
 
 BOOST_PYTHON_MODULE(libpynlab_sys) {
   scope().attr("__doc__") = "Neural Lab sys classes and sub-classes";
   bind_sys_reporter();
+  bind_sys_allreduce();
 }
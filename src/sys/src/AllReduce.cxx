@@ -0,0 +1,266 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file sys/src/AllReduce.cxx
+ *
+ * Implements the shared memory all-reduce.
+ */
+
+#include "sys/AllReduce.h"
+#include "sys/Exception.h"
+#include "sys/debug.h"
+#include "sys/util.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+sys::AllReduce::AllReduce (const std::string& name, const size_t& rank,
+			   const size_t& size, const size_t& length,
+			   const unsigned int& timeout)
+  : m_shm("/" + name),
+    m_path(),
+    m_rank(rank),
+    m_size(size),
+    m_length(length),
+    m_data(0),
+    m_bytes((size+1)*length*sizeof(double)),
+    m_listen(-1),
+    m_peer(size, -1)
+{
+  if (!m_size || m_rank >= m_size || !m_length) {
+    RINGER_DEBUG1("I cannot join rank " << m_rank << " of a reduction group"
+		  << " of size " << m_size << " for vectors of length "
+		  << m_length << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Invalid all-reduce group parameters");
+  }
+  std::string tmpdir = sys::getenv("TMPDIR");
+  if (!tmpdir.length()) tmpdir = "/tmp";
+  m_path = tmpdir + "/" + name + ".sock";
+  if (m_path.length() >= sizeof(((struct sockaddr_un*)0)->sun_path)) {
+    RINGER_DEBUG1("The socket path \"" << m_path << "\" is too long."
+		  << " Exception thrown.");
+    throw RINGER_EXCEPTION("All-reduce socket path is too long");
+  }
+  if (m_size == 1) return; //nothing to share
+  try {
+    if (m_rank == 0) coordinate();
+    else join(timeout);
+  }
+  catch (...) {
+    release();
+    throw;
+  }
+  RINGER_DEBUG2("Rank " << m_rank << " joined reduction group \"" << name
+		<< "\" with " << m_size << " processes.");
+}
+
+sys::AllReduce::~AllReduce ()
+{
+  release();
+}
+
+void sys::AllReduce::coordinate (void)
+{
+  //removes leftovers from crashed runs, then creates the segment
+  shm_unlink(m_shm.c_str());
+  int fd = shm_open(m_shm.c_str(), O_CREAT|O_EXCL|O_RDWR, 0600);
+  if (fd < 0) {
+    RINGER_DEBUG1("Cannot create shared memory segment \"" << m_shm
+		  << "\": " << std::strerror(errno) << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot create shared memory");
+  }
+  if (ftruncate(fd, m_bytes) < 0) {
+    close(fd);
+    shm_unlink(m_shm.c_str());
+    RINGER_DEBUG1("Cannot size shared memory segment \"" << m_shm
+		  << "\": " << std::strerror(errno) << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot size shared memory");
+  }
+  void* addr = mmap(0, m_bytes, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    shm_unlink(m_shm.c_str());
+    RINGER_DEBUG1("Cannot map shared memory segment \"" << m_shm
+		  << "\": " << std::strerror(errno) << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot map shared memory");
+  }
+  m_data = static_cast<double*>(addr);
+
+  //the segment exists before anyone can connect
+  m_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (m_listen < 0) {
+    RINGER_DEBUG1("Cannot create socket: " << std::strerror(errno)
+		  << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot create socket");
+  }
+  struct sockaddr_un addr_un;
+  std::memset(&addr_un, 0, sizeof(addr_un));
+  addr_un.sun_family = AF_UNIX;
+  std::strcpy(addr_un.sun_path, m_path.c_str());
+  unlink(m_path.c_str());
+  if (bind(m_listen, (struct sockaddr*)&addr_un, sizeof(addr_un)) < 0 ||
+      listen(m_listen, m_size) < 0) {
+    RINGER_DEBUG1("Cannot listen at \"" << m_path << "\": "
+		  << std::strerror(errno) << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot listen on socket");
+  }
+
+  for (size_t i=1; i<m_size; ++i) {
+    int fd = accept(m_listen, 0, 0);
+    if (fd < 0) {
+      RINGER_DEBUG1("Cannot accept connections at \"" << m_path << "\": "
+		    << std::strerror(errno) << ". Exception thrown.");
+      throw RINGER_EXCEPTION("Cannot accept connection");
+    }
+    unsigned int rank = 0;
+    try {
+      receive(fd, &rank, sizeof(rank));
+    }
+    catch (...) {
+      close(fd);
+      throw;
+    }
+    if (rank == 0 || rank >= m_size || m_peer[rank] >= 0) {
+      close(fd);
+      RINGER_DEBUG1("Process connected with invalid or duplicate rank "
+		    << rank << ". Exception thrown.");
+      throw RINGER_EXCEPTION("Invalid rank connected");
+    }
+    m_peer[rank] = fd;
+    RINGER_DEBUG3("Rank " << rank << " connected.");
+  }
+}
+
+void sys::AllReduce::join (const unsigned int& timeout)
+{
+  struct sockaddr_un addr_un;
+  std::memset(&addr_un, 0, sizeof(addr_un));
+  addr_un.sun_family = AF_UNIX;
+  std::strcpy(addr_un.sun_path, m_path.c_str());
+  double deadline = sys::wallclock() + timeout;
+  while (true) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      RINGER_DEBUG1("Cannot create socket: " << std::strerror(errno)
+		    << ". Exception thrown.");
+      throw RINGER_EXCEPTION("Cannot create socket");
+    }
+    if (connect(fd, (struct sockaddr*)&addr_un, sizeof(addr_un)) == 0) {
+      m_peer[0] = fd;
+      break;
+    }
+    close(fd);
+    if (sys::wallclock() > deadline) {
+      RINGER_DEBUG1("Coordinator did not show up at \"" << m_path
+		    << "\" after " << timeout << " seconds. Exception thrown.");
+      throw RINGER_EXCEPTION("Timeout waiting for all-reduce coordinator");
+    }
+    usleep(100000);
+  }
+  unsigned int rank = m_rank;
+  send(m_peer[0], &rank, sizeof(rank));
+
+  int fd = shm_open(m_shm.c_str(), O_RDWR, 0600);
+  if (fd < 0) {
+    RINGER_DEBUG1("Cannot open shared memory segment \"" << m_shm
+		  << "\": " << std::strerror(errno) << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot open shared memory");
+  }
+  void* addr = mmap(0, m_bytes, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    RINGER_DEBUG1("Cannot map shared memory segment \"" << m_shm
+		  << "\": " << std::strerror(errno) << ". Exception thrown.");
+    throw RINGER_EXCEPTION("Cannot map shared memory");
+  }
+  m_data = static_cast<double*>(addr);
+}
+
+void sys::AllReduce::release (void)
+{
+  for (size_t i=0; i<m_peer.size(); ++i) {
+    if (m_peer[i] >= 0) close(m_peer[i]);
+    m_peer[i] = -1;
+  }
+  if (m_listen >= 0) {
+    close(m_listen);
+    m_listen = -1;
+    unlink(m_path.c_str());
+  }
+  if (m_data) {
+    munmap(m_data, m_bytes);
+    m_data = 0;
+    if (m_rank == 0) shm_unlink(m_shm.c_str());
+  }
+}
+
+void sys::AllReduce::send (int fd, const void* buf, size_t n)
+{
+  const char* p = static_cast<const char*>(buf);
+  while (n) {
+    ssize_t done = ::write(fd, p, n);
+    if (done < 0 && errno == EINTR) continue;
+    if (done <= 0) {
+      RINGER_DEBUG1("Cannot write to all-reduce peer: "
+		    << std::strerror(errno) << ". Exception thrown.");
+      throw RINGER_EXCEPTION("All-reduce peer write failed");
+    }
+    p += done;
+    n -= done;
+  }
+}
+
+void sys::AllReduce::receive (int fd, void* buf, size_t n)
+{
+  char* p = static_cast<char*>(buf);
+  while (n) {
+    ssize_t done = ::read(fd, p, n);
+    if (done < 0 && errno == EINTR) continue;
+    if (done <= 0) {
+      RINGER_DEBUG1("Cannot read from all-reduce peer (did it exit?)."
+		    << " Exception thrown.");
+      throw RINGER_EXCEPTION("All-reduce peer read failed");
+    }
+    p += done;
+    n -= done;
+  }
+}
+
+void sys::AllReduce::sum (std::vector<double>& v)
+{
+  if (v.size() != m_length) {
+    RINGER_DEBUG1("I can only reduce vectors of length " << m_length
+		  << ", not " << v.size() << ". Exception thrown.");
+    throw RINGER_EXCEPTION("All-reduce vector length mismatch");
+  }
+  if (m_size == 1) return;
+  double* result = m_data + m_size*m_length;
+  std::copy(v.begin(), v.end(), m_data + m_rank*m_length);
+  __sync_synchronize();
+  char token = 'r';
+  if (m_rank != 0) {
+    send(m_peer[0], &token, 1);
+    receive(m_peer[0], &token, 1);
+    __sync_synchronize();
+    std::copy(result, result + m_length, v.begin());
+    return;
+  }
+  for (size_t r=1; r<m_size; ++r) receive(m_peer[r], &token, 1);
+  __sync_synchronize();
+  std::fill(result, result + m_length, 0.0);
+  for (size_t r=0; r<m_size; ++r) {
+    const double* slot = m_data + r*m_length;
+    for (size_t i=0; i<m_length; ++i) result[i] += slot[i];
+  }
+  __sync_synchronize();
+  std::copy(result, result + m_length, v.begin());
+  token = 'g';
+  for (size_t r=1; r<m_size; ++r) send(m_peer[r], &token, 1);
+}
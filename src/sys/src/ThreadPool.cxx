@@ -0,0 +1,89 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file sys/src/ThreadPool.cxx
+ *
+ * Implements the pool of worker threads.
+ */
+
+#include "sys/ThreadPool.h"
+#include "sys/Exception.h"
+#include "sys/debug.h"
+
+#include <boost/bind.hpp>
+
+sys::ThreadPool::ThreadPool (const size_t& threads)
+  : m_size(threads),
+    m_task(),
+    m_busy(0),
+    m_failed(0),
+    m_stop(false),
+    m_mutex(),
+    m_cond(),
+    m_group()
+{
+  if (!m_size) m_size = boost::thread::hardware_concurrency();
+  if (!m_size) m_size = 1;
+  for (size_t i=0; i<m_size; ++i)
+    m_group.create_thread(boost::bind(&sys::ThreadPool::work, this));
+  RINGER_DEBUG2("Started a pool of " << m_size << " threads.");
+}
+
+sys::ThreadPool::~ThreadPool ()
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  m_group.join_all();
+}
+
+void sys::ThreadPool::submit (const boost::function<void ()>& task)
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_task.push_back(task);
+  }
+  m_cond.notify_all();
+}
+
+void sys::ThreadPool::wait (void)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (!m_task.empty() || m_busy) m_cond.wait(lock);
+  if (m_failed) {
+    RINGER_DEBUG1(m_failed << " task(s) failed in the thread pool."
+		  << " Exception thrown.");
+    m_failed = 0;
+    throw RINGER_EXCEPTION("Thread pool task failed");
+  }
+}
+
+void sys::ThreadPool::work (void)
+{
+  while (true) {
+    boost::function<void ()> task;
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (!m_stop && m_task.empty()) m_cond.wait(lock);
+      if (m_task.empty()) return; //stopped and nothing left to do
+      task.swap(m_task.front());
+      m_task.pop_front();
+      ++m_busy;
+    }
+    bool ok = true;
+    try {
+      task();
+    }
+    catch (...) {
+      ok = false;
+    }
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      --m_busy;
+      if (!ok) ++m_failed;
+    }
+    m_cond.notify_all();
+  }
+}
@@ -12,6 +12,7 @@
 #include <ctime>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <cstdio>
 
@@ -97,6 +98,13 @@ std::string sys::currenttime (const std::string& format)
   return cache;
 }
 
+double sys::wallclock (void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, 0);
+  return tv.tv_sec + 1e-6*tv.tv_usec;
+}
+
 bool sys::exists (const std::string& filename)
 {
   struct stat temp;
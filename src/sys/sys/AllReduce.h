@@ -0,0 +1,145 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file sys/AllReduce.h
+ *
+ * @brief Declares a summing all-reduce for processes on the same host, based
+ * on POSIX shared memory and Unix-domain sockets.
+ */
+
+#ifndef RINGER_SYS_ALLREDUCE_H
+#define RINGER_SYS_ALLREDUCE_H
+
+#include <string>
+#include <vector>
+
+namespace sys {
+
+  /**
+   * Sums vectors of doubles across a group of cooperating processes running
+   * on the same machine, leaving the total in every one of them.
+   *
+   * The group is made of <code>size</code> processes, each one identified by
+   * its <code>rank</code>. Rank 0 coordinates: it creates a shared memory
+   * segment, with one slot per process plus one for the result, and listens
+   * on a Unix-domain socket to which all other ranks connect. Every rank
+   * writes its vector into its own slot and notifies the coordinator through
+   * the socket. The coordinator sums all slots into the result slot and
+   * notifies the other ranks back, which then read the result. Only a single
+   * byte crosses the sockets for each reduction, all data goes through
+   * shared memory.
+   *
+   * All ranks must call sum() the same number of times, with vectors of the
+   * same length. No MPI installation is required.
+   */
+  class AllReduce {
+
+  public: //interface
+
+    /**
+     * Joins a reduction group. The coordinator (rank 0) blocks until all
+     * other ranks are connected. Other ranks wait for the coordinator to show
+     * up, for at most <code>timeout</code> seconds.
+     *
+     * @param name The group name, used to name the shared memory segment
+     * and the socket (in the temporary directory). It must be the same for
+     * all ranks and unique in the machine.
+     * @param rank My rank, from 0 to <code>size-1</code>
+     * @param size How many processes make up the group
+     * @param length The length of the vectors to reduce
+     * @param timeout How long to wait for the coordinator, in seconds
+     */
+    AllReduce (const std::string& name, const size_t& rank,
+	       const size_t& size, const size_t& length,
+	       const unsigned int& timeout=60);
+
+    /**
+     * Leaves the group, releasing the shared resources. The coordinator
+     * removes the shared memory segment and the socket.
+     */
+    virtual ~AllReduce ();
+
+    /**
+     * Sums the given vector with the vectors of all other ranks, in place.
+     *
+     * @param v The vector to sum. It must have the length given at
+     * construction.
+     */
+    void sum (std::vector<double>& v);
+
+    /**
+     * Returns my rank
+     */
+    inline size_t rank (void) const { return m_rank; }
+
+    /**
+     * Returns the number of processes in the group
+     */
+    inline size_t size (void) const { return m_size; }
+
+    /**
+     * Returns the length of the vectors reduced
+     */
+    inline size_t length (void) const { return m_length; }
+
+  private: //helpers
+
+    /**
+     * Coordinator setup: creates the shared resources and waits for all
+     * other ranks to connect
+     */
+    void coordinate (void);
+
+    /**
+     * Setup for ranks other than 0: connects to the coordinator and maps the
+     * shared memory
+     *
+     * @param timeout How long to wait for the coordinator, in seconds
+     */
+    void join (const unsigned int& timeout);
+
+    /**
+     * Sends a buffer through a socket, throwing on failure
+     *
+     * @param fd The socket to use
+     * @param buf The data to send
+     * @param n How many bytes to send
+     */
+    static void send (int fd, const void* buf, size_t n);
+
+    /**
+     * Receives a buffer from a socket, throwing on failure
+     *
+     * @param fd The socket to use
+     * @param buf Where to place the data
+     * @param n How many bytes to receive
+     */
+    static void receive (int fd, void* buf, size_t n);
+
+    /**
+     * Releases all resources I hold
+     */
+    void release (void);
+
+  private: //not implemented
+
+    AllReduce (const AllReduce& other);
+    AllReduce& operator= (const AllReduce& other);
+
+  private: //representation
+
+    std::string m_shm; ///< the shared memory segment name
+    std::string m_path; ///< the socket path
+    size_t m_rank; ///< my rank
+    size_t m_size; ///< the group size
+    size_t m_length; ///< the vector length
+    double* m_data; ///< the mapped shared memory
+    size_t m_bytes; ///< the size of the mapped shared memory
+    int m_listen; ///< the listening socket (coordinator only)
+    std::vector<int> m_peer; ///< connections, indexed by rank
+
+  };
+
+}
+
+#endif /* RINGER_SYS_ALLREDUCE_H */
@@ -0,0 +1,85 @@
+//Dear emacs, this is -*- c++ -*-
+
+/**
+ * @file sys/ThreadPool.h
+ *
+ * @brief Declares a fixed size pool of worker threads.
+ */
+
+#ifndef RINGER_SYS_THREADPOOL_H
+#define RINGER_SYS_THREADPOOL_H
+
+#include <deque>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+
+namespace sys {
+
+  /**
+   * Runs tasks on a fixed number of worker threads. Tasks are run in the
+   * order they are submitted, as soon as a worker is free. Exceptions
+   * thrown by tasks are caught and counted: wait() reports them.
+   */
+  class ThreadPool {
+
+  public: //interface
+
+    /**
+     * Starts the worker threads
+     *
+     * @param threads How many workers to start. If zero is given, one worker
+     * per hardware thread is started.
+     */
+    ThreadPool (const size_t& threads=0);
+
+    /**
+     * Runs all tasks still queued and stops the workers
+     */
+    virtual ~ThreadPool ();
+
+    /**
+     * Queues a task to be run by the next free worker
+     *
+     * @param task The task to run
+     */
+    void submit (const boost::function<void ()>& task);
+
+    /**
+     * Waits until all queued tasks have run. If any of them failed since
+     * the last call, an exception is thrown.
+     */
+    void wait (void);
+
+    /**
+     * Returns the number of worker threads
+     */
+    inline size_t size (void) const { return m_size; }
+
+  private: //helpers
+
+    /**
+     * The worker thread body
+     */
+    void work (void);
+
+  private: //not implemented
+
+    ThreadPool (const ThreadPool& other);
+    ThreadPool& operator= (const ThreadPool& other);
+
+  private: //representation
+
+    size_t m_size; ///< the number of workers
+    std::deque<boost::function<void ()> > m_task; ///< queued tasks
+    size_t m_busy; ///< tasks running right now
+    size_t m_failed; ///< tasks that threw since the last wait()
+    bool m_stop; ///< tells the workers to finish
+    boost::mutex m_mutex; ///< protects all of the above
+    boost::condition_variable m_cond; ///< signals queue changes
+    boost::thread_group m_group; ///< the workers
+
+  };
+
+}
+
+#endif /* RINGER_SYS_THREADPOOL_H */
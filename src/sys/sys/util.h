@@ -71,6 +71,12 @@ namespace sys {
    */
   std::string currenttime (const std::string& format);
 
+  /**
+   * Returns the current wall-clock time, in seconds since the Epoch, with
+   * microsecond resolution. Use differences of two calls to time tasks.
+   */
+  double wallclock (void);
+
   /**
    * This non-member method checks the existence of a file by name
    *